@@ -0,0 +1,140 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Arena for the memory of a level
+//
+// All memory of a level (board, bitboard, hazards, maps, food index and
+// worm) is taken from one arena. Allocation bumps an offset; memory is
+// never given back one by one. resetArena() releases everything at once
+// in time proportional to the number of blocks, and the blocks are reused
+// by the next level. Resizing grows the last allocation in place if
+// possible and copies otherwise; the old copy stays unused until the reset.
+// The arena is not thread safe; boards of simulations use the heap.
+
+#include <stdlib.h>
+#include <string.h>
+#include "worm.h"
+#include "arena.h"
+
+// All allocations are aligned like malloc
+#define ARENA_ALIGN sizeof(max_align_t)
+#define ALIGN_UP(n) (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+static char* getBlockData(struct arena_block* ablock) {
+  return (char*) ablock + ALIGN_UP(sizeof(struct arena_block));
+}
+
+void initializeArena(struct arena* anarena, size_t block_size) {
+  anarena -> first = NULL;
+  anarena -> current = NULL;
+  anarena -> block_size = block_size;
+}
+
+// Release all memory of the arena for reuse; the blocks are kept
+void resetArena(struct arena* anarena) {
+  struct arena_block* b;
+  for (b = anarena -> first; b != NULL; b = b -> next) {
+    b -> used = 0;
+    b -> last = 0;
+  }
+  anarena -> current = anarena -> first;
+}
+
+void cleanupArena(struct arena* anarena) {
+  struct arena_block* b = anarena -> first;
+  while (b != NULL) {
+    struct arena_block* next = b -> next;
+    free(b);
+    b = next;
+  }
+  anarena -> first = NULL;
+  anarena -> current = NULL;
+}
+
+void* allocMemory(struct arena* anarena, size_t size) {
+  struct arena_block* b;
+  struct arena_block* prev = NULL;
+  char* ptr;
+
+  if (anarena == NULL) {
+    return calloc(1, size > 0 ? size : 1);
+  }
+  // Every allocation takes some room, so no two share an address
+  size = ALIGN_UP(size > 0 ? size : 1);
+  // Blocks before the current one are regarded as full
+  for (b = anarena -> current; b != NULL; prev = b, b = b -> next) {
+    if (b -> size - b -> used >= size) {
+      break;
+    }
+  }
+  if (b == NULL) {
+    // Append a new block that is large enough
+    size_t bsize = size > anarena -> block_size ? size : anarena -> block_size;
+    if ((b = malloc(ALIGN_UP(sizeof(struct arena_block)) + bsize)) == NULL) {
+      return NULL;
+    }
+    b -> next = NULL;
+    b -> size = bsize;
+    b -> used = 0;
+    b -> last = 0;
+    if (prev == NULL) {
+      anarena -> first = b;
+    } else {
+      prev -> next = b;
+    }
+  }
+  // A request of ordinary size that did not fit moves on to the next block
+  if (anarena -> current == NULL || (b != anarena -> current && size <= anarena -> block_size)) {
+    anarena -> current = b;
+  }
+  ptr = getBlockData(b) + b -> used;
+  b -> last = b -> used;
+  b -> used += size;
+  memset(ptr, 0, size);
+  return ptr;
+}
+
+void* resizeMemory(struct arena* anarena, void* ptr, size_t old_size, size_t new_size) {
+  struct arena_block* b;
+  void* new_ptr;
+
+  if (anarena == NULL) {
+    new_ptr = realloc(ptr, new_size);
+    if (new_ptr != NULL && new_size > old_size) {
+      memset((char*) new_ptr + old_size, 0, new_size - old_size);
+    }
+    return new_ptr;
+  }
+  if (ptr == NULL) {
+    return allocMemory(anarena, new_size);
+  }
+  // The last allocation of its block grows in place
+  for (b = anarena -> first; b != NULL; b = b -> next) {
+    if ((char*) ptr == getBlockData(b) + b -> last && b -> used > b -> last) {
+      if (new_size > 0 && b -> last + ALIGN_UP(new_size) <= b -> size) {
+        if (new_size > old_size) {
+          memset((char*) ptr + old_size, 0, new_size - old_size);
+        }
+        b -> used = b -> last + ALIGN_UP(new_size);
+        return ptr;
+      }
+      break;
+    }
+  }
+  if ((new_ptr = allocMemory(anarena, new_size)) != NULL) {
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+  }
+  return new_ptr;
+}
+
+void freeMemory(struct arena* anarena, void* ptr) {
+  if (anarena == NULL) {
+    free(ptr);
+  }
+}
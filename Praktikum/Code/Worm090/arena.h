@@ -0,0 +1,48 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Arena for the memory of a level
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+#include "worm.h"
+
+#define ARENA_BLOCK_SIZE (1 << 20)  // Default size of a block of the arena in bytes
+
+// A block of memory handed out front to back
+struct arena_block
+{
+    struct arena_block* next;
+    size_t size;             // Usable bytes behind the header
+    size_t used;             // Bytes handed out
+    size_t last;             // Offset of the last allocation; it may grow in place
+};
+
+// A list of blocks that are kept when the arena is reset.
+// Once the largest level has been played, later levels allocate nothing.
+struct arena
+{
+    struct arena_block* first;
+    struct arena_block* current;  // Block of the next allocation
+    size_t block_size;
+};
+
+extern void initializeArena(struct arena* anarena, size_t block_size);
+extern void resetArena(struct arena* anarena);
+extern void cleanupArena(struct arena* anarena);
+
+// Zeroed memory from the arena, or from the heap if anarena is NULL.
+// freeMemory() does nothing for memory from an arena.
+extern void* allocMemory(struct arena* anarena, size_t size);
+extern void* resizeMemory(struct arena* anarena, void* ptr, size_t old_size, size_t new_size);
+extern void freeMemory(struct arena* anarena, void* ptr);
+
+#endif  // #define _ARENA_H
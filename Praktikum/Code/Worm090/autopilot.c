@@ -0,0 +1,333 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Autopilot following a Hamiltonian cycle
+//
+// The board is partitioned into blocks of 2x2 cells, aligned to the
+// bottom left corner where the worm starts. Blocks without barriers are
+// connected by a spanning tree (BFS from the start block). Walking around
+// the outline of that tree visits every cell of every tree block exactly
+// once and returns to the start: a Hamiltonian cycle over these cells.
+// Construction is linear in the number of cells.
+//
+// A worm that follows the cycle can never crash as long as its length
+// stays below the length of the cycle. While the worm is short we take
+// shortcuts towards the next food, but only to cells ahead on the cycle
+// and well before the tail. Thus the body always occupies a contiguous
+// stretch of the cycle behind the head.
+// A worm that grows without bound must not skip cells, so shortcuts
+// can be switched off.
+//
+// Food in blocks touching a barrier does not lie on the cycle and is
+// never collected.
+//
+// Hazards would break the guarantee by moving onto the cycle. The cells of
+// the cycle are therefore closed to them (keepHazardsOut()); they only
+// move in the blocks that touch a barrier.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "bitboard.h"
+#include "autopilot.h"
+#include "messages.h"
+#include "arena.h"
+#include "food_index.h"
+#include "hazards.h"
+
+// Connections of a block to its neighbours in the spanning tree
+#define CONN_UP    1
+#define CONN_DOWN  2
+#define CONN_LEFT  4
+#define CONN_RIGHT 8
+
+// Index of a cell in the array order
+static int getCellIndex(struct autopilot* apilot, struct pos position) {
+  return position.y * apilot -> ncols + position.x;
+}
+
+// Blocks are counted from the bottom row upwards
+static bool isBlockFree(struct board* aboard, int br, int bc) {
+  int y = aboard -> last_row - 2 * br;
+  int x = 2 * bc;
+  return getCellAt(aboard, y, x) != BC_BARRIER
+    && getCellAt(aboard, y, x + 1) != BC_BARRIER
+    && getCellAt(aboard, y - 1, x) != BC_BARRIER
+    && getCellAt(aboard, y - 1, x + 1) != BC_BARRIER;
+}
+
+// Successor of a cell when walking counterclockwise around the tree
+static struct pos getNextOnCycle(struct board* aboard, unsigned char* conn, int nbc,
+                                 struct pos cur) {
+  int br = (aboard -> last_row - cur.y) / 2;
+  int bc = cur.x / 2;
+  unsigned char c = conn[br * nbc + bc];
+  bool is_top = (aboard -> last_row - cur.y) % 2 == 1;
+  bool is_left = cur.x % 2 == 0;
+
+  if (is_top && is_left) {
+    if (c & CONN_LEFT) { cur.x--; } else { cur.y++; }
+  } else if (!is_top && is_left) {
+    if (c & CONN_DOWN) { cur.y++; } else { cur.x++; }
+  } else if (!is_top && !is_left) {
+    if (c & CONN_RIGHT) { cur.x++; } else { cur.y--; }
+  } else {
+    if (c & CONN_UP) { cur.y--; } else { cur.x--; }
+  }
+  return cur;
+}
+
+// Build the cycle for the current level.
+// The start position must be the bottom left corner of a 2x2 block.
+enum ResCodes initializeAutopilot(struct autopilot* apilot, struct board* aboard,
+                                  struct pos start, bool shortcuts) {
+  int nbr = (aboard -> last_row + 1) / 2;  // Number of block rows
+  int nbc = (aboard -> last_col + 1) / 2;  // Number of block columns
+  int nblocks = nbr * nbc;
+  int ncells;
+  int head, tail;
+  int tree_blocks;
+  int i;
+  int* queue;
+  unsigned char* conn;
+  bool* visited;
+  struct pos cur;
+
+  if (!hasBitboard(aboard)) {
+    showDialog("Abbruch: Spielfeld ist zu gross fuer den Autopiloten", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  apilot -> nrows = aboard -> last_row + 1;
+  apilot -> ncols = aboard -> last_col + 1;
+  ncells = apilot -> nrows * apilot -> ncols;
+  apilot -> cycle_length = 0;
+  apilot -> shortcuts = shortcuts;
+
+  apilot -> arena = aboard -> arena;
+  apilot -> order = allocMemory(apilot -> arena, ncells * sizeof(int));
+  apilot -> cycle = allocMemory(apilot -> arena, ncells * sizeof(struct pos));
+  queue = malloc(nblocks * sizeof(int));
+  conn = calloc(nblocks, sizeof(unsigned char));
+  visited = calloc(nblocks, sizeof(bool));
+  if (apilot -> order == NULL || apilot -> cycle == NULL
+      || queue == NULL || conn == NULL || visited == NULL) {
+    free(queue);
+    free(conn);
+    free(visited);
+    cleanupAutopilot(apilot);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+
+  if (nblocks == 0 || start.y != aboard -> last_row || start.x != 0 || !isBlockFree(aboard, 0, 0)) {
+    free(queue);
+    free(conn);
+    free(visited);
+    cleanupAutopilot(apilot);
+    showDialog("Autopilot: Startposition ist blockiert", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+
+  // BFS over free blocks; record the tree edges in conn
+  head = 0;
+  tail = 0;
+  queue[tail++] = 0;
+  visited[0] = true;
+  while (head < tail) {
+    int b = queue[head++];
+    int br = b / nbc;
+    int bc = b % nbc;
+    int k;
+    // Neighbours: up, down, left, right (in display orientation)
+    int nb_r[4] = { br + 1, br - 1, br, br };
+    int nb_c[4] = { bc, bc, bc - 1, bc + 1 };
+    unsigned char dir_to[4] = { CONN_UP, CONN_DOWN, CONN_LEFT, CONN_RIGHT };
+    unsigned char dir_back[4] = { CONN_DOWN, CONN_UP, CONN_RIGHT, CONN_LEFT };
+
+    for (k = 0; k < 4; k++) {
+      int nb;
+      if (nb_r[k] < 0 || nb_r[k] >= nbr || nb_c[k] < 0 || nb_c[k] >= nbc) {
+        continue;
+      }
+      nb = nb_r[k] * nbc + nb_c[k];
+      if (visited[nb] || !isBlockFree(aboard, nb_r[k], nb_c[k])) {
+        continue;
+      }
+      visited[nb] = true;
+      conn[b] |= dir_to[k];
+      conn[nb] |= dir_back[k];
+      queue[tail++] = nb;
+    }
+  }
+  tree_blocks = tail;
+
+  // Walk around the tree and number the cells
+  for (i = 0; i < ncells; i++) {
+    apilot -> order[i] = -1;
+  }
+  cur = start;
+  do {
+    apilot -> order[getCellIndex(apilot, cur)] = apilot -> cycle_length;
+    apilot -> cycle[apilot -> cycle_length++] = cur;
+    cur = getNextOnCycle(aboard, conn, nbc, cur);
+  } while ((cur.y != start.y || cur.x != start.x) && apilot -> cycle_length < ncells);
+
+  free(queue);
+  free(conn);
+  free(visited);
+
+  if (apilot -> cycle_length != 4 * tree_blocks) {
+    cleanupAutopilot(apilot);
+    showDialog("Autopilot: Interner Fehler beim Aufbau des Zyklus", "Bitte eine Taste druecken");
+    return RES_INTERNAL_ERROR;
+  }
+  // Hazards start on barrier blocks, i.e. off the cycle, and must stay off it
+  if (keepHazardsOut(aboard, apilot -> cycle, apilot -> cycle_length) != RES_OK) {
+    cleanupAutopilot(apilot);
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+void cleanupAutopilot(struct autopilot* apilot) {
+  freeMemory(apilot -> arena, apilot -> order);
+  freeMemory(apilot -> arena, apilot -> cycle);
+  apilot -> order = NULL;
+  apilot -> cycle = NULL;
+}
+
+// Distance along the cycle from the head to the nearest food item ahead
+// among the items near the head; n if there is none within the radius.
+// A step along the cycle changes the Manhattan distance by one, so an item
+// up to NEAR_FOOD_RADIUS steps ahead on the cycle is within the radius.
+// Returns -1 if the items within the radius do not fit into the buffer.
+static int getDistanceToNearFood(struct autopilot* apilot, struct board* aboard, int head_order) {
+  struct pos found[NEAR_FOOD_MAX];
+  int n = apilot -> cycle_length;
+  int best = n;
+  int nfound, i;
+
+  nfound = findFoodWithinRadius(aboard -> food_index, apilot -> cycle[head_order],
+                                NEAR_FOOD_RADIUS, FOOD_KIND_ANY, found, NEAR_FOOD_MAX);
+  if (nfound == NEAR_FOOD_MAX) {
+    return -1;
+  }
+  for (i = 0; i < nfound; i++) {
+    int ord = apilot -> order[getCellIndex(apilot, found[i])];
+    if (ord >= 0 && (ord - head_order + n) % n < best) {
+      best = (ord - head_order + n) % n;
+    }
+  }
+  return best;
+}
+
+// Distance along the cycle from the head to the nearest food item ahead.
+// If the food index finds one within NEAR_FOOD_RADIUS steps, no item further
+// away can be closer on the cycle; else all food items are scanned.
+static int getDistanceToFood(struct autopilot* apilot, struct board* aboard, int head_order) {
+  int n = apilot -> cycle_length;
+  int best = n;
+  int code, y, w;
+
+  if (aboard -> food_index != NULL) {
+    int near = getDistanceToNearFood(apilot, aboard, head_order);
+    if (near >= 0 && near <= NEAR_FOOD_RADIUS) {
+      return near;
+    }
+  }
+
+  for (code = BC_FOOD_1; code <= BC_FOOD_3; code++) {
+    for (y = 0; y <= aboard -> last_row; y++) {
+      for (w = 0; w < aboard -> words_per_row; w++) {
+        uint64_t word = aboard -> bits[code][y * aboard -> words_per_row + w];
+        while (word != 0) {
+          int x = w * BITS_PER_WORD + __builtin_ctzll(word);
+          int ord = apilot -> order[y * apilot -> ncols + x];
+          if (ord >= 0 && (ord - head_order + n) % n < best) {
+            best = (ord - head_order + n) % n;
+          }
+          word &= word - 1;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+// Compute the next heading of the worm
+enum WormHeading getAutopilotHeading(struct autopilot* apilot, struct board* aboard,
+                                     struct worm* aworm) {
+  int n = apilot -> cycle_length;
+  struct pos headpos = getWormHeadPos(aworm);
+  struct pos tailpos = getWormTailPos(aworm);
+  int head_order = apilot -> order[getCellIndex(apilot, headpos)];
+  struct pos target = apilot -> cycle[(head_order + 1) % n];
+  int target_dist = 1;
+
+  // Shortcuts only while the worm is short and its tail is known
+  if (apilot -> shortcuts
+      && getWormLength(aworm) < n / 2
+      && tailpos.y >= 0 && tailpos.y < apilot -> nrows
+      && tailpos.x >= 0 && tailpos.x < apilot -> ncols
+      && getContentAt(aboard, tailpos) == BC_USED_BY_WORM
+      && apilot -> order[getCellIndex(apilot, tailpos)] >= 0) {
+    int tail_dist = (apilot -> order[getCellIndex(apilot, tailpos)] - head_order + n) % n;
+    int food_dist = getDistanceToFood(apilot, aboard, head_order);
+    int dy[4] = { -1, 1, 0, 0 };
+    int dx[4] = { 0, 0, -1, 1 };
+    int k;
+
+    for (k = 0; k < 4; k++) {
+      struct pos cand = { headpos.y + dy[k], headpos.x + dx[k] };
+      int ord, dist;
+      enum BoardCodes content;
+
+      if (cand.y < 0 || cand.y >= apilot -> nrows || cand.x < 0 || cand.x >= apilot -> ncols) {
+        continue;
+      }
+      ord = apilot -> order[getCellIndex(apilot, cand)];
+      content = getContentAt(aboard, cand);
+      if (ord < 0 || content == BC_BARRIER || content == BC_USED_BY_WORM) {
+        continue;
+      }
+      dist = (ord - head_order + n) % n;
+      if (dist > target_dist && dist <= food_dist && dist < tail_dist - SHORTCUT_MARGIN) {
+        target = cand;
+        target_dist = dist;
+      }
+    }
+  }
+
+  if (target.y < headpos.y) {
+    return WORM_UP;
+  } else if (target.y > headpos.y) {
+    return WORM_DOWN;
+  } else if (target.x < headpos.x) {
+    return WORM_LEFT;
+  }
+  return WORM_RIGHT;
+}
+
+// Getters
+int getCycleLength(struct autopilot* apilot) {
+  return apilot -> cycle_length;
+}
+
+// Distance along the cycle to the next food item; -1 if there is no food on the cycle
+int getCycleDistanceToFood(struct autopilot* apilot, struct board* aboard,
+                           struct pos headpos) {
+  int dist = getDistanceToFood(apilot, aboard, apilot -> order[getCellIndex(apilot, headpos)]);
+  if (dist == apilot -> cycle_length) {
+    return -1;
+  }
+  return dist;
+}
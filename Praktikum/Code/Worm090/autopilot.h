@@ -0,0 +1,53 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Autopilot following a Hamiltonian cycle
+
+#ifndef _AUTOPILOT_H
+#define _AUTOPILOT_H
+
+#include <stdbool.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+
+// Minimal distance along the cycle that must remain between the head
+// and the tail after taking a shortcut. Leaves room for growing.
+#define SHORTCUT_MARGIN (2 * BONUS_3)
+
+// Food near the head is looked up in the food index of the board first
+#define NEAR_FOOD_RADIUS 32     // Manhattan distance from the head
+#define NEAR_FOOD_MAX 64        // At most this many items; more fall back to the full scan
+
+// An autopilot structure
+struct autopilot
+{
+    int nrows;          // Dimensions of the board the cycle was built for
+    int ncols;
+
+    bool shortcuts;     // May we leave the cycle towards food?
+
+    int cycle_length;   // Number of cells on the cycle
+    struct pos* cycle;  // Cells in the order of the cycle
+    int* order;         // Index into cycle for each cell (row-major); -1 if not on cycle
+    struct arena* arena;  // Memory of cycle and order: the arena of the board
+};
+
+extern enum ResCodes initializeAutopilot(struct autopilot* apilot, struct board* aboard,
+                                         struct pos start, bool shortcuts);
+extern void cleanupAutopilot(struct autopilot* apilot);
+extern enum WormHeading getAutopilotHeading(struct autopilot* apilot, struct board* aboard,
+                                            struct worm* aworm);
+
+// Getters
+extern int getCycleLength(struct autopilot* apilot);
+extern int getCycleDistanceToFood(struct autopilot* apilot, struct board* aboard,
+                                  struct pos headpos);
+
+#endif  // #define _AUTOPILOT_H
@@ -0,0 +1,270 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Bitboard view of the board
+//
+// For every code of enum BoardCodes we keep a bitset with one bit per cell.
+// Row y of a bitset occupies words_per_row consecutive 64 bit words;
+// cell (y,x) is bit (x % 64) of word (y * words_per_row + x / 64).
+// Padding bits right of last_col are always zero.
+//
+// The bitsets are maintained by placeItem() alongside the array of cells.
+// They allow for word-parallel queries like the size of the region
+// that is reachable from a given position.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "worm.h"
+#include "board_model.h"
+#include "bitboard.h"
+#include "messages.h"
+#include "arena.h"
+
+// Number of words of a complete bitset
+static int getBitsetSize(struct board* aboard) {
+  return (aboard -> last_row + 1) * aboard -> words_per_row;
+}
+
+// Allocate one bitset per board code.
+// Initially all cells of the board are free.
+enum ResCodes initializeBitboard(struct board* aboard) {
+  int code;
+  int size;
+
+  aboard -> words_per_row = (aboard -> last_col + BITS_PER_WORD) / BITS_PER_WORD;
+  if ((long) (aboard -> last_row + 1) * (aboard -> last_col + 1) > BITBOARD_MAX_CELLS) {
+    for (code = 0; code < NUMBER_OF_BOARD_CODES; code++) {
+      aboard -> bits[code] = NULL;
+    }
+    return RES_OK;
+  }
+  size = getBitsetSize(aboard);
+
+  for (code = 0; code < NUMBER_OF_BOARD_CODES; code++) {
+    aboard -> bits[code] = allocMemory(aboard -> arena, size * sizeof(uint64_t));
+    if (aboard -> bits[code] == NULL) {
+      showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+      return RES_FAILED; // No memory -> direct exit
+    }
+  }
+  clearBitboard(aboard);
+  return RES_OK;
+}
+
+// Mark all cells as free: whole words per row, padding bits stay zero
+void clearBitboard(struct board* aboard) {
+  int code;
+  int y;
+  int full_words = (aboard -> last_col + 1) / BITS_PER_WORD;
+  int rest = (aboard -> last_col + 1) % BITS_PER_WORD;
+  uint64_t* free_bits = aboard -> bits[BC_FREE_CELL];
+
+  if (!hasBitboard(aboard)) {
+    return;
+  }
+  for (code = 0; code < NUMBER_OF_BOARD_CODES; code++) {
+    if (code != BC_FREE_CELL) {
+      memset(aboard -> bits[code], 0, getBitsetSize(aboard) * sizeof(uint64_t));
+    }
+  }
+  for (y = 0; y <= aboard -> last_row; y++) {
+    uint64_t* row = free_bits + y * aboard -> words_per_row;
+    memset(row, 0xff, full_words * sizeof(uint64_t));
+    if (rest != 0) {
+      row[full_words] = ((uint64_t) 1 << rest) - 1;
+    }
+  }
+}
+
+void cleanupBitboard(struct board* aboard) {
+  int code;
+  for (code = 0; code < NUMBER_OF_BOARD_CODES; code++) {
+    freeMemory(aboard -> arena, aboard -> bits[code]);
+    aboard -> bits[code] = NULL;
+  }
+}
+
+// Move the bit of cell (y,x) from the bitset of old_code to the one of new_code
+void updateBitboard(struct board* aboard, int y, int x,
+                    enum BoardCodes old_code, enum BoardCodes new_code) {
+  int w = y * aboard -> words_per_row + x / BITS_PER_WORD;
+  uint64_t bit = (uint64_t) 1 << (x % BITS_PER_WORD);
+
+  if (aboard -> bits[old_code] == NULL) {
+    return;
+  }
+  aboard -> bits[old_code][w] &= ~bit;
+  aboard -> bits[new_code][w] |= bit;
+}
+
+// Queries
+
+// Boards with more than BITBOARD_MAX_CELLS cells have none
+bool hasBitboard(struct board* aboard) {
+  return aboard -> bits[0] != NULL;
+}
+
+bool isBitSet(struct board* aboard, enum BoardCodes board_code, struct pos position) {
+  int w = position.y * aboard -> words_per_row + position.x / BITS_PER_WORD;
+  return (aboard -> bits[board_code][w] >> (position.x % BITS_PER_WORD)) & 1;
+}
+
+int countCellsWithCode(struct board* aboard, enum BoardCodes board_code) {
+  int i;
+  int count = 0;
+  int size = getBitsetSize(aboard);
+
+  for (i = 0; i < size; i++) {
+    count += __builtin_popcountll(aboard -> bits[board_code][i]);
+  }
+  return count;
+}
+
+// Compute the cells a worm may enter: free cells and food
+void getPassableCells(struct board* aboard, uint64_t* passable) {
+  int i;
+  int size = getBitsetSize(aboard);
+
+  for (i = 0; i < size; i++) {
+    passable[i] = aboard -> bits[BC_FREE_CELL][i]
+      | aboard -> bits[BC_FOOD_1][i]
+      | aboard -> bits[BC_FOOD_2][i]
+      | aboard -> bits[BC_FOOD_3][i];
+  }
+}
+
+// Extend the bits of seed to the complete runs of mask they belong to.
+// Occluded fill in both directions; log2(64) steps each.
+static uint64_t fillRuns(uint64_t seed, uint64_t mask) {
+  uint64_t up, down;
+  uint64_t pro;
+
+  seed &= mask;
+
+  // Towards higher bits
+  up = seed;
+  pro = mask;
+  up |= pro & (up << 1);  pro &= pro << 1;
+  up |= pro & (up << 2);  pro &= pro << 2;
+  up |= pro & (up << 4);  pro &= pro << 4;
+  up |= pro & (up << 8);  pro &= pro << 8;
+  up |= pro & (up << 16); pro &= pro << 16;
+  up |= pro & (up << 32);
+
+  // Towards lower bits
+  down = seed;
+  pro = mask;
+  down |= pro & (down >> 1);  pro &= pro >> 1;
+  down |= pro & (down >> 2);  pro &= pro >> 2;
+  down |= pro & (down >> 4);  pro &= pro >> 4;
+  down |= pro & (down >> 8);  pro &= pro >> 8;
+  down |= pro & (down >> 16); pro &= pro >> 16;
+  down |= pro & (down >> 32);
+
+  return up | down;
+}
+
+// Horizontal fill of one row; runs may span several words
+static void fillRow(uint64_t* row, const uint64_t* pass, int words_per_row) {
+  int w;
+  bool changed;
+
+  for (w = 0; w < words_per_row; w++) {
+    row[w] = fillRuns(row[w], pass[w]);
+  }
+
+  // Carry across word boundaries until nothing changes
+  do {
+    changed = false;
+    for (w = 0; w < words_per_row - 1; w++) {
+      if ((row[w] >> (BITS_PER_WORD - 1)) & pass[w + 1] & ~row[w + 1] & 1) {
+        row[w + 1] = fillRuns(row[w + 1] | 1, pass[w + 1]);
+        changed = true;
+      }
+    }
+    for (w = words_per_row - 1; w > 0; w--) {
+      if (row[w] & (pass[w - 1] >> (BITS_PER_WORD - 1)) & ~(row[w - 1] >> (BITS_PER_WORD - 1)) & 1) {
+        row[w - 1] = fillRuns(row[w - 1] | ((uint64_t) 1 << (BITS_PER_WORD - 1)), pass[w - 1]);
+        changed = true;
+      }
+    }
+  } while (changed);
+}
+
+// Grow region from row y's neighbours; returns true if row y changed
+static bool expandRow(uint64_t* region, const uint64_t* passable,
+                      int y, int nrows, int words_per_row, uint64_t* tmp) {
+  int w;
+  uint64_t* row = region + y * words_per_row;
+  const uint64_t* pass = passable + y * words_per_row;
+  uint64_t any = 0;
+
+  for (w = 0; w < words_per_row; w++) {
+    tmp[w] = row[w];
+    if (y > 0) {
+      tmp[w] |= row[w - words_per_row];
+    }
+    if (y < nrows - 1) {
+      tmp[w] |= row[w + words_per_row];
+    }
+    tmp[w] &= pass[w];
+    any |= tmp[w] & ~row[w];
+  }
+  if (any == 0) {
+    return false; // No new seeds for this row
+  }
+
+  fillRow(tmp, pass, words_per_row);
+  memcpy(row, tmp, words_per_row * sizeof(uint64_t));
+  return true;
+}
+
+// Word-parallel flood fill within the cells of passable starting at start.
+// The reached cells are stored in region (same layout as the bitsets).
+// Returns the number of reached cells.
+int floodFill(struct board* aboard, const uint64_t* passable,
+              struct pos start, uint64_t* region) {
+  int y, i;
+  int nrows = aboard -> last_row + 1;
+  int words_per_row = aboard -> words_per_row;
+  int size = getBitsetSize(aboard);
+  int start_word = start.y * words_per_row + start.x / BITS_PER_WORD;
+  uint64_t start_bit = (uint64_t) 1 << (start.x % BITS_PER_WORD);
+  uint64_t tmp[words_per_row];
+  bool changed;
+  int count = 0;
+
+  memset(region, 0, size * sizeof(uint64_t));
+
+  if (start.y < 0 || start.y > aboard -> last_row ||
+      start.x < 0 || start.x > aboard -> last_col ||
+      (passable[start_word] & start_bit) == 0) {
+    return 0;
+  }
+  region[start_word] = start_bit;
+  fillRow(region + start.y * words_per_row, passable + start.y * words_per_row, words_per_row);
+
+  // Sweep down and up alternately until the region is stable
+  do {
+    changed = false;
+    for (y = 0; y < nrows; y++) {
+      changed |= expandRow(region, passable, y, nrows, words_per_row, tmp);
+    }
+    for (y = nrows - 1; y >= 0; y--) {
+      changed |= expandRow(region, passable, y, nrows, words_per_row, tmp);
+    }
+  } while (changed);
+
+  for (i = 0; i < size; i++) {
+    count += __builtin_popcountll(region[i]);
+  }
+  return count;
+}
@@ -0,0 +1,41 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Bitboard view of the board
+
+#ifndef _BITBOARD_H
+#define _BITBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "worm.h"
+#include "board_model.h"
+
+// Number of cells stored in one word of a bitset
+#define BITS_PER_WORD 64
+
+// Larger boards have no bitboard: one bitset per code would not fit in memory.
+// The queries below must not be used on them (see hasBitboard).
+#define BITBOARD_MAX_CELLS (1L << 26)
+
+extern enum ResCodes initializeBitboard(struct board* aboard);
+extern void clearBitboard(struct board* aboard);
+extern void cleanupBitboard(struct board* aboard);
+extern void updateBitboard(struct board* aboard, int y, int x,
+                           enum BoardCodes old_code, enum BoardCodes new_code);
+
+// Queries
+extern bool hasBitboard(struct board* aboard);
+extern bool isBitSet(struct board* aboard, enum BoardCodes board_code, struct pos position);
+extern int countCellsWithCode(struct board* aboard, enum BoardCodes board_code);
+extern void getPassableCells(struct board* aboard, uint64_t* passable);
+extern int floodFill(struct board* aboard, const uint64_t* passable,
+                     struct pos start, uint64_t* region);
+
+#endif  // #define _BITBOARD_H
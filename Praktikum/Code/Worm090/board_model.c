@@ -15,63 +15,264 @@
 #include "worm.h"
 #include "board_model.h"
 #include "messages.h"
+#include "bitboard.h"
+#include "minimap.h"
+#include "hazards.h"
+#include "food_index.h"
+#include "arena.h"
+#include "render.h"
 
+static enum ResCodes allocateCells(struct board *aboard);
 
 // *************************************************
 // Placing and removing items from the game board
 // Check boundaries of game board
 // *************************************************
 
-enum ResCodes initializeBoard(struct board *aboard) {
-  int y;
-  // Maximal index of arow, reserve space for message area
-  aboard->last_row = LINES - ROWS_RESERVED - 1;
-  // Maximal index of a column
-  aboard->last_col = COLS - 1;
+// Initialize a board of nrows x ncols cells that is shown on the display.
+// The board covers at least the display above the message area. A larger
+// board is shown through a viewport that follows the worm (see updateViewport).
+// All memory of the board comes from the arena.
+enum ResCodes initializeBoard(struct board *aboard, struct arena *anarena, int nrows, int ncols) {
+  // The viewport: the display without the message area
+  aboard->view_rows = LINES - ROWS_RESERVED;
+  aboard->view_cols = COLS;
+  aboard->view_top = 0;
+  aboard->view_left = 0;
+  aboard->view_covered = false;
+  aboard->minimaps = NULL;
+  aboard->hazards = NULL;
+  aboard->food_index = NULL;
+  aboard->occupancy = NULL;
+  aboard->arena = anarena;
+  // Maximal index of a row and a column
+  nrows = nrows > MIN_NUMBER_OF_ROWS ? nrows : MIN_NUMBER_OF_ROWS;
+  ncols = ncols > MIN_NUMBER_OF_COLS ? ncols : MIN_NUMBER_OF_COLS;
+  aboard->last_row = (nrows > aboard->view_rows ? nrows : aboard->view_rows) - 1;
+  aboard->last_col = (ncols > aboard->view_cols ? ncols : aboard->view_cols) - 1;
   
-  // Check dimensions of the board
-  if (aboard->last_col < MIN_NUMBER_OF_COLS -1 || aboard->last_row < MIN_NUMBER_OF_ROWS - 1) {
+  // Check dimensions of the viewport
+  if (aboard->view_cols < MIN_VIEW_COLS || aboard->view_rows < MIN_VIEW_ROWS) {
     char buf[100];
-    sprintf(buf, "Das Fenster ist zu klein: wir brauchen %dx%d", MIN_NUMBER_OF_COLS, MIN_NUMBER_OF_ROWS + ROWS_RESERVED);
+    sprintf(buf, "Das Fenster ist zu klein: wir brauchen %dx%d", MIN_VIEW_COLS, MIN_VIEW_ROWS + ROWS_RESERVED);
     showDialog(buf, "Bitte eine Taste druecken");
     return RES_FAILED;
   }
-  // Allocate memory for 2-dimensional array of cells
-  // Alloc array of rows 
- 
-  aboard->cells = (enum BoardCodes **) malloc(LINES * sizeof(enum BoardCodes *));
-  if (aboard->cells == NULL) {
+  aboard->headless = false;
+  aboard->wraps = false;
+  return allocateCells(aboard);
+}
+
+// Initialize a board that is not shown on the display.
+// Used by tools and simulations that run without curses.
+enum ResCodes initializeHeadlessBoard(struct board *aboard, int nrows, int ncols) {
+  aboard->last_row = nrows - 1;
+  aboard->last_col = ncols - 1;
+  aboard->headless = true;
+  aboard->wraps = false;
+  aboard->view_top = 0;
+  aboard->view_left = 0;
+  aboard->view_rows = 0;
+  aboard->view_cols = 0;
+  aboard->view_covered = false;
+  aboard->minimaps = NULL;
+  aboard->hazards = NULL;
+  aboard->food_index = NULL;
+  aboard->occupancy = NULL;
+  aboard->arena = NULL;
+  return allocateCells(aboard);
+}
+
+#ifdef BOARD_ROWS
+
+// Fixed-size build: the cells are part of the board
+static enum ResCodes allocateCells(struct board *aboard) {
+  if (aboard->last_row >= BOARD_ROWS || aboard->last_col >= BOARD_COLS) {
+    char buf[100];
+    sprintf(buf, "Abbruch: Spielfeld ist groesser als die feste Groesse %dx%d", BOARD_COLS, BOARD_ROWS);
+    showDialog(buf, "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  memset(aboard->cells, 0, sizeof(aboard->cells));
+  return initializeBitboard(aboard);
+}
+
+// There are no tiles; callers look at the cells themselves
+bool isTileFree(struct board *aboard, int y, int x) {
+  return false;
+}
+
+#else
+
+// The shared tile of free cells (BC_FREE_CELL is 0)
+static uint8_t free_tile[TILE_SIZE * TILE_SIZE];
+
+// Allocate the table of tiles for a board of dimensions
+// (aboard->last_row + 1) x (aboard->last_col + 1).
+// All tiles are the shared tile of free cells.
+static enum ResCodes allocateCells(struct board *aboard) {
+  int ntiles;
+  int i;
+
+  if (aboard->last_row >= MAX_BOARD_SIZE || aboard->last_col >= MAX_BOARD_SIZE) {
+    showDialog("Abbruch: Spielfeld ist zu gross", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  aboard->tiles_per_row = (aboard->last_col + TILE_SIZE) >> TILE_SHIFT;
+  ntiles = ((aboard->last_row + TILE_SIZE) >> TILE_SHIFT) * aboard->tiles_per_row;
+  aboard->tiles = (uint8_t **) allocMemory(aboard->arena, ntiles * sizeof(uint8_t *));
+  if (aboard->tiles == NULL) {
     showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
     return RES_FAILED; // No memory -> direct exit
   }
-   for (y = 0; y <= aboard->last_row; y++) {
-    // Allocate array of columns for each y
-      aboard->cells[y] = (enum BoardCodes *) malloc(COLS * sizeof(enum BoardCodes ));
-    if (aboard->cells[y] == NULL) {
-      showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
-      return RES_FAILED; // No memory -> direct exit
+  for (i = 0; i < ntiles; i++) {
+    aboard->tiles[i] = free_tile;
+  }
+  // All cells are BC_FREE_CELL now; the bitboard must agree
+  return initializeBitboard(aboard);
+}
+
+// The tile of cell (y,x) was never written: all its cells are free
+bool isTileFree(struct board *aboard, int y, int x) {
+  return aboard->tiles[(y >> TILE_SHIFT) * aboard->tiles_per_row + (x >> TILE_SHIFT)] == free_tile;
+}
+
+static int getNumberOfTiles(struct board *aboard) {
+  return ((aboard->last_row + TILE_SIZE) >> TILE_SHIFT) * aboard->tiles_per_row;
+}
+
+#endif  // BOARD_ROWS
+
+// Copy the contents of a board into a new headless board
+enum ResCodes copyBoard(struct board* dest, struct board* src) {
+#ifndef BOARD_ROWS
+  int i;
+#endif
+  int code;
+  int size;
+
+  if (initializeHeadlessBoard(dest, src->last_row + 1, src->last_col + 1) != RES_OK) {
+    return RES_FAILED;
+  }
+#ifdef BOARD_ROWS
+  memcpy(dest->cells, src->cells, sizeof(dest->cells));
+#else
+  for (i = 0; i < getNumberOfTiles(src); i++) {
+    if (src->tiles[i] != free_tile) {
+      dest->tiles[i] = allocMemory(dest->arena, TILE_SIZE * TILE_SIZE * sizeof(uint8_t));
+      if (dest->tiles[i] == NULL) {
+        dest->tiles[i] = free_tile;
+        cleanupBoard(dest);
+        showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+        return RES_FAILED;
+      }
+      memcpy(dest->tiles[i], src->tiles[i], TILE_SIZE * TILE_SIZE * sizeof(uint8_t));
+    }
+  }
+#endif
+  if (src->bits[0] != NULL) {
+    size = (src->last_row + 1) * src->words_per_row;
+    for (code = 0; code < NUMBER_OF_BOARD_CODES; code++) {
+      memcpy(dest->bits[code], src->bits[code], size * sizeof(uint64_t));
     }
   }
+  dest->food_items = src->food_items;
+  if (copyHazards(dest, src) != RES_OK) {
+    cleanupBoard(dest);
+    return RES_FAILED;
+  }
   return RES_OK;
 }
 
+// Make all cells of the board free for the next level.
+// The tiles stay allocated and are cleared in bulk, the display is
+// cleared once. Hazards of the previous level are dropped.
+// Minimaps and the food index must be set up after the level is loaded.
+void clearBoard(struct board* aboard) {
+#ifdef BOARD_ROWS
+  memset(aboard->cells, 0, sizeof(aboard->cells));  // Constant size: inlined by the compiler
+#else
+  int i;
+  for (i = 0; i < getNumberOfTiles(aboard); i++) {
+    if (aboard->tiles[i] != free_tile) {
+      memset(aboard->tiles[i], 0, TILE_SIZE * TILE_SIZE * sizeof(uint8_t));
+    }
+  }
+#endif
+  clearBitboard(aboard);
+  if (aboard->hazards != NULL) {
+    aboard->hazards->count = 0;
+  }
+  aboard->food_items = 0;
+  if (!aboard->headless) {
+    // Blank the display with the colors of free cells
+    chtype background = getbkgd(stdscr);
+    bkgdset(SYMBOL_FREE_CELL | COLOR_PAIR(COLP_FREE_CELL));
+    erase();
+    bkgdset(background);
+    resetStatus();
+  }
+}
+
+// Boards in an arena are released by resetArena()
 void cleanupBoard(struct board* aboard) {
-  int y;
-  for (y = 0; y <= aboard->last_row; y++) {
-    free(aboard->cells[y]);
+#ifndef BOARD_ROWS
+  int i;
+  for (i = 0; i < getNumberOfTiles(aboard) && aboard->arena == NULL; i++) {
+    if (aboard->tiles[i] != free_tile) {
+      free(aboard->tiles[i]);
+    }
   }
-  free(aboard->cells);
+  freeMemory(aboard->arena, aboard->tiles);
+#endif
+  cleanupBitboard(aboard);
+  cleanupHazards(aboard);
 }
 
 // Place an item onto the curses display.
-void placeItem(struct board* aboard, int y, int x, enum BoardCodes board_code,  chtype symbol, enum ColorPairs color_pair) {
-
-    //  Store item on the display (symbol code)
-    move(y,x);                         // Move cursor to (y,x)
-    attron(COLOR_PAIR(color_pair));     // Start writing in selected color
-    addch(symbol);         // Store symbol on the virtual display
-    attroff(COLOR_PAIR(color_pair));    // Stop writing in selected color
-    aboard -> cells[y][x] = board_code;
+// Returns RES_FAILED if there is no memory for the tile of the cell or for
+// the food index; the level cannot go on then. Placing a free cell never
+// needs memory. No dialog is shown: within a tick the render thread may own
+// the display, so the caller reports the error once it is safe.
+enum ResCodes placeItem(struct board* aboard, int y, int x, enum BoardCodes board_code,  chtype symbol, enum ColorPairs color_pair) {
+
+#ifdef BOARD_ROWS
+    uint8_t* cell = &aboard -> cells[y * BOARD_COLS + x];
+#else
+    uint8_t** tile = &aboard -> tiles[(y >> TILE_SHIFT) * aboard -> tiles_per_row + (x >> TILE_SHIFT)];
+    int i = ((y & TILE_MASK) << TILE_SHIFT) | (x & TILE_MASK);
+
+    if (*tile == free_tile) {
+        if (board_code == BC_FREE_CELL) {
+            return RES_OK;  // Nothing changes
+        }
+        // First non-free cell of the tile
+        if ((*tile = allocMemory(aboard -> arena, TILE_SIZE * TILE_SIZE * sizeof(uint8_t))) == NULL) {
+            *tile = free_tile;
+            return RES_FAILED;
+        }
+    }
+    uint8_t* cell = &(*tile)[i];
+#endif
+    // The food index is the only other structure that may need memory
+    if (aboard -> food_index != NULL
+        && updateFoodIndex(aboard, y, x, *cell, board_code) != RES_OK) {
+        return RES_FAILED;
+    }
+    updateBitboard(aboard, y, x, *cell, board_code);
+    if (aboard -> minimaps != NULL) {
+        updateMinimaps(aboard, y, x, *cell, board_code);
+    }
+    *cell = board_code;
+
+    // Only cells within the viewport are shown
+    if (!aboard -> headless && !aboard -> view_covered
+        && y >= aboard -> view_top && y < aboard -> view_top + aboard -> view_rows
+        && x >= aboard -> view_left && x < aboard -> view_left + aboard -> view_cols) {
+        //  Store item on the display (symbol code in the selected color)
+        drawCell(y - aboard -> view_top, x - aboard -> view_left, symbol | COLOR_PAIR(color_pair));
+    }
+    return RES_OK;
 }
 
 
@@ -79,20 +280,13 @@ void placeItem(struct board* aboard, int y, int x, enum BoardCodes board_code,
 // We allow for level descriptions of dimensions
 //    (aboard->last_row + 1) x (last_col + 1)
 enum ResCodes initializeLevelFromFile(struct board* aboard, const char* filename) {
-    int y,x;
+    int x;
     int rownr;
     char buf[100];  // for messages
     FILE* in;       // FILE pointer for reading from file
 
-    // Fill board with empty cells.
-    for (y = 0; y <= aboard->last_row; y++) {
-        for (x = 0; x <= aboard->last_col; x++) {
-            placeItem(aboard, y, x, BC_FREE_CELL, SYMBOL_FREE_CELL, COLP_FREE_CELL);
-        } 
-    }
-
-    // Initialize food_items
-    aboard->food_items = 0;
+    // Fill board with empty cells; this also resets food_items
+    clearBoard(aboard);
 
     // Read at most aboard->last_row+1 lines from file
     // Read at most aboard->last_col+1 characters per line from file
@@ -100,7 +294,7 @@ enum ResCodes initializeLevelFromFile(struct board* aboard, const char* filename
     // The additional 2 elements are for '\n' and '\0'
     int bufsize = aboard->last_col + 3;
     char* buffer;
-    if ((buffer = malloc(sizeof(char) * bufsize)) == NULL) {
+    if ((buffer = allocMemory(aboard->arena, sizeof(char) * bufsize)) == NULL) {
         sprintf(buf,"Kein Speicher mehr in initializeLevelFromFile\n");
         showDialog(buf,"Bitte eine Taste druecken");
         return RES_FAILED;
@@ -110,6 +304,7 @@ enum ResCodes initializeLevelFromFile(struct board* aboard, const char* filename
     if ( (in = fopen(filename,"r")) == NULL) {
         sprintf(buf,"Kann Datei %s nicht oeffnen",filename);
         showDialog(buf,"Bitte eine Taste druecken");
+        freeMemory(aboard->arena, buffer);
         return RES_FAILED;
     }
 
@@ -125,13 +320,18 @@ enum ResCodes initializeLevelFromFile(struct board* aboard, const char* filename
             // have a '\0' in the buffer.
             len = strlen(buffer);
             // Note: function strlen does not count the terminating '\0'.
-            if (buffer[len -1] != '\n') {
+            // A '\0' read from a binary file makes len smaller, even 0.
+            if (len == 0 || buffer[len -1] != '\n') {
+                int c;
                 // Input line was not yet finished. No '\n' in buffer.
-                // Delete the last char before '\0'from the buffer because
-                // it exceeds the allowed number of characters.
-                buffer[len -1] = '\0';
+                // If the buffer is full, delete the last char before '\0'
+                // from the buffer because it exceeds the allowed number of characters.
+                // Otherwise this is the last line of a file without a final '\n'.
+                if (len == bufsize - 1) {
+                    buffer[len -1] = '\0';
+                }
                 // Delete the rest of the line that is already in OS input buffer
-                while (fgetc(in) != '\n'){;}
+                while ((c = fgetc(in)) != '\n' && c != EOF){;}
             } else {
                 // Input line in buffer ends with '\n'
                 // Delete the '\n' from the buffer
@@ -146,6 +346,8 @@ enum ResCodes initializeLevelFromFile(struct board* aboard, const char* filename
                 sprintf(buf,"Fehler beim Lesen von Zeile %d aus Datei %s",
                         rownr +1,filename);
                 showDialog(buf,"Bitte eine Taste druecken");
+                freeMemory(aboard->arena, buffer);
+                fclose(in);
                 return RES_FAILED;
             } else {
                 // We got EOF, skip rest of loop
@@ -160,46 +362,184 @@ enum ResCodes initializeLevelFromFile(struct board* aboard, const char* filename
 
         // Fill the board's row with the symbols specified in the current input line
         for (x = 0; x <= aboard->last_col && x < len; x++) {
+            enum ResCodes res_code = RES_OK;
             switch (buffer[x]) {
                 case SYMBOL_BARRIER:
-                    placeItem(aboard,rownr,x,BC_BARRIER,SYMBOL_BARRIER,COLP_BARRIER);
+                    res_code = placeItem(aboard,rownr,x,BC_BARRIER,SYMBOL_BARRIER,COLP_BARRIER);
                     break;
                 case SYMBOL_FOOD_1:
-                    placeItem(aboard,rownr,x,BC_FOOD_1,SYMBOL_FOOD_1,COLP_FOOD_1);
+                    res_code = placeItem(aboard,rownr,x,BC_FOOD_1,SYMBOL_FOOD_1,COLP_FOOD_1);
                     aboard->food_items++;
                     break;
                 case SYMBOL_FOOD_2:
-                    placeItem(aboard,rownr,x,BC_FOOD_2,SYMBOL_FOOD_2,COLP_FOOD_2);
+                    res_code = placeItem(aboard,rownr,x,BC_FOOD_2,SYMBOL_FOOD_2,COLP_FOOD_2);
                     aboard->food_items++;
                     break;
                 case SYMBOL_FOOD_3:
-                    placeItem(aboard,rownr,x,BC_FOOD_3,SYMBOL_FOOD_3,COLP_FOOD_3);
+                    res_code = placeItem(aboard,rownr,x,BC_FOOD_3,SYMBOL_FOOD_3,COLP_FOOD_3);
                     aboard->food_items++;
                     break;
+                case SYMBOL_PATROL_H:
+                case SYMBOL_PATROL_V:
+                case SYMBOL_BOUNCER:
+                    if (addHazard(aboard, rownr, x, buffer[x]) != RES_OK) {
+                        freeMemory(aboard->arena, buffer);
+                        fclose(in);
+                        return RES_FAILED;
+                    }
+                    break;
 
                 // We ignore all other symbols! 
             }
+            // No memory for the tile of the cell
+            if (res_code != RES_OK) {
+                showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+                freeMemory(aboard->arena, buffer);
+                fclose(in);
+                return RES_FAILED;
+            }
         }
         // advance to next input line
         rownr++;
     } // END while
     
     // Free the line buffer
-    free(buffer);
+    freeMemory(aboard->arena, buffer);
 
     // Draw a line in order to separate the message area
-    // Note:
-    // we cannot use function placeItem() since the message area is outside the board!
-    y = aboard->last_row + 1;
-    for (x=0; x <= aboard->last_col; x++) {
+    showSeparatorLine(aboard);
+
+    fclose(in);
+    return RES_OK;
+}
+
+// Draw a line below the board in order to separate the message area
+// Note:
+// we cannot use function placeItem() since the message area is outside the board!
+void showSeparatorLine(struct board* aboard) {
+    int x;
+    int y = aboard->view_rows;
+    for (x=0; x < aboard->view_cols && !aboard->headless; x++) {
         move(y,x);
         attron(COLOR_PAIR(COLP_BARRIER));
         addch(SYMBOL_BARRIER);
         attroff(COLOR_PAIR(COLP_BARRIER));
     }
+}
 
+// Width of a level file: the length of its longest line,
+// but at least MIN_NUMBER_OF_COLS.
+// Used by tools that size headless boards after the level.
+int getLevelFileWidth(const char* filename) {
+    FILE* in;
+    int c;
+    int len = 0;
+    int longest = MIN_NUMBER_OF_COLS;
+
+    if ((in = fopen(filename, "r")) == NULL) {
+        return longest;
+    }
+    while ((c = fgetc(in)) != EOF) {
+        if (c == '\n') {
+            len = 0;
+        } else if (++len > longest) {
+            longest = len;
+        }
+    }
     fclose(in);
-    return RES_OK;
+    return longest;
+}
+
+// Height of a level file: its number of lines,
+// but at least MIN_NUMBER_OF_ROWS.
+int getLevelFileHeight(const char* filename) {
+    FILE* in;
+    int c;
+    int last = '\n';
+    int lines = 0;
+
+    if ((in = fopen(filename, "r")) == NULL) {
+        return MIN_NUMBER_OF_ROWS;
+    }
+    while ((c = fgetc(in)) != EOF) {
+        if (c == '\n') {
+            lines++;
+        }
+        last = c;
+    }
+    if (last != '\n') {
+        lines++;  // Last line without '\n'
+    }
+    fclose(in);
+    return lines > MIN_NUMBER_OF_ROWS ? lines : MIN_NUMBER_OF_ROWS;
+}
+
+// Move the viewport such that the head keeps a margin of a quarter of the
+// viewport to its edges. After scrolling, the whole viewport is drawn again;
+// otherwise only the cells changed by placeItem() are drawn.
+void updateViewport(struct board* aboard, struct pos head) {
+    int margin_y = aboard->view_rows / 4;
+    int margin_x = aboard->view_cols / 4;
+    int top = aboard->view_top;
+    int left = aboard->view_left;
+
+    if (aboard->headless) {
+        return;
+    }
+    if (head.y < top + margin_y) {
+        top = head.y - margin_y;
+    } else if (head.y > top + aboard->view_rows - 1 - margin_y) {
+        top = head.y - aboard->view_rows + 1 + margin_y;
+    }
+    if (head.x < left + margin_x) {
+        left = head.x - margin_x;
+    } else if (head.x > left + aboard->view_cols - 1 - margin_x) {
+        left = head.x - aboard->view_cols + 1 + margin_x;
+    }
+    // Stay on the board
+    if (top > aboard->last_row + 1 - aboard->view_rows) {
+        top = aboard->last_row + 1 - aboard->view_rows;
+    }
+    if (top < 0) {
+        top = 0;
+    }
+    if (left > aboard->last_col + 1 - aboard->view_cols) {
+        left = aboard->last_col + 1 - aboard->view_cols;
+    }
+    if (left < 0) {
+        left = 0;
+    }
+    if (top != aboard->view_top || left != aboard->view_left) {
+        aboard->view_top = top;
+        aboard->view_left = left;
+        showViewport(aboard);
+    }
+}
+
+// Draw all cells of the viewport.
+// Worm elements are drawn as inner elements; showWorm() draws head and tail.
+void showViewport(struct board* aboard) {
+    int y, x;
+
+    if (aboard->view_covered) {
+        return;
+    }
+    for (y = aboard->view_top; y < aboard->view_top + aboard->view_rows; y++) {
+        for (x = aboard->view_left; x < aboard->view_left + aboard->view_cols; x++) {
+            chtype symbol;
+            enum ColorPairs color;
+            switch (getCellAt(aboard, y, x)) {
+                case BC_USED_BY_WORM:
+                    symbol = SYMBOL_WORM_INNER_ELEMENT; color = COLP_USER_WORM; break;
+                case BC_FOOD_1: symbol = SYMBOL_FOOD_1; color = COLP_FOOD_1; break;
+                case BC_FOOD_2: symbol = SYMBOL_FOOD_2; color = COLP_FOOD_2; break;
+                case BC_FOOD_3: symbol = SYMBOL_FOOD_3; color = COLP_FOOD_3; break;
+                case BC_BARRIER: symbol = SYMBOL_BARRIER; color = COLP_BARRIER; break;
+                default: symbol = SYMBOL_FREE_CELL; color = COLP_FREE_CELL; break;
+            }
+            drawCell(y - aboard->view_top, x - aboard->view_left, symbol | COLOR_PAIR(color));
+        }
+    }
 }
 
 enum ResCodes initializeLevel(struct board* aboard) {
@@ -289,11 +629,11 @@ int getNumberOfFoodItems(struct board* aboard) {
 }
 
 enum BoardCodes getContentAt(struct board* aboard, struct pos position){
-    return aboard -> cells[position.y][position.x];
+    return getCellAt(aboard, position.y, position.x);
 }
 
 // Setters
-void setNumbersOfFoodItems(struct board* aboard, int n) {
+void setNumberOfFoodItems(struct board* aboard, int n) {
   aboard -> food_items = n;
 }
 
@@ -13,6 +13,8 @@
 #define _BOARD_MODEL_H
 
 #include <curses.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include "worm.h"
 
 // Codes on the board
@@ -24,6 +26,30 @@ enum BoardCodes {
     BC_FOOD_3,       // Food type 3; if hit by worm -> bonus of type 3
     BC_BARRIER       // A barrier; if hit by worm -> game over
 };
+#define NUMBER_OF_BOARD_CODES 6
+
+// Largest number of rows and columns: positions of the worm are stored in 16 bits
+#define MAX_BOARD_SIZE (UINT16_MAX + 1)
+
+// Fixed-size build (make BOARD_ROWS=.. BOARD_COLS=..): the cells of every
+// board are an array inside struct board with the constant stride BOARD_COLS.
+// Boards may be smaller than BOARD_ROWS x BOARD_COLS, but not larger.
+#ifdef BOARD_ROWS
+#if BOARD_ROWS * BOARD_COLS > (1 << 18)
+#error "Fixed-size builds are meant for small boards: BOARD_ROWS * BOARD_COLS <= 2^18"
+#endif
+#endif
+
+// Tiles of cells: TILE_SIZE x TILE_SIZE cells, row by row
+#define TILE_SHIFT 7
+#define TILE_SIZE (1 << TILE_SHIFT)
+#define TILE_MASK (TILE_SIZE - 1)
+
+struct minimap;  // See minimap.h
+struct hazards;  // See hazards.h
+struct food_index;  // See food_index.h
+struct occupancy;   // See occupancy.h
+struct arena;    // See arena.h
 
 // Positions on the board
 struct pos {
@@ -39,22 +65,71 @@ struct board
     int last_row; // Last usable row on the board
     int last_col; // Last usable column on the board
 
-    enum BoardCodes** cells;
-    // A 2-dimensional array for storing the contents of the board.
+    // The contents of the board, stored in tiles of TILE_SIZE x TILE_SIZE
+    // cells of one byte each (see getCellAt). Fixed-size builds store
+    // all cells row by row instead. A tile is allocated when one of its cells
+    // becomes non-free; until then it is the one shared tile of free cells.
+    // So huge boards that are mostly empty need little memory.
     //
     // Since the worm is not permitted to cross over itsself
     // nor other elements (apart from food) we do not need a reference
     // counter for occupied cells.
+#ifdef BOARD_ROWS
+    uint8_t cells[BOARD_ROWS * BOARD_COLS];
+#else
+    uint8_t** tiles;
+    int tiles_per_row;
+#endif
 
     int food_items; // Number of food items left in the current level
+
+    bool headless;  // Board is not shown on the display (tools, simulations)
+    bool wraps;     // Opposite edges are connected (torus of the endless world)
+
+    // Viewport: the part of the board shown on the display
+    int view_top;   // Board coordinates of the upper left cell shown
+    int view_left;
+    int view_rows;  // Size of the viewport
+    int view_cols;
+    bool view_covered;        // The overview covers the viewport; placeItem() draws nothing
+
+    struct minimap* minimaps; // Minimaps updated by placeItem(); NULL if none
+    struct hazards* hazards;  // Moving hazards of the level; NULL if none
+    struct food_index* food_index;  // Food positions updated by placeItem(); NULL if none
+    struct occupancy* occupancy;    // Worm and element per cell updated by the worm model; NULL if none
+    struct arena* arena;      // Memory of the board and its layers; NULL: from the heap
+
+    // Bitboard view of cells: one bitset per board code (see bitboard.c).
+    // NULL on boards with more than BITBOARD_MAX_CELLS cells.
+    int words_per_row;
+    uint64_t* bits[NUMBER_OF_BOARD_CODES];
 };
 
-extern enum ResCodes initializeBoard(struct board* aboard);
-extern void placeItem(struct board* aboard, int y, int x, enum BoardCodes board_code,
-               chtype symbol, enum ColorPairs color_pair);
+// Content of cell (y,x): a shift and a mask into its tile
+static inline enum BoardCodes getCellAt(struct board* aboard, int y, int x) {
+#ifdef BOARD_ROWS
+    return (enum BoardCodes) aboard->cells[y * BOARD_COLS + x];
+#else
+    return (enum BoardCodes) aboard->tiles[(y >> TILE_SHIFT) * aboard->tiles_per_row + (x >> TILE_SHIFT)]
+                        [((y & TILE_MASK) << TILE_SHIFT) | (x & TILE_MASK)];
+#endif
+}
+
+extern enum ResCodes initializeBoard(struct board* aboard, struct arena* anarena, int nrows, int ncols);
+extern enum ResCodes initializeHeadlessBoard(struct board* aboard, int nrows, int ncols);
+extern enum ResCodes placeItem(struct board* aboard, int y, int x, enum BoardCodes board_code,
+                               chtype symbol, enum ColorPairs color_pair);
+extern enum ResCodes copyBoard(struct board* dest, struct board* src);
+extern void clearBoard(struct board* aboard);
 extern void cleanupBoard(struct board* aboard);
 extern enum ResCodes initializeLevelFromFile(struct board* aboard, const char* filename);
 extern enum ResCodes initializeLevel(struct board* aboard);
+extern void showSeparatorLine(struct board* aboard);
+extern int getLevelFileWidth(const char* filename);
+extern int getLevelFileHeight(const char* filename);
+extern void updateViewport(struct board* aboard, struct pos head);
+extern void showViewport(struct board* aboard);
+extern bool isTileFree(struct board* aboard, int y, int x);
 
 // Getters
 extern int getNumberOfFoodItems(struct board* aboard);
@@ -0,0 +1,293 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Heuristic bot steering a worm
+//
+// For each of the four headings the bot rates the cell the head would
+// enter. The rating is a weighted sum of
+// - the number of steps from that cell to the nearest food item
+//   (multi-source BFS from all food items once per tick, stopped early)
+// - the size of the region reachable from that cell, relative to the
+//   length of the worm (flood fill on the bitboard, once per region).
+//   On boards with an occupancy a smaller region counts as large enough
+//   if a worm cell at its border is free before the region is used up.
+// - whether the heading stays the same
+// - the number of blocked neighbours of that cell
+// - some random noise from a seeded generator
+// Cells that would end the game are never chosen unless there is no other way.
+// On boards with an occupancy a cell of a worm that is free again before the
+// head gets there (the own tail) may be entered as well. Following the tail
+// is safe, so such a cell counts as a region large enough for the worm, but
+// has no known distance to food: it is taken only if nothing better is open.
+// The same seed and parameters always give the same game.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <float.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "bitboard.h"
+#include "bot.h"
+#include "messages.h"
+#include "occupancy.h"
+
+// Random numbers: xorshift32
+uint32_t nextRandom(uint32_t* state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+enum ResCodes initializeBot(struct bot* abot, const float* params, uint32_t seed,
+                            struct board* aboard) {
+  int i;
+
+  if (!hasBitboard(aboard)) {
+    showDialog("Abbruch: Spielfeld ist zu gross fuer den Bot", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  for (i = 0; i < BOT_NUMBER_OF_PARAMS; i++) {
+    abot -> params[i] = params[i];
+  }
+  abot -> rng = seed != 0 ? seed : 0x9e3779b9;  // xorshift must not start at 0
+  abot -> ncells = (aboard -> last_row + 1) * (aboard -> last_col + 1);
+  abot -> food_dist = malloc(abot -> ncells * sizeof(int));
+  abot -> queue = malloc(abot -> ncells * sizeof(int));
+  abot -> passable = malloc(5 * (aboard -> last_row + 1) * aboard -> words_per_row * sizeof(uint64_t));
+  abot -> regions = abot -> passable + (aboard -> last_row + 1) * aboard -> words_per_row;
+  if (abot -> food_dist == NULL || abot -> queue == NULL || abot -> passable == NULL) {
+    cleanupBot(abot);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+void cleanupBot(struct bot* abot) {
+  free(abot -> food_dist);
+  free(abot -> queue);
+  free(abot -> passable);
+  abot -> food_dist = NULL;
+  abot -> queue = NULL;
+  abot -> passable = NULL;
+}
+
+static bool isPassable(enum BoardCodes code) {
+  return code == BC_FREE_CELL || code == BC_FOOD_1 || code == BC_FOOD_2 || code == BC_FOOD_3;
+}
+
+// Distance to the nearest food item for the cells in targets; -1 if there is none.
+// Multi-source BFS from all food items that stops as soon as all targets are reached.
+static void computeFoodDistances(struct bot* abot, struct board* aboard,
+                                 const int* targets, int ntargets) {
+  enum BoardCodes food_codes[3] = { BC_FOOD_1, BC_FOOD_2, BC_FOOD_3 };
+  int ncols = aboard -> last_col + 1;
+  int head = 0;
+  int tail = 0;
+  int missing = ntargets;
+  int i, j;
+
+  for (i = 0; i < abot -> ncells; i++) {
+    abot -> food_dist[i] = -1;
+  }
+  // Food items are taken from the bitboard instead of scanning all cells
+  for (j = 0; j < 3; j++) {
+    const uint64_t* bits = aboard -> bits[food_codes[j]];
+    for (i = 0; i < (aboard -> last_row + 1) * aboard -> words_per_row; i++) {
+      uint64_t word = bits[i];
+      while (word != 0) {
+        int c = (i / aboard -> words_per_row) * ncols
+          + (i % aboard -> words_per_row) * BITS_PER_WORD + __builtin_ctzll(word);
+        abot -> food_dist[c] = 0;
+        abot -> queue[tail++] = c;
+        word &= word - 1;
+      }
+    }
+  }
+  for (i = 0; i < ntargets; i++) {
+    if (abot -> food_dist[targets[i]] == 0) {
+      missing--;
+    }
+  }
+  while (head < tail && missing > 0) {
+    int c = abot -> queue[head++];
+    int k;
+    int ny[4] = { c / ncols - 1, c / ncols + 1, c / ncols, c / ncols };
+    int nx[4] = { c % ncols, c % ncols, c % ncols - 1, c % ncols + 1 };
+
+    for (k = 0; k < 4; k++) {
+      int n;
+      if (ny[k] < 0 || ny[k] > aboard -> last_row || nx[k] < 0 || nx[k] > aboard -> last_col) {
+        continue;
+      }
+      n = ny[k] * ncols + nx[k];
+      if (abot -> food_dist[n] >= 0 || !isPassable(getCellAt(aboard, ny[k], nx[k]))) {
+        continue;
+      }
+      abot -> food_dist[n] = abot -> food_dist[c] + 1;
+      abot -> queue[tail++] = n;
+      for (i = 0; i < ntargets; i++) {
+        if (targets[i] == n) {
+          missing--;
+        }
+      }
+    }
+  }
+}
+
+// Number of neighbours of a cell the worm cannot enter
+static int countBlockedNeighbours(struct board* aboard, struct pos p) {
+  int dy[4] = { -1, 1, 0, 0 };
+  int dx[4] = { 0, 0, -1, 1 };
+  int k;
+  int blocked = 0;
+
+  for (k = 0; k < 4; k++) {
+    int y = p.y + dy[k];
+    int x = p.x + dx[k];
+    if (y < 0 || y > aboard -> last_row || x < 0 || x > aboard -> last_col
+        || !isPassable(getCellAt(aboard, y, x))) {
+      blocked++;
+    }
+  }
+  return blocked;
+}
+
+// Is a worm cell next to the region free before a worm in the region has
+// used up all its cells? Needs the occupancy to know when cells are free.
+// The neighbours of the region are found by shifting its bitset by one cell
+// in all four directions.
+static bool canEscapeRegion(struct board* aboard, const uint64_t* region, int region_size) {
+  int wpr = aboard -> words_per_row;
+  const uint64_t* worm = aboard -> bits[BC_USED_BY_WORM];
+  int y, w;
+
+  if (aboard -> occupancy == NULL) {
+    return false;
+  }
+  for (y = 0; y <= aboard -> last_row; y++) {
+    for (w = 0; w < wpr; w++) {
+      int i = y * wpr + w;
+      uint64_t border = (region[i] << 1) | (region[i] >> 1);
+      if (w > 0) {
+        border |= region[i - 1] >> (BITS_PER_WORD - 1);
+      }
+      if (w < wpr - 1) {
+        border |= region[i + 1] << (BITS_PER_WORD - 1);
+      }
+      if (y > 0) {
+        border |= region[i - wpr];
+      }
+      if (y < aboard -> last_row) {
+        border |= region[i + wpr];
+      }
+      border &= worm[i];
+      while (border != 0) {
+        struct pos p = { y, w * BITS_PER_WORD + __builtin_ctzll(border) };
+        int ticks = getTicksUntilFree(aboard, p);
+        if (ticks > 0 && ticks <= region_size) {
+          return true;
+        }
+        border &= border - 1;
+      }
+    }
+  }
+  return false;
+}
+
+// The region reachable from p, as index into the regions of this tick.
+// Neighbours of the head often lie in the same region, so regions already
+// filled in this tick are reused. Regions smaller than len are checked for
+// an escape (see canEscapeRegion).
+static int getRegion(struct bot* abot, struct board* aboard, struct pos p, int len) {
+  int size = (aboard -> last_row + 1) * aboard -> words_per_row;
+  int word = p.y * aboard -> words_per_row + p.x / BITS_PER_WORD;
+  uint64_t bit = (uint64_t) 1 << (p.x % BITS_PER_WORD);
+  int i;
+
+  for (i = 0; i < abot -> nregions; i++) {
+    if (abot -> regions[i * size + word] & bit) {
+      return i;
+    }
+  }
+  abot -> region_sizes[i] = floodFill(aboard, abot -> passable, p, abot -> regions + i * size);
+  abot -> region_escapes[i] = abot -> region_sizes[i] < len
+    && canEscapeRegion(aboard, abot -> regions + i * size, abot -> region_sizes[i]);
+  abot -> nregions++;
+  return i;
+}
+
+// Choose the heading with the best rating
+enum WormHeading getBotHeading(struct bot* abot, struct board* aboard, struct worm* aworm) {
+  // Same order as enum WormHeading
+  int dy[4] = { -1, 1, 0, 0 };
+  int dx[4] = { 0, 0, -1, 1 };
+  struct pos headpos = getWormHeadPos(aworm);
+  enum WormHeading current = getWormHeading(aworm);
+  enum WormHeading best = current;
+  float best_rating = -FLT_MAX;
+  float scale = aboard -> last_row + aboard -> last_col + 2;
+  int len = getWormLength(aworm);
+  bool open[4];
+  bool freeing[4];   // Cell of a worm that is free when the head enters it
+  int targets[4];
+  int ntargets = 0;
+  int k;
+
+  for (k = 0; k < 4; k++) {
+    struct pos cand = { headpos.y + dy[k], headpos.x + dx[k] };
+    open[k] = cand.y >= 0 && cand.y <= aboard -> last_row && cand.x >= 0
+      && cand.x <= aboard -> last_col && isPassable(getContentAt(aboard, cand));
+    freeing[k] = !open[k] && cand.y >= 0 && cand.y <= aboard -> last_row && cand.x >= 0
+      && cand.x <= aboard -> last_col && getContentAt(aboard, cand) == BC_USED_BY_WORM
+      && isFreeAfterTicks(aboard, cand, 1);
+    if (open[k]) {
+      targets[ntargets++] = cand.y * (aboard -> last_col + 1) + cand.x;
+    }
+  }
+  computeFoodDistances(abot, aboard, targets, ntargets);
+  getPassableCells(aboard, abot -> passable);
+  abot -> nregions = 0;
+
+  for (k = 0; k < 4; k++) {
+    struct pos cand = { headpos.y + dy[k], headpos.x + dx[k] };
+    float rating;
+    int dist, region, r;
+
+    if (!open[k] && !freeing[k]) {
+      continue;
+    }
+    if (freeing[k]) {
+      dist = abot -> ncells;
+      region = len;
+    } else {
+      dist = abot -> food_dist[cand.y * (aboard -> last_col + 1) + cand.x];
+      if (dist < 0) {
+        dist = abot -> ncells;
+      }
+      r = getRegion(abot, aboard, cand, len);
+      region = abot -> region_escapes[r] ? len : abot -> region_sizes[r];
+    }
+
+    rating = -abot -> params[BOT_FOOD_DISTANCE] * dist / scale
+      + abot -> params[BOT_FREE_REGION] * (region < len ? (float) region / len : 1.0f)
+      + abot -> params[BOT_STRAIGHT] * (k == current)
+      - abot -> params[BOT_WALL] * countBlockedNeighbours(aboard, cand)
+      + abot -> params[BOT_NOISE] * (nextRandom(&abot -> rng) >> 8) / (float) (1 << 24);
+    if (rating > best_rating) {
+      best_rating = rating;
+      best = k;
+    }
+  }
+  return best;
+}
@@ -0,0 +1,55 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Heuristic bot steering a worm
+
+#ifndef _BOT_H
+#define _BOT_H
+
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+
+// Weights of the heuristic
+enum BotParams {
+    BOT_FOOD_DISTANCE,  // Penalty per step to the nearest food item
+    BOT_FREE_REGION,    // Bonus for entering a region large enough for the worm
+    BOT_STRAIGHT,       // Bonus for keeping the current heading
+    BOT_WALL,           // Penalty per blocked neighbour of the target cell
+    BOT_NOISE,          // Amplitude of random noise (breaks ties)
+    BOT_NUMBER_OF_PARAMS
+};
+
+// A bot structure
+struct bot
+{
+    float params[BOT_NUMBER_OF_PARAMS];
+    uint32_t rng;     // State of the random number generator
+
+    // Scratch memory for the distances to the nearest food item
+    int ncells;
+    int* food_dist;
+    int* queue;
+
+    // Scratch memory for the regions reachable from the neighbours of the head
+    uint64_t* passable;
+    uint64_t* regions;   // Up to four bitsets, one per region found in this tick
+    int region_sizes[4];
+    bool region_escapes[4]; // A worm cell at the border of the region is free in time
+    int nregions;
+};
+
+extern enum ResCodes initializeBot(struct bot* abot, const float* params, uint32_t seed,
+                                   struct board* aboard);
+extern void cleanupBot(struct bot* abot);
+extern enum WormHeading getBotHeading(struct bot* abot, struct board* aboard, struct worm* aworm);
+extern uint32_t nextRandom(uint32_t* state);
+
+#endif  // #define _BOT_H
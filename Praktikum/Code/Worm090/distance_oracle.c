@@ -0,0 +1,382 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Distance oracle for the static barriers of a level
+//
+// Barriers never move, except the hazards of a level (see hazards.c).
+// Hence distances through the layout of the other barriers can be
+// computed once per level:
+// - exact distances between all food items and the start of the worm
+// - BFS distances from a few landmarks to every cell. By the triangle
+//   inequality |d(l,a) - d(l,b)| <= d(a,b) for each landmark l, which gives
+//   an admissible heuristic for path finding (ALT).
+// Hazards are not part of the layout: their cells count as free. A hazard
+// can only make a path longer, so on levels with hazards all distances
+// are lower bounds, and the landmark bounds stay admissible.
+//
+// The oracle is cached in a file next to the level file. The cache is keyed
+// by a hash of the level file content and the board dimensions.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "worm.h"
+#include "board_model.h"
+#include "distance_oracle.h"
+#include "messages.h"
+#include "hazards.h"
+
+#define ORACLE_MAGIC "WORMDO2"   // 8 bytes including '\0'
+
+// BFS through the static barriers of the board from cell src.
+// dist[i] is -1 for unreachable cells.
+static void computeBFS(struct board* aboard, const bool* is_static_barrier,
+                       struct pos src, int* dist, int* queue) {
+  int ncols = aboard -> last_col + 1;
+  int ncells = (aboard -> last_row + 1) * ncols;
+  int head = 0;
+  int tail = 0;
+  int i;
+
+  for (i = 0; i < ncells; i++) {
+    dist[i] = -1;
+  }
+  if (is_static_barrier[src.y * ncols + src.x]) {
+    return;
+  }
+  dist[src.y * ncols + src.x] = 0;
+  queue[tail++] = src.y * ncols + src.x;
+  while (head < tail) {
+    int c = queue[head++];
+    int y = c / ncols;
+    int x = c % ncols;
+    int k;
+    int ny[4] = { y - 1, y + 1, y, y };
+    int nx[4] = { x, x, x - 1, x + 1 };
+
+    for (k = 0; k < 4; k++) {
+      int n;
+      if (ny[k] < 0 || ny[k] > aboard -> last_row || nx[k] < 0 || nx[k] > aboard -> last_col) {
+        continue;
+      }
+      n = ny[k] * ncols + nx[k];
+      if (dist[n] >= 0 || is_static_barrier[n]) {
+        continue;
+      }
+      dist[n] = dist[c] + 1;
+      queue[tail++] = n;
+    }
+  }
+}
+
+static enum ResCodes allocateOracle(struct distance_oracle* oracle) {
+  int ncells = oracle -> nrows * oracle -> ncols;
+
+  // + 1: a board without reachable cells has no landmarks at all
+  oracle -> landmark_dist = malloc(oracle -> nlandmarks * ncells * sizeof(uint16_t) + 1);
+  oracle -> points = malloc(oracle -> npoints * sizeof(struct pos));
+  oracle -> point_dist = malloc(oracle -> npoints * oracle -> npoints * sizeof(int));
+  if (oracle -> landmark_dist == NULL || oracle -> points == NULL || oracle -> point_dist == NULL) {
+    cleanupDistanceOracle(oracle);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+// Compute the oracle for the current contents of the board
+enum ResCodes buildDistanceOracle(struct distance_oracle* oracle, struct board* aboard) {
+  int nrows = aboard -> last_row + 1;
+  int ncols = aboard -> last_col + 1;
+  int ncells = nrows * ncols;
+  int y, x, i, j, l;
+  int* dist;
+  int* mindist;
+  int* queue;
+  bool* is_static_barrier;
+  struct pos start;
+
+  oracle -> hash = 0;
+  oracle -> nrows = nrows;
+  oracle -> ncols = ncols;
+
+  // Points of interest: food in reading order, then the start position
+  oracle -> npoints = 1;
+  for (y = 0; y < nrows; y++) {
+    for (x = 0; x < ncols; x++) {
+      enum BoardCodes code = getCellAt(aboard, y, x);
+      if (code == BC_FOOD_1 || code == BC_FOOD_2 || code == BC_FOOD_3) {
+        oracle -> npoints++;
+      }
+    }
+  }
+  oracle -> nlandmarks = NUMBER_OF_LANDMARKS;
+  if (allocateOracle(oracle) != RES_OK) {
+    return RES_FAILED;
+  }
+  i = 0;
+  for (y = 0; y < nrows; y++) {
+    for (x = 0; x < ncols; x++) {
+      enum BoardCodes code = getCellAt(aboard, y, x);
+      if (code == BC_FOOD_1 || code == BC_FOOD_2 || code == BC_FOOD_3) {
+        oracle -> points[i].y = y;
+        oracle -> points[i].x = x;
+        i++;
+      }
+    }
+  }
+  start.y = aboard -> last_row;
+  start.x = 0;
+  oracle -> points[i] = start;
+
+  dist = malloc(ncells * sizeof(int));
+  mindist = malloc(ncells * sizeof(int));
+  queue = malloc(ncells * sizeof(int));
+  is_static_barrier = malloc(ncells * sizeof(bool));
+  if (dist == NULL || mindist == NULL || queue == NULL || is_static_barrier == NULL) {
+    free(dist);
+    free(mindist);
+    free(queue);
+    free(is_static_barrier);
+    cleanupDistanceOracle(oracle);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  for (y = 0; y < nrows; y++) {
+    for (x = 0; x < ncols; x++) {
+      is_static_barrier[y * ncols + x] = getCellAt(aboard, y, x) == BC_BARRIER;
+    }
+  }
+  if (aboard -> hazards != NULL) {
+    for (i = 0; i < aboard -> hazards -> count; i++) {
+      is_static_barrier[aboard -> hazards -> y[i] * ncols + aboard -> hazards -> x[i]] = false;
+    }
+  }
+
+  // Exact distances between the points of interest
+  for (i = 0; i < oracle -> npoints; i++) {
+    computeBFS(aboard, is_static_barrier, oracle -> points[i], dist, queue);
+    for (j = 0; j < oracle -> npoints; j++) {
+      oracle -> point_dist[i * oracle -> npoints + j] =
+        dist[oracle -> points[j].y * ncols + oracle -> points[j].x];
+    }
+  }
+
+  // Landmarks by farthest point selection within the region of the start.
+  // The first landmark is the cell farthest away from the start.
+  computeBFS(aboard, is_static_barrier, start, mindist, queue);
+  for (l = 0; l < NUMBER_OF_LANDMARKS; l++) {
+    int best = -1;
+    uint16_t* ldist = oracle -> landmark_dist + l * ncells;
+
+    for (i = 0; i < ncells; i++) {
+      if (mindist[i] > 0 && (best < 0 || mindist[i] > mindist[best])) {
+        best = i;
+      }
+    }
+    if (best < 0) {
+      break;  // Fewer reachable cells than landmarks
+    }
+    oracle -> landmarks[l].y = best / ncols;
+    oracle -> landmarks[l].x = best % ncols;
+    computeBFS(aboard, is_static_barrier, oracle -> landmarks[l], dist, queue);
+    for (i = 0; i < ncells; i++) {
+      if (dist[i] < 0) {
+        ldist[i] = DIST_UNREACHABLE;
+      } else {
+        ldist[i] = dist[i] < DIST_UNREACHABLE ? dist[i] : DIST_UNREACHABLE - 1;
+      }
+      // Distance to the nearest landmark chosen so far
+      if (mindist[i] >= 0 && (l == 0 || dist[i] < mindist[i])) {
+        mindist[i] = dist[i];
+      }
+    }
+  }
+  oracle -> nlandmarks = l;
+
+  free(dist);
+  free(mindist);
+  free(queue);
+  free(is_static_barrier);
+  return RES_OK;
+}
+
+// FNV-1a hash of the level file and the board dimensions
+static uint64_t hashLevelFile(const char* filename, int nrows, int ncols, int* ok) {
+  uint64_t hash = 14695981039346656037ULL;
+  FILE* in;
+  int c;
+
+  *ok = 0;
+  if ((in = fopen(filename, "r")) == NULL) {
+    return 0;
+  }
+  while ((c = fgetc(in)) != EOF) {
+    hash = (hash ^ (unsigned char) c) * 1099511628211ULL;
+  }
+  fclose(in);
+  hash = (hash ^ (uint64_t) nrows) * 1099511628211ULL;
+  hash = (hash ^ (uint64_t) ncols) * 1099511628211ULL;
+  *ok = 1;
+  return hash;
+}
+
+// Read the oracle from the cache file; fails if the file does not match
+static enum ResCodes readOracleCache(struct distance_oracle* oracle, const char* cachename,
+                                     uint64_t hash, int nrows, int ncols) {
+  FILE* in;
+  char magic[sizeof(ORACLE_MAGIC)];
+  int ncells = nrows * ncols;
+  int ok;
+
+  if ((in = fopen(cachename, "rb")) == NULL) {
+    return RES_FAILED;
+  }
+  ok = fread(magic, sizeof(magic), 1, in) == 1
+    && memcmp(magic, ORACLE_MAGIC, sizeof(magic)) == 0
+    && fread(&oracle -> hash, sizeof(oracle -> hash), 1, in) == 1
+    && fread(&oracle -> nrows, sizeof(int), 1, in) == 1
+    && fread(&oracle -> ncols, sizeof(int), 1, in) == 1
+    && fread(&oracle -> nlandmarks, sizeof(int), 1, in) == 1
+    && fread(&oracle -> npoints, sizeof(int), 1, in) == 1
+    && oracle -> hash == hash && oracle -> nrows == nrows && oracle -> ncols == ncols
+    && oracle -> nlandmarks >= 0 && oracle -> nlandmarks <= NUMBER_OF_LANDMARKS
+    && oracle -> npoints > 0 && oracle -> npoints <= ncells + 1;
+  if (ok) {
+    ok = allocateOracle(oracle) == RES_OK;
+    ok = ok
+      && fread(oracle -> landmarks, sizeof(struct pos), oracle -> nlandmarks, in) == oracle -> nlandmarks
+      && fread(oracle -> points, sizeof(struct pos), oracle -> npoints, in) == oracle -> npoints
+      && fread(oracle -> landmark_dist, sizeof(uint16_t), (size_t) oracle -> nlandmarks * ncells, in)
+         == (size_t) oracle -> nlandmarks * ncells
+      && fread(oracle -> point_dist, sizeof(int), (size_t) oracle -> npoints * oracle -> npoints, in)
+         == (size_t) oracle -> npoints * oracle -> npoints;
+    if (!ok) {
+      cleanupDistanceOracle(oracle);
+    }
+  }
+  fclose(in);
+  return ok ? RES_OK : RES_FAILED;
+}
+
+// Write the oracle to the cache file. Errors are ignored: the cache is optional.
+static void writeOracleCache(struct distance_oracle* oracle, const char* cachename) {
+  char tmpname[FILENAME_MAX];
+  FILE* out;
+  int ncells = oracle -> nrows * oracle -> ncols;
+  bool ok;
+
+  // A temporary file is renamed, so that readers never see a truncated cache.
+  // The pid keeps tools that build the same cache at once apart.
+  snprintf(tmpname, sizeof(tmpname), "%s.%d.tmp", cachename, (int) getpid());
+  if ((out = fopen(tmpname, "wb")) == NULL) {
+    return;
+  }
+  ok = fwrite(ORACLE_MAGIC, sizeof(ORACLE_MAGIC), 1, out) == 1
+    && fwrite(&oracle -> hash, sizeof(oracle -> hash), 1, out) == 1
+    && fwrite(&oracle -> nrows, sizeof(int), 1, out) == 1
+    && fwrite(&oracle -> ncols, sizeof(int), 1, out) == 1
+    && fwrite(&oracle -> nlandmarks, sizeof(int), 1, out) == 1
+    && fwrite(&oracle -> npoints, sizeof(int), 1, out) == 1
+    && fwrite(oracle -> landmarks, sizeof(struct pos), oracle -> nlandmarks, out)
+       == (size_t) oracle -> nlandmarks
+    && fwrite(oracle -> points, sizeof(struct pos), oracle -> npoints, out)
+       == (size_t) oracle -> npoints
+    && fwrite(oracle -> landmark_dist, sizeof(uint16_t), (size_t) oracle -> nlandmarks * ncells, out)
+       == (size_t) oracle -> nlandmarks * ncells
+    && fwrite(oracle -> point_dist, sizeof(int), (size_t) oracle -> npoints * oracle -> npoints, out)
+       == (size_t) oracle -> npoints * oracle -> npoints;
+  if (fclose(out) != 0 || !ok || rename(tmpname, cachename) != 0) {
+    remove(tmpname);
+  }
+}
+
+// Load the oracle for the level just loaded into aboard from the cache
+// next to the level file. If there is no valid cache, build and store it.
+enum ResCodes loadOrBuildDistanceOracle(struct distance_oracle* oracle, struct board* aboard,
+                                        const char* level_filename) {
+  int nrows = aboard -> last_row + 1;
+  int ncols = aboard -> last_col + 1;
+  int hash_ok;
+  uint64_t hash = hashLevelFile(level_filename, nrows, ncols, &hash_ok);
+  char* cachename;
+
+  if (!hash_ok) {
+    return buildDistanceOracle(oracle, aboard);
+  }
+  cachename = malloc(strlen(level_filename) + sizeof(DISTANCE_ORACLE_SUFFIX));
+  if (cachename == NULL) {
+    return buildDistanceOracle(oracle, aboard);
+  }
+  strcpy(cachename, level_filename);
+  strcat(cachename, DISTANCE_ORACLE_SUFFIX);
+
+  if (readOracleCache(oracle, cachename, hash, nrows, ncols) != RES_OK) {
+    if (buildDistanceOracle(oracle, aboard) != RES_OK) {
+      free(cachename);
+      return RES_FAILED;
+    }
+    oracle -> hash = hash;
+    writeOracleCache(oracle, cachename);
+  }
+  free(cachename);
+  return RES_OK;
+}
+
+void cleanupDistanceOracle(struct distance_oracle* oracle) {
+  free(oracle -> landmark_dist);
+  free(oracle -> points);
+  free(oracle -> point_dist);
+  oracle -> landmark_dist = NULL;
+  oracle -> points = NULL;
+  oracle -> point_dist = NULL;
+}
+
+// Queries
+
+// Admissible lower bound for the distance from one cell to another.
+// Returns -1 if a landmark proves that to cannot be reached.
+int getDistanceLowerBound(struct distance_oracle* oracle, struct pos from, struct pos to) {
+  int ncells = oracle -> nrows * oracle -> ncols;
+  int fi = from.y * oracle -> ncols + from.x;
+  int ti = to.y * oracle -> ncols + to.x;
+  int best = abs(from.y - to.y) + abs(from.x - to.x);  // Manhattan distance
+  int l;
+
+  for (l = 0; l < oracle -> nlandmarks; l++) {
+    int df = oracle -> landmark_dist[l * ncells + fi];
+    int dt = oracle -> landmark_dist[l * ncells + ti];
+    if (df == DIST_UNREACHABLE && dt == DIST_UNREACHABLE) {
+      continue;  // Landmark lies in another region
+    }
+    if (df == DIST_UNREACHABLE || dt == DIST_UNREACHABLE) {
+      return -1;
+    }
+    if (abs(df - dt) > best) {
+      best = abs(df - dt);
+    }
+  }
+  return best;
+}
+
+// Exact distance between two points of interest; -1 if unreachable
+int getPointDistance(struct distance_oracle* oracle, int from, int to) {
+  return oracle -> point_dist[from * oracle -> npoints + to];
+}
+
+int getNumberOfPoints(struct distance_oracle* oracle) {
+  return oracle -> npoints;
+}
+
+struct pos getPoint(struct distance_oracle* oracle, int i) {
+  return oracle -> points[i];
+}
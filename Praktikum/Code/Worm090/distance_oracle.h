@@ -0,0 +1,54 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Distance oracle for the static barriers of a level
+
+#ifndef _DISTANCE_ORACLE_H
+#define _DISTANCE_ORACLE_H
+
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+
+#define NUMBER_OF_LANDMARKS 8          // Landmarks for ALT lower bounds
+#define DIST_UNREACHABLE 0xffff        // Landmark distance of unreachable cells
+#define DISTANCE_ORACLE_SUFFIX ".oracle" // Cache file: level filename + suffix
+
+// A distance oracle structure
+//
+// Points of interest are all food items of the level in reading order,
+// followed by the start position of the worm at (last_row, 0).
+struct distance_oracle
+{
+    uint64_t hash;       // Hash of level file content and board dimensions
+    int nrows;
+    int ncols;
+
+    int nlandmarks;
+    struct pos landmarks[NUMBER_OF_LANDMARKS];
+    uint16_t* landmark_dist;  // nlandmarks x (nrows * ncols); saturated at DIST_UNREACHABLE - 1
+
+    int npoints;
+    struct pos* points;       // Points of interest
+    int* point_dist;          // npoints x npoints exact distances; -1 if unreachable.
+                              // Lower bounds on levels with hazards.
+};
+
+extern enum ResCodes buildDistanceOracle(struct distance_oracle* oracle, struct board* aboard);
+extern enum ResCodes loadOrBuildDistanceOracle(struct distance_oracle* oracle, struct board* aboard,
+                                               const char* level_filename);
+extern void cleanupDistanceOracle(struct distance_oracle* oracle);
+
+// Queries
+extern int getDistanceLowerBound(struct distance_oracle* oracle, struct pos from, struct pos to);
+extern int getPointDistance(struct distance_oracle* oracle, int from, int to);
+extern int getNumberOfPoints(struct distance_oracle* oracle);
+extern struct pos getPoint(struct distance_oracle* oracle, int i);
+
+#endif  // #define _DISTANCE_ORACLE_H
@@ -0,0 +1,243 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Spatial index of the food on the board
+//
+// The board is divided into square buckets; each bucket lists the food
+// items on its cells. Eating or placing food changes one bucket only.
+// A nearest food query searches the rings of buckets around the start
+// bucket and stops as soon as no bucket of the next ring can be closer
+// than the best item found. Distances are Manhattan distances, i.e. the
+// number of steps of the worm on a free board.
+
+#include <stdlib.h>
+#include <limits.h>
+#include "worm.h"
+#include "board_model.h"
+#include "bitboard.h"
+#include "messages.h"
+#include "food_index.h"
+#include "arena.h"
+
+static int getFoodKind(enum BoardCodes code) {
+  switch (code) {
+    case BC_FOOD_1: return FOOD_KIND_1;
+    case BC_FOOD_2: return FOOD_KIND_2;
+    case BC_FOOD_3: return FOOD_KIND_3;
+    default: return 0;
+  }
+}
+
+static int countFood(struct food_index* aindex, int kinds) {
+  return (kinds & FOOD_KIND_1 ? aindex -> count[0] : 0)
+    + (kinds & FOOD_KIND_2 ? aindex -> count[1] : 0)
+    + (kinds & FOOD_KIND_3 ? aindex -> count[2] : 0);
+}
+
+static struct food_bucket* getBucket(struct food_index* aindex, int y, int x) {
+  return &aindex -> buckets[(y >> aindex -> shift) * aindex -> ncols + (x >> aindex -> shift)];
+}
+
+static enum ResCodes addFood(struct food_index* aindex, int y, int x, enum BoardCodes code) {
+  struct food_bucket* b = getBucket(aindex, y, x);
+
+  if (b -> count == b -> capacity) {
+    int capacity = b -> capacity > 0 ? 2 * b -> capacity : 4;
+    struct food_entry* entries = resizeMemory(aindex -> arena, b -> entries,
+                                              b -> capacity * sizeof(struct food_entry),
+                                              capacity * sizeof(struct food_entry));
+    if (entries == NULL) {
+      return RES_FAILED;
+    }
+    b -> entries = entries;
+    b -> capacity = capacity;
+  }
+  b -> entries[b -> count].y = y;
+  b -> entries[b -> count].x = x;
+  b -> entries[b -> count].code = code;
+  b -> count++;
+  aindex -> count[code - BC_FOOD_1]++;
+  return RES_OK;
+}
+
+static void removeFood(struct food_index* aindex, int y, int x) {
+  struct food_bucket* b = getBucket(aindex, y, x);
+  int i;
+
+  for (i = 0; i < b -> count; i++) {
+    if (b -> entries[i].y == y && b -> entries[i].x == x) {
+      aindex -> count[b -> entries[i].code - BC_FOOD_1]--;
+      b -> entries[i] = b -> entries[--b -> count];
+      return;
+    }
+  }
+}
+
+// Add all food of the board to the index
+static enum ResCodes indexBoard(struct food_index* aindex, struct board* aboard) {
+  enum BoardCodes code;
+  int y, x;
+
+  if (hasBitboard(aboard)) {
+    for (code = BC_FOOD_1; code <= BC_FOOD_3; code++) {
+      int i;
+      for (i = 0; i < (aboard -> last_row + 1) * aboard -> words_per_row; i++) {
+        uint64_t word = aboard -> bits[code][i];
+        while (word != 0) {
+          y = i / aboard -> words_per_row;
+          x = (i % aboard -> words_per_row) * BITS_PER_WORD + __builtin_ctzll(word);
+          if (addFood(aindex, y, x, code) != RES_OK) {
+            return RES_FAILED;
+          }
+          word &= word - 1;
+        }
+      }
+    }
+    return RES_OK;
+  }
+  // Huge boards: only tiles that were written can contain food
+  for (y = 0; y <= aboard -> last_row; y++) {
+    for (x = 0; x <= aboard -> last_col; x++) {
+      if (isTileFree(aboard, y, x)) {
+        x |= TILE_MASK;  // Skip the rest of the tile row
+        continue;
+      }
+      code = getCellAt(aboard, y, x);
+      if (getFoodKind(code) != 0 && addFood(aindex, y, x, code) != RES_OK) {
+        return RES_FAILED;
+      }
+    }
+  }
+  return RES_OK;
+}
+
+// Build the index of the food on the board and register it with the board
+enum ResCodes initializeFoodIndex(struct food_index* aindex, struct board* aboard) {
+  aindex -> shift = FOOD_BUCKET_MIN_SHIFT;
+  while ((long) ((aboard -> last_row >> aindex -> shift) + 1)
+         * ((aboard -> last_col >> aindex -> shift) + 1) > FOOD_MAX_BUCKETS) {
+    aindex -> shift++;
+  }
+  aindex -> nrows = (aboard -> last_row >> aindex -> shift) + 1;
+  aindex -> ncols = (aboard -> last_col >> aindex -> shift) + 1;
+  aindex -> count[0] = aindex -> count[1] = aindex -> count[2] = 0;
+  aindex -> arena = aboard -> arena;
+  aindex -> buckets = allocMemory(aindex -> arena, aindex -> nrows * aindex -> ncols * sizeof(struct food_bucket));
+  if (aindex -> buckets == NULL) {
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  if (indexBoard(aindex, aboard) != RES_OK) {
+    cleanupFoodIndex(aindex, aboard);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  aboard -> food_index = aindex;
+  return RES_OK;
+}
+
+void cleanupFoodIndex(struct food_index* aindex, struct board* aboard) {
+  int i;
+
+  if (aboard -> food_index == aindex) {
+    aboard -> food_index = NULL;
+  }
+  for (i = 0; i < aindex -> nrows * aindex -> ncols && aindex -> arena == NULL; i++) {
+    free(aindex -> buckets[i].entries);
+  }
+  freeMemory(aindex -> arena, aindex -> buckets);
+}
+
+// Called by placeItem() for every changed cell.
+// Returns RES_FAILED if a bucket cannot grow; placeItem() reports the error.
+enum ResCodes updateFoodIndex(struct board* aboard, int y, int x,
+                              enum BoardCodes old_code, enum BoardCodes new_code) {
+  if (old_code == new_code) {
+    return RES_OK;
+  }
+  if (getFoodKind(old_code) != 0) {
+    removeFood(aboard -> food_index, y, x);
+  }
+  if (getFoodKind(new_code) != 0) {
+    return addFood(aboard -> food_index, y, x, new_code);
+  }
+  return RES_OK;
+}
+
+// Food of the given kinds closest to from. Returns false if there is none.
+bool findNearestFood(struct food_index* aindex, struct pos from, int kinds,
+                     struct pos* nearest, int* distance) {
+  int by = from.y >> aindex -> shift;
+  int bx = from.x >> aindex -> shift;
+  int size = 1 << aindex -> shift;
+  int best = INT_MAX;
+  int r, y, x, i;
+
+  if (countFood(aindex, kinds) == 0) {
+    return false;
+  }
+  for (r = 0; r < aindex -> nrows || r < aindex -> ncols; r++) {
+    // Cells of ring r are at least (r - 1) * size + 1 steps away
+    if (r > 0 && (r - 1) * size + 1 >= best) {
+      break;
+    }
+    for (y = by - r; y <= by + r; y++) {
+      if (y < 0 || y >= aindex -> nrows) {
+        continue;
+      }
+      // Inner rows of the ring consist of its left and right bucket only
+      for (x = bx - r; x <= bx + r; x += (y == by - r || y == by + r || r == 0) ? 1 : 2 * r) {
+        struct food_bucket* b;
+        if (x < 0 || x >= aindex -> ncols) {
+          continue;
+        }
+        b = &aindex -> buckets[y * aindex -> ncols + x];
+        for (i = 0; i < b -> count; i++) {
+          if (getFoodKind(b -> entries[i].code) & kinds) {
+            int d = abs(b -> entries[i].y - from.y) + abs(b -> entries[i].x - from.x);
+            if (d < best) {
+              best = d;
+              nearest -> y = b -> entries[i].y;
+              nearest -> x = b -> entries[i].x;
+            }
+          }
+        }
+      }
+    }
+  }
+  *distance = best;
+  return true;
+}
+
+// Food of the given kinds at most radius steps away from from.
+// Stores up to max_found positions in found and returns their number.
+int findFoodWithinRadius(struct food_index* aindex, struct pos from, int radius,
+                         int kinds, struct pos* found, int max_found) {
+  int y0 = (from.y - radius < 0 ? 0 : from.y - radius) >> aindex -> shift;
+  int x0 = (from.x - radius < 0 ? 0 : from.x - radius) >> aindex -> shift;
+  int y1 = (from.y + radius) >> aindex -> shift;
+  int x1 = (from.x + radius) >> aindex -> shift;
+  int n = 0;
+  int y, x, i;
+
+  for (y = y0; y <= y1 && y < aindex -> nrows; y++) {
+    for (x = x0; x <= x1 && x < aindex -> ncols; x++) {
+      struct food_bucket* b = &aindex -> buckets[y * aindex -> ncols + x];
+      for (i = 0; i < b -> count && n < max_found; i++) {
+        if ((getFoodKind(b -> entries[i].code) & kinds)
+            && abs(b -> entries[i].y - from.y) + abs(b -> entries[i].x - from.x) <= radius) {
+          found[n].y = b -> entries[i].y;
+          found[n].x = b -> entries[i].x;
+          n++;
+        }
+      }
+    }
+  }
+  return n;
+}
@@ -0,0 +1,63 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Spatial index of the food on the board
+
+#ifndef _FOOD_INDEX_H
+#define _FOOD_INDEX_H
+
+#include <stdbool.h>
+#include "worm.h"
+#include "board_model.h"
+
+// Kinds of food for queries; may be combined with |
+#define FOOD_KIND_1 1
+#define FOOD_KIND_2 2
+#define FOOD_KIND_3 4
+#define FOOD_KIND_ANY (FOOD_KIND_1 | FOOD_KIND_2 | FOOD_KIND_3)
+
+#define FOOD_BUCKET_MIN_SHIFT 4      // Buckets have at least 16 x 16 cells
+#define FOOD_MAX_BUCKETS (1 << 16)   // Larger boards get larger buckets
+
+// A food item in a bucket
+struct food_entry {
+    int y;
+    int x;
+    enum BoardCodes code;
+};
+
+// The food items of one square of the board
+struct food_bucket {
+    int count;
+    int capacity;
+    struct food_entry* entries;
+};
+
+// A uniform grid of buckets of food positions.
+// placeItem() keeps the index up to date when food is placed or eaten.
+struct food_index
+{
+    int shift;          // Buckets are (1 << shift) x (1 << shift) cells
+    int nrows;          // Number of buckets per column and row
+    int ncols;
+    struct food_bucket* buckets;
+    int count[3];       // Number of food items per kind
+    struct arena* arena;  // Memory of the buckets: the arena of the board
+};
+
+extern enum ResCodes initializeFoodIndex(struct food_index* aindex, struct board* aboard);
+extern void cleanupFoodIndex(struct food_index* aindex, struct board* aboard);
+extern enum ResCodes updateFoodIndex(struct board* aboard, int y, int x,
+                                     enum BoardCodes old_code, enum BoardCodes new_code);
+extern bool findNearestFood(struct food_index* aindex, struct pos from, int kinds,
+                            struct pos* nearest, int* distance);
+extern int findFoodWithinRadius(struct food_index* aindex, struct pos from, int radius,
+                                int kinds, struct pos* found, int max_found);
+
+#endif  // #define _FOOD_INDEX_H
@@ -0,0 +1,204 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Moving hazards
+//
+// Levels declare hazards with the symbols
+//   SYMBOL_PATROL_H  a barrier patrolling left and right
+//   SYMBOL_PATROL_V  a barrier patrolling up and down
+//   SYMBOL_BOUNCER   an obstacle moving diagonally and bouncing off
+// A hazard moves by one cell per tick. It reverses (a patrol) or is
+// reflected (a bouncer) when the next cell is not free; the worm is an
+// obstacle like any other. A worm that runs into a hazard crashes.
+// Cells may be closed to hazards (keepHazardsOut()); the autopilot closes
+// its cycle, so hazards only move in the cells the worm never visits.
+//
+// All hazards are kept in one structure of arrays and moved by one loop
+// per tick. Their cells change through placeItem() only, i.e. on the
+// virtual curses screen; refresh() shows all of them at once.
+
+#include <stdlib.h>
+#include <string.h>
+#include "worm.h"
+#include "board_model.h"
+#include "messages.h"
+#include "hazards.h"
+#include "arena.h"
+#include "bitboard.h"
+
+// Enlarge the arrays of a hazard structure to capacity elements
+static enum ResCodes growHazards(struct arena* anarena, struct hazards* h, int capacity) {
+  int n = h -> capacity;
+  int* y = resizeMemory(anarena, h -> y, n * sizeof(int), capacity * sizeof(int));
+  int* x = y == NULL ? NULL : resizeMemory(anarena, h -> x, n * sizeof(int), capacity * sizeof(int));
+  int8_t* dy = x == NULL ? NULL : resizeMemory(anarena, h -> dy, n * sizeof(int8_t), capacity * sizeof(int8_t));
+  int8_t* dx = dy == NULL ? NULL : resizeMemory(anarena, h -> dx, n * sizeof(int8_t), capacity * sizeof(int8_t));
+  char* symbol = dx == NULL ? NULL : resizeMemory(anarena, h -> symbol, n * sizeof(char), capacity * sizeof(char));
+
+  // Keep the arrays that were moved by resizeMemory in any case
+  if (y != NULL) h -> y = y;
+  if (x != NULL) h -> x = x;
+  if (dy != NULL) h -> dy = dy;
+  if (dx != NULL) h -> dx = dx;
+  if (symbol == NULL) {
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  h -> symbol = symbol;
+  h -> capacity = capacity;
+  return RES_OK;
+}
+
+// Add a hazard declared by symbol at (y,x) and place it on the board
+enum ResCodes addHazard(struct board* aboard, int y, int x, char symbol) {
+  struct hazards* h = aboard -> hazards;
+
+  if (h == NULL) {
+    if ((h = allocMemory(aboard -> arena, sizeof(struct hazards))) == NULL) {
+      showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+      return RES_FAILED;
+    }
+    aboard -> hazards = h;
+  }
+  if (h -> count == h -> capacity
+      && growHazards(aboard -> arena, h, h -> capacity > 0 ? 2 * h -> capacity : 16) != RES_OK) {
+    return RES_FAILED;
+  }
+  if (placeItem(aboard, y, x, BC_BARRIER, symbol, COLP_BARRIER) != RES_OK) {
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  h -> y[h -> count] = y;
+  h -> x[h -> count] = x;
+  h -> dy[h -> count] = symbol == SYMBOL_PATROL_H ? 0 : 1;
+  h -> dx[h -> count] = symbol == SYMBOL_PATROL_V ? 0 : 1;
+  h -> symbol[h -> count] = symbol;
+  h -> count++;
+  return RES_OK;
+}
+
+enum ResCodes copyHazards(struct board* dest, struct board* src) {
+  struct hazards* h;
+
+  if (src -> hazards == NULL) {
+    return RES_OK;
+  }
+  if ((h = allocMemory(dest -> arena, sizeof(struct hazards))) == NULL) {
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  dest -> hazards = h;
+  if (growHazards(dest -> arena, h, src -> hazards -> capacity) != RES_OK) {
+    return RES_FAILED;
+  }
+  h -> count = src -> hazards -> count;
+  memcpy(h -> y, src -> hazards -> y, h -> count * sizeof(int));
+  memcpy(h -> x, src -> hazards -> x, h -> count * sizeof(int));
+  memcpy(h -> dy, src -> hazards -> dy, h -> count * sizeof(int8_t));
+  memcpy(h -> dx, src -> hazards -> dx, h -> count * sizeof(int8_t));
+  memcpy(h -> symbol, src -> hazards -> symbol, h -> count * sizeof(char));
+  if (src -> hazards -> keep_out != NULL) {
+    size_t size = (src -> last_row + 1) * src -> words_per_row * sizeof(uint64_t);
+    if ((h -> keep_out = allocMemory(dest -> arena, size)) == NULL) {
+      showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+      return RES_FAILED;
+    }
+    memcpy(h -> keep_out, src -> hazards -> keep_out, size);
+  }
+  return RES_OK;
+}
+
+void cleanupHazards(struct board* aboard) {
+  struct hazards* h = aboard -> hazards;
+
+  if (h != NULL) {
+    freeMemory(aboard -> arena, h -> y);
+    freeMemory(aboard -> arena, h -> x);
+    freeMemory(aboard -> arena, h -> dy);
+    freeMemory(aboard -> arena, h -> dx);
+    freeMemory(aboard -> arena, h -> symbol);
+    freeMemory(aboard -> arena, h -> keep_out);
+    freeMemory(aboard -> arena, h);
+    aboard -> hazards = NULL;
+  }
+}
+
+// Close the cells to hazards; a hazard treats them like barriers.
+// Hazards standing on one of the cells stay there until they move away.
+enum ResCodes keepHazardsOut(struct board* aboard, const struct pos* cells, int ncells) {
+  struct hazards* h = aboard -> hazards;
+  int i;
+
+  if (h == NULL) {
+    return RES_OK;
+  }
+  if (h -> keep_out == NULL) {
+    size_t size = (aboard -> last_row + 1) * aboard -> words_per_row * sizeof(uint64_t);
+    if ((h -> keep_out = allocMemory(aboard -> arena, size)) == NULL) {
+      showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+      return RES_FAILED;
+    }
+  }
+  for (i = 0; i < ncells; i++) {
+    h -> keep_out[cells[i].y * aboard -> words_per_row + cells[i].x / BITS_PER_WORD]
+      |= (uint64_t) 1 << (cells[i].x % BITS_PER_WORD);
+  }
+  return RES_OK;
+}
+
+// Cell (y,x) is on the board, free and not closed to hazards
+static bool isFreeCell(struct board* aboard, int y, int x) {
+  const uint64_t* keep_out = aboard -> hazards -> keep_out;
+
+  return y >= 0 && y <= aboard -> last_row && x >= 0 && x <= aboard -> last_col
+    && getCellAt(aboard, y, x) == BC_FREE_CELL
+    && (keep_out == NULL
+        || !(keep_out[y * aboard -> words_per_row + x / BITS_PER_WORD] >> (x % BITS_PER_WORD) & 1));
+}
+
+// Move all hazards by one cell.
+// Returns RES_FAILED if a hazard enters a tile without memory (see placeItem()).
+enum ResCodes updateHazards(struct board* aboard) {
+  struct hazards* h = aboard -> hazards;
+  int i;
+
+  if (h == NULL) {
+    return RES_OK;
+  }
+  for (i = 0; i < h -> count; i++) {
+    int y = h -> y[i];
+    int x = h -> x[i];
+    int dy = h -> dy[i];
+    int dx = h -> dx[i];
+
+    // Reflect at the axis that is blocked; at a blocked corner at both
+    if (dx != 0 && !isFreeCell(aboard, y, x + dx)) {
+      dx = -dx;
+    }
+    if (dy != 0 && !isFreeCell(aboard, y + dy, x)) {
+      dy = -dy;
+    }
+    if (dx == h -> dx[i] && dy == h -> dy[i] && !isFreeCell(aboard, y + dy, x + dx)) {
+      dx = -dx;
+      dy = -dy;
+    }
+    h -> dy[i] = dy;
+    h -> dx[i] = dx;
+    // Trapped hazards wait for the next tick
+    if (isFreeCell(aboard, y + dy, x + dx)) {
+      if (placeItem(aboard, y + dy, x + dx, BC_BARRIER, h -> symbol[i], COLP_BARRIER) != RES_OK) {
+        return RES_FAILED;
+      }
+      placeItem(aboard, y, x, BC_FREE_CELL, SYMBOL_FREE_CELL, COLP_FREE_CELL);
+      h -> y[i] = y + dy;
+      h -> x[i] = x + dx;
+    }
+  }
+  return RES_OK;
+}
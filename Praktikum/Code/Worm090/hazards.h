@@ -0,0 +1,40 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Moving hazards
+
+#ifndef _HAZARDS_H
+#define _HAZARDS_H
+
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+
+// The hazards of a level as a structure of arrays.
+// A hazard occupies its cell as BC_BARRIER, so the worm crashes into it
+// through the board lookups of moveWorm().
+struct hazards
+{
+    int count;
+    int capacity;    // Allocated elements of the arrays
+    int* y;          // Positions
+    int* x;
+    int8_t* dy;      // Directions from {-1,0,+1}
+    int8_t* dx;
+    char* symbol;    // Symbol shown on the display
+    uint64_t* keep_out;  // Cells hazards never enter, as a bitset like the bitboard; NULL if none
+};
+
+extern enum ResCodes addHazard(struct board* aboard, int y, int x, char symbol);
+extern enum ResCodes copyHazards(struct board* dest, struct board* src);
+extern void cleanupHazards(struct board* aboard);
+extern enum ResCodes updateHazards(struct board* aboard);
+extern enum ResCodes keepHazardsOut(struct board* aboard, const struct pos* cells, int ncells);
+
+#endif  // #define _HAZARDS_H
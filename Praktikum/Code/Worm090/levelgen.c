@@ -0,0 +1,561 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Procedural generation of levels
+//
+// Barriers are first generated in a private bitset with the layout of the
+// bitboard (bit x % 64 of word y * words_per_row + x / 64). Bits right of
+// the last column are kept set, so the border of the board behaves like a
+// barrier without any special cases.
+// - Caves: random fill, then some steps of the 4-5 rule of a cellular
+//   automaton. The eight neighbours of 64 cells are counted at once with
+//   bit-sliced adders. A tunnel leads from the start cell to the centre.
+// - Mazes: depth-first search on every second cell, then some walls are
+//   removed so that the maze has loops (the worm needs a way back).
+// - Arenas: bars in the upper left quarter, mirrored at both axes.
+// Then the barriers are placed on the board and the reachable region of the
+// start cell (last_row, 0) is computed with the flood fill of the bitboard.
+// Free cells outside this region are filled with barriers, and food is only
+// placed inside it. So every generated level can be cleared.
+// For the autopilot the barriers are generated on a grid of half the size
+// and scaled up by 2, aligned to the bottom left corner like the 2x2 blocks
+// of its Hamiltonian cycle (see autopilot.c). Every reachable cell then lies
+// in a free block connected to the start block, i.e. on the cycle.
+// The same seed and dimensions always give the same level.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "worm.h"
+#include "board_model.h"
+#include "bitboard.h"
+#include "levelgen.h"
+#include "messages.h"
+
+#define CAVE_STEPS 4         // Steps of the cellular automaton
+#define MAZE_LOOP_PERCENT 10 // Percentage of inner maze walls removed for loops
+#define ARENA_CELLS_PER_BAR 60
+#define START_AREA 4         // Cells right of the start cell kept free
+
+static const char* level_type_names[NUMBER_OF_LEVEL_TYPES] = {
+  [LEVEL_CAVE] = "hoehle",
+  [LEVEL_MAZE] = "labyrinth",
+  [LEVEL_ARENA] = "arena",
+};
+
+// State of the generator
+struct generator {
+  int nrows;
+  int ncols;
+  int words_per_row;
+  int size;           // Words of a bitset
+  uint64_t* walls;    // Set bits are barriers
+  uint64_t* tmp;
+  uint64_t* memory;   // Holds walls and tmp, which are swapped by the cave steps
+  uint64_t rng;
+};
+
+// Random numbers: xorshift64*
+static uint64_t nextRandom64(uint64_t* state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+static int nextRandomBelow(struct generator* g, int n) {
+  return (nextRandom64(&g -> rng) >> 33) % n;
+}
+
+static bool isWall(struct generator* g, int y, int x) {
+  return (g -> walls[y * g -> words_per_row + x / BITS_PER_WORD] >> (x % BITS_PER_WORD)) & 1;
+}
+
+static void setWall(struct generator* g, int y, int x, bool wall) {
+  uint64_t bit = (uint64_t) 1 << (x % BITS_PER_WORD);
+  if (wall) {
+    g -> walls[y * g -> words_per_row + x / BITS_PER_WORD] |= bit;
+  } else {
+    g -> walls[y * g -> words_per_row + x / BITS_PER_WORD] &= ~bit;
+  }
+}
+
+// Set the bits right of the last column
+static void setPadding(struct generator* g) {
+  int used = g -> ncols % BITS_PER_WORD;
+  int y;
+
+  if (used == 0) {
+    return;
+  }
+  for (y = 0; y < g -> nrows; y++) {
+    g -> walls[(y + 1) * g -> words_per_row - 1] |= ~(uint64_t) 0 << used;
+  }
+}
+
+// Scale the walls of g by 2 into the larger generator big. Rows are aligned
+// to the last row; an odd top row and an odd last column become walls.
+static uint64_t doubleBits(uint32_t v) {
+  uint64_t x = v;
+  x = (x | x << 16) & 0x0000FFFF0000FFFFULL;
+  x = (x | x << 8) & 0x00FF00FF00FF00FFULL;
+  x = (x | x << 4) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | x << 2) & 0x3333333333333333ULL;
+  x = (x | x << 1) & 0x5555555555555555ULL;
+  return x | x << 1;
+}
+
+static void scaleUp(struct generator* g, struct generator* big) {
+  int top = big -> nrows % 2;
+  int y, w;
+
+  for (y = 0; y < big -> nrows; y++) {
+    uint64_t* row = big -> walls + y * big -> words_per_row;
+    if (y < top) {
+      for (w = 0; w < big -> words_per_row; w++) {
+        row[w] = ~(uint64_t) 0;
+      }
+      continue;
+    }
+    for (w = 0; w < big -> words_per_row; w++) {
+      int half = w / 2;
+      uint64_t word = half < g -> words_per_row
+        ? g -> walls[(y - top) / 2 * g -> words_per_row + half] : ~(uint64_t) 0;
+      row[w] = doubleBits(word >> (w % 2 * 32));
+    }
+    if (big -> ncols % 2 != 0) {
+      setWall(big, y, big -> ncols - 1, true);
+    }
+  }
+  setPadding(big);
+}
+
+// Caves
+// ********************************************************************************************
+
+// Add a bit to the 4 bit counters s[0..3] of 64 cells
+static void addBits(uint64_t* s, uint64_t b) {
+  uint64_t carry = s[0] & b;
+  s[0] ^= b;
+  b = carry;
+  carry = s[1] & b;
+  s[1] ^= b;
+  b = carry;
+  carry = s[2] & b;
+  s[2] ^= b;
+  s[3] |= carry;
+}
+
+// One step of the 4-5 rule: a cell becomes a barrier if at least five of
+// its eight neighbours are barriers, and stays one if at least four are
+static void stepCave(struct generator* g) {
+  const uint64_t ones = ~(uint64_t) 0;
+  int wpr = g -> words_per_row;
+  uint64_t* swap;
+  int y, w, r;
+
+  for (y = 0; y < g -> nrows; y++) {
+    const uint64_t* rows[3];
+    rows[0] = y > 0 ? g -> walls + (y - 1) * wpr : NULL;
+    rows[1] = g -> walls + y * wpr;
+    rows[2] = y < g -> nrows - 1 ? g -> walls + (y + 1) * wpr : NULL;
+
+    for (w = 0; w < wpr; w++) {
+      uint64_t s[4] = { 0, 0, 0, 0 };
+      uint64_t ge5, eq4;
+
+      for (r = 0; r < 3; r++) {
+        // Rows outside of the board are barriers
+        uint64_t mid = rows[r] != NULL ? rows[r][w] : ones;
+        uint64_t prev = rows[r] != NULL && w > 0 ? rows[r][w - 1] : ones;
+        uint64_t next = rows[r] != NULL && w < wpr - 1 ? rows[r][w + 1] : ones;
+
+        addBits(s, (mid << 1) | (prev >> (BITS_PER_WORD - 1)));  // Left neighbours
+        addBits(s, (mid >> 1) | (next << (BITS_PER_WORD - 1)));  // Right neighbours
+        if (r != 1) {
+          addBits(s, mid);
+        }
+      }
+      ge5 = s[3] | (s[2] & (s[1] | s[0]));
+      eq4 = s[2] & ~s[1] & ~s[0] & ~s[3];
+      g -> tmp[y * wpr + w] = ge5 | (rows[1][w] & eq4);
+    }
+  }
+  swap = g -> walls;
+  g -> walls = g -> tmp;
+  g -> tmp = swap;
+  setPadding(g);
+}
+
+static void generateCave(struct generator* g) {
+  int i;
+
+  // Barriers with probability 7/16
+  for (i = 0; i < g -> size; i++) {
+    uint64_t a = nextRandom64(&g -> rng);
+    uint64_t b = nextRandom64(&g -> rng);
+    uint64_t c = nextRandom64(&g -> rng);
+    uint64_t d = nextRandom64(&g -> rng);
+    g -> walls[i] = a & (b | c | d);
+  }
+  setPadding(g);
+  for (i = 0; i < CAVE_STEPS; i++) {
+    stepCave(g);
+  }
+
+  // The start cell lies in a corner, which the automaton tends to fill.
+  // A tunnel to the centre connects it with the caves it crosses.
+  for (i = 0; i <= g -> ncols / 2; i++) {
+    setWall(g, g -> nrows - 1, i, false);
+  }
+  for (i = g -> nrows / 2; i < g -> nrows; i++) {
+    setWall(g, i, g -> ncols / 2, false);
+  }
+}
+
+// Mazes
+// ********************************************************************************************
+
+// Maze cells are the cells (y, x) with even x and even last_row - y,
+// so that the start cell is one of them
+static enum ResCodes generateMaze(struct generator* g) {
+  int mrows = (g -> nrows + 1) / 2;
+  int mcols = (g -> ncols + 1) / 2;
+  int dy[4] = { -1, 1, 0, 0 };
+  int dx[4] = { 0, 0, -1, 1 };
+  int* stack;
+  char* visited;
+  int top = 0;
+  int y, x, i;
+
+  stack = malloc(mrows * mcols * sizeof(int));
+  visited = calloc(mrows * mcols, 1);
+  if (stack == NULL || visited == NULL) {
+    free(stack);
+    free(visited);
+    return RES_FAILED;
+  }
+  memset(g -> walls, 0xff, g -> size * sizeof(uint64_t));
+
+  // Iterative depth-first search from the maze cell of the start cell
+  stack[top++] = (mrows - 1) * mcols;
+  visited[(mrows - 1) * mcols] = 1;
+  setWall(g, g -> nrows - 1, 0, false);
+  while (top > 0) {
+    int c = stack[top - 1];
+    int my = c / mcols;
+    int mx = c % mcols;
+    int options[4];
+    int noptions = 0;
+
+    for (i = 0; i < 4; i++) {
+      int ny = my + dy[i];
+      int nx = mx + dx[i];
+      if (ny >= 0 && ny < mrows && nx >= 0 && nx < mcols && !visited[ny * mcols + nx]) {
+        options[noptions++] = i;
+      }
+    }
+    if (noptions == 0) {
+      top--;
+      continue;
+    }
+    i = options[nextRandomBelow(g, noptions)];
+    visited[(my + dy[i]) * mcols + mx + dx[i]] = 1;
+    stack[top++] = (my + dy[i]) * mcols + mx + dx[i];
+    // Board coordinates of the current cell; the wall and the new cell follow
+    y = g -> nrows - 1 - 2 * (mrows - 1 - my);
+    x = 2 * mx;
+    setWall(g, y + dy[i], x + dx[i], false);
+    setWall(g, y + 2 * dy[i], x + 2 * dx[i], false);
+  }
+
+  // Remove some walls between two maze cells
+  for (y = 0; y < g -> nrows; y++) {
+    for (x = 0; x < g -> ncols; x++) {
+      bool between_rows = (g -> nrows - 1 - y) % 2 == 1 && x % 2 == 0 && y > 0;
+      bool between_cols = (g -> nrows - 1 - y) % 2 == 0 && x % 2 == 1 && x < g -> ncols - 1;
+      if ((between_rows || between_cols) && isWall(g, y, x)
+          && nextRandomBelow(g, 100) < MAZE_LOOP_PERCENT) {
+        setWall(g, y, x, false);
+      }
+    }
+  }
+  setPadding(g);
+  free(stack);
+  free(visited);
+  return RES_OK;
+}
+
+// Arenas
+// ********************************************************************************************
+
+static void setMirroredWall(struct generator* g, int y, int x) {
+  setWall(g, y, x, true);
+  setWall(g, y, g -> ncols - 1 - x, true);
+  setWall(g, g -> nrows - 1 - y, x, true);
+  setWall(g, g -> nrows - 1 - y, g -> ncols - 1 - x, true);
+}
+
+static void generateArena(struct generator* g) {
+  int qrows = (g -> nrows + 1) / 2;
+  int qcols = (g -> ncols + 1) / 2;
+  int nbars = qrows * qcols / ARENA_CELLS_PER_BAR;
+  int i, k;
+
+  memset(g -> walls, 0, g -> size * sizeof(uint64_t));
+  for (i = 0; i < nbars; i++) {
+    int len = 3 + nextRandomBelow(g, 6);
+    int y = nextRandomBelow(g, qrows);
+    int x = nextRandomBelow(g, qcols);
+    bool vertical = nextRandomBelow(g, 2);
+    for (k = 0; k < len && y < qrows && x < qcols; k++) {
+      setMirroredWall(g, y, x);
+      if (vertical) {
+        y++;
+      } else {
+        x++;
+      }
+    }
+  }
+  setPadding(g);
+}
+
+// Generation
+// ********************************************************************************************
+
+// Keep the start cell and the cells right of it free; for arenas in all four corners
+static void clearStartArea(struct generator* g, enum LevelTypes type) {
+  int x;
+  for (x = 0; x < START_AREA && x < g -> ncols; x++) {
+    setWall(g, g -> nrows - 1, x, false);
+    if (type == LEVEL_ARENA) {
+      setWall(g, g -> nrows - 1, g -> ncols - 1 - x, false);
+      setWall(g, 0, x, false);
+      setWall(g, 0, g -> ncols - 1 - x, false);
+    }
+  }
+}
+
+// Place barriers and food on the board. Cells not reachable from the
+// start cell become barriers; food is placed on reachable cells only.
+static enum ResCodes fillBoard(struct generator* g, struct board* aboard, int nfood) {
+  struct pos start = { g -> nrows - 1, 0 };
+  uint64_t* passable;
+  uint64_t* region;
+  int reachable;
+  int placed = 0;
+  int tries;
+  int y, x, i;
+
+  // Only the walls are placed on the cleared board; padding bits are no cells
+  clearBoard(aboard);
+  for (i = 0; i < g -> size; i++) {
+    uint64_t walls = g -> walls[i];
+    if (i % g -> words_per_row == g -> words_per_row - 1 && g -> ncols % BITS_PER_WORD != 0) {
+      walls &= ((uint64_t) 1 << (g -> ncols % BITS_PER_WORD)) - 1;
+    }
+    while (walls != 0) {
+      y = i / g -> words_per_row;
+      x = (i % g -> words_per_row) * BITS_PER_WORD + __builtin_ctzll(walls);
+      if (placeItem(aboard, y, x, BC_BARRIER, SYMBOL_BARRIER, COLP_BARRIER) != RES_OK) {
+        return RES_FAILED;
+      }
+      walls &= walls - 1;
+    }
+  }
+
+  // The walls are no longer needed: reuse them for the flood fill
+  passable = g -> walls;
+  region = g -> tmp;
+  getPassableCells(aboard, passable);
+  reachable = floodFill(aboard, passable, start, region);
+  for (i = 0; i < g -> size; i++) {
+    uint64_t pockets = passable[i] & ~region[i];
+    while (pockets != 0) {
+      y = i / g -> words_per_row;
+      x = (i % g -> words_per_row) * BITS_PER_WORD + __builtin_ctzll(pockets);
+      if (placeItem(aboard, y, x, BC_BARRIER, SYMBOL_BARRIER, COLP_BARRIER) != RES_OK) {
+        return RES_FAILED;
+      }
+      pockets &= pockets - 1;
+    }
+  }
+
+  // Random reachable cells, but not next to the start cell
+  if (nfood > reachable - START_AREA) {
+    nfood = reachable - START_AREA;
+  }
+  for (tries = 0; placed < nfood && tries < 1000 * (nfood + 1); tries++) {
+    enum ResCodes res;
+    y = nextRandomBelow(g, g -> nrows);
+    x = nextRandomBelow(g, g -> ncols);
+    if ((y == g -> nrows - 1 && x < START_AREA)
+        || (region[y * g -> words_per_row + x / BITS_PER_WORD] >> (x % BITS_PER_WORD) & 1) == 0
+        || getCellAt(aboard, y, x) != BC_FREE_CELL) {
+      continue;
+    }
+    switch (nextRandomBelow(g, 3)) {
+      case 0:
+        res = placeItem(aboard, y, x, BC_FOOD_1, SYMBOL_FOOD_1, COLP_FOOD_1);
+        break;
+      case 1:
+        res = placeItem(aboard, y, x, BC_FOOD_2, SYMBOL_FOOD_2, COLP_FOOD_2);
+        break;
+      default:
+        res = placeItem(aboard, y, x, BC_FOOD_3, SYMBOL_FOOD_3, COLP_FOOD_3);
+        break;
+    }
+    if (res != RES_OK) {
+      return RES_FAILED;
+    }
+    placed++;
+  }
+  setNumberOfFoodItems(aboard, placed);
+  showSeparatorLine(aboard);
+  return RES_OK;
+}
+
+// Generate a level of the given type on the board.
+// nfood <= 0: getDefaultFoodCount()
+// blocks: barriers in 2x2 blocks, all food on the cycle of the autopilot
+enum ResCodes generateLevel(struct board* aboard, enum LevelTypes type, uint64_t seed,
+                            int nfood, bool blocks) {
+  struct generator g;
+  struct generator big;
+  enum ResCodes res = RES_OK;
+
+  if (!hasBitboard(aboard)) {
+    showDialog("Abbruch: Spielfeld ist zu gross zum Erzeugen", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  big.nrows = aboard -> last_row + 1;
+  big.ncols = aboard -> last_col + 1;
+  big.words_per_row = aboard -> words_per_row;
+  big.size = big.nrows * big.words_per_row;
+  big.rng = seed * 0x9E3779B97F4A7C15ULL + 1;  // xorshift must not start at 0
+  big.memory = malloc(2 * big.size * sizeof(uint64_t));
+  if (big.memory == NULL) {
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  big.walls = big.memory;
+  big.tmp = big.memory + big.size;
+  g = big;
+  blocks = blocks && big.nrows >= 2 && big.ncols >= 2;
+  if (blocks) {
+    g.nrows = big.nrows / 2;
+    g.ncols = big.ncols / 2;
+    g.words_per_row = (g.ncols + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    g.size = g.nrows * g.words_per_row;
+    g.memory = malloc(2 * g.size * sizeof(uint64_t));
+    if (g.memory == NULL) {
+      free(big.memory);
+      showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+      return RES_FAILED;
+    }
+    g.walls = g.memory;
+    g.tmp = g.memory + g.size;
+  }
+  if (nfood <= 0) {
+    nfood = getDefaultFoodCount(aboard);
+  }
+
+  switch (type) {
+    case LEVEL_CAVE:
+      generateCave(&g);
+      break;
+    case LEVEL_MAZE:
+      res = generateMaze(&g);
+      break;
+    default:
+      generateArena(&g);
+      break;
+  }
+  if (res == RES_OK) {
+    clearStartArea(&g, type);
+    if (blocks) {
+      scaleUp(&g, &big);
+      big.rng = g.rng;
+      res = fillBoard(&big, aboard, nfood);
+    } else {
+      res = fillBoard(&g, aboard, nfood);
+    }
+  }
+  if (blocks) {
+    free(g.memory);
+  }
+  free(big.memory);
+  if (res != RES_OK) {
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+  }
+  return res;
+}
+
+int getDefaultFoodCount(struct board* aboard) {
+  int n = (aboard -> last_row + 1) * (aboard -> last_col + 1) / CELLS_PER_FOOD;
+  return n > 0 ? n : 1;
+}
+
+enum ResCodes getLevelType(const char* name, enum LevelTypes* type) {
+  int i;
+  for (i = 0; i < NUMBER_OF_LEVEL_TYPES; i++) {
+    if (strcmp(name, level_type_names[i]) == 0) {
+      *type = i;
+      return RES_OK;
+    }
+  }
+  return RES_FAILED;
+}
+
+const char* getLevelTypeName(enum LevelTypes type) {
+  return level_type_names[type];
+}
+
+// Write the board in the format read by initializeLevelFromFile().
+// filename NULL: standard output
+enum ResCodes saveLevelToFile(struct board* aboard, const char* filename) {
+  char buf[100];
+  char* line;
+  FILE* out;
+  int y, x;
+
+  if ((line = malloc(aboard -> last_col + 3)) == NULL) {
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  if ((out = filename != NULL ? fopen(filename, "w") : stdout) == NULL) {
+    sprintf(buf, "Kann Datei %.60s nicht schreiben", filename);
+    showDialog(buf, "Bitte eine Taste druecken");
+    free(line);
+    return RES_FAILED;
+  }
+  for (y = 0; y <= aboard -> last_row; y++) {
+    for (x = 0; x <= aboard -> last_col; x++) {
+      switch (getCellAt(aboard, y, x)) {
+        case BC_BARRIER: line[x] = SYMBOL_BARRIER; break;
+        case BC_FOOD_1: line[x] = SYMBOL_FOOD_1; break;
+        case BC_FOOD_2: line[x] = SYMBOL_FOOD_2; break;
+        case BC_FOOD_3: line[x] = SYMBOL_FOOD_3; break;
+        default: line[x] = SYMBOL_FREE_CELL; break;
+      }
+    }
+    line[x] = '\n';
+    line[x + 1] = '\0';
+    fputs(line, out);
+  }
+  free(line);
+  if (filename != NULL && fclose(out) != 0) {
+    sprintf(buf, "Kann Datei %.60s nicht schreiben", filename);
+    showDialog(buf, "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
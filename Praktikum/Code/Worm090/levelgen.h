@@ -0,0 +1,36 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Procedural generation of levels
+
+#ifndef _LEVELGEN_H
+#define _LEVELGEN_H
+
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+
+// Kinds of generated levels
+enum LevelTypes {
+    LEVEL_CAVE,    // Cellular automaton caves
+    LEVEL_MAZE,    // Maze with a few loops
+    LEVEL_ARENA,   // Obstacles mirrored at both axes
+    NUMBER_OF_LEVEL_TYPES
+};
+
+#define CELLS_PER_FOOD 150  // Default: one food item per CELLS_PER_FOOD cells
+
+extern enum ResCodes generateLevel(struct board* aboard, enum LevelTypes type, uint64_t seed,
+                                   int nfood, bool blocks);
+extern int getDefaultFoodCount(struct board* aboard);
+extern enum ResCodes getLevelType(const char* name, enum LevelTypes* type);
+extern const char* getLevelTypeName(enum LevelTypes type);
+extern enum ResCodes saveLevelToFile(struct board* aboard, const char* filename);
+
+#endif  // #define _LEVELGEN_H
@@ -10,32 +10,144 @@
 // Displaying messages and dialogs
 
 #include <curses.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
 
 #include "worm.h"
 #include "board_model.h"
 #include "worm_model.h"
 #include "messages.h"
+#include "food_index.h"
+#include "render.h"
+
+// The status lines as last drawn. Labels are drawn once, afterwards only
+// the digits of values that changed; see showStatus().
+static struct status_cache thestatus;
+
+// The next showStatus() draws the whole status area again
+void resetStatus() {
+    thestatus.valid = false;
+}
 
 // Clear an entire line on the display
 void clearLineInMessageArea(int row) {
+    move(row,0);
+    clrtoeol();
+    resetStatus();
+}
+
+// Write value right-aligned into a field of the line; '#' if it does not fit
+static void formatField(char* field, int width, int value) {
+    int i = width;
+    bool negative = value < 0;
+    unsigned int rest = negative ? -(unsigned int) value : (unsigned int) value;
+
+    do {
+        field[--i] = '0' + rest % 10;
+        rest /= 10;
+    } while (rest > 0 && i > 0);
+    if (negative && i > 0) {
+        field[--i] = '-';
+    }
+    if (rest > 0 || (negative && field[i] != '-')) {
+        memset(field, '#', width);
+        return;
+    }
+    memset(field, ' ', i);
+}
+
+// Update a field of a status line; only its changed characters are drawn
+static void updateField(int line, int col, int width, int* cached, int value) {
+    char* text = thestatus.lines[line];
+    char old[STATUS_FIELD_MAX];
     int i;
 
-    move(row,0);
-    for (i = 1; i <= COLS; i++) {
-        addch(' ');
+    if (*cached == value) {
+        return;
+    }
+    *cached = value;
+    memcpy(old, text + col, width);
+    formatField(text + col, width, value);
+    for (i = 0; i < width; i++) {
+        if (text[col + i] != old[i]) {
+            drawCell(LINES - ROWS_RESERVED + 1 + line, 1 + col + i, (unsigned char) text[col + i]);
+        }
     }
 }
 
-// Display status about the game in the message area
-void showStatus(struct board* aboard, struct worm* aworm) {
-    int pos_line1 = LINES -ROWS_RESERVED + 1;
-    int pos_line2 = LINES -ROWS_RESERVED + 2;
-    int pos_line3 = LINES -ROWS_RESERVED + 3;
+// Draw the labels of the status area with all fields blank
+static void initializeStatus(bool with_distance) {
+    int line;
 
+    snprintf(thestatus.lines[0], STATUS_LINE_MAX, STATUS_FOOD "%*s ", STATUS_FOOD_WIDTH, "");
+    if (with_distance) {
+        snprintf(thestatus.lines[0] + STATUS_DISTANCE_COL, STATUS_LINE_MAX - STATUS_DISTANCE_COL,
+                 "%*s", STATUS_DISTANCE_LABEL_WIDTH, "");
+    }
+    snprintf(thestatus.lines[1], STATUS_LINE_MAX, STATUS_POS_Y "%*s" STATUS_POS_X "%*s",
+             STATUS_POS_WIDTH, "", STATUS_POS_WIDTH, "");
+    snprintf(thestatus.lines[2], STATUS_LINE_MAX, STATUS_LENGTH "%*s", STATUS_LENGTH_WIDTH, "");
+    for (line = 0; line < STATUS_LINES; line++) {
+        drawText(LINES - ROWS_RESERVED + 1 + line, 1, thestatus.lines[line]);
+    }
+    // Values never shown, so every field is drawn next
+    thestatus.food = thestatus.distance = thestatus.y = thestatus.x = thestatus.length = INT_MIN;
+    thestatus.with_distance = with_distance;
+    thestatus.distance_shown = false;
+    thestatus.valid = true;
+}
+
+// Show or blank the distance to the nearest food; distance < 0 blanks it
+static void updateDistance(int distance) {
+    int y = LINES - ROWS_RESERVED + 1;
+    char* text = thestatus.lines[0] + STATUS_DISTANCE_COL;
+
+    if ((distance >= 0) != thestatus.distance_shown) {
+        thestatus.distance_shown = distance >= 0;
+        if (thestatus.distance_shown) {
+            snprintf(text, STATUS_LINE_MAX - STATUS_DISTANCE_COL,
+                     STATUS_DISTANCE "%*s" STATUS_DISTANCE_UNIT, STATUS_DISTANCE_WIDTH, "");
+        } else {
+            snprintf(text, STATUS_LINE_MAX - STATUS_DISTANCE_COL,
+                     "%*s", STATUS_DISTANCE_LABEL_WIDTH, "");
+        }
+        drawText(y, 1 + STATUS_DISTANCE_COL, text);
+        thestatus.distance = INT_MIN;
+    }
+    if (thestatus.distance_shown) {
+        updateField(0, STATUS_DISTANCE_COL + sizeof(STATUS_DISTANCE) - 1, STATUS_DISTANCE_WIDTH,
+                    &thestatus.distance, distance);
+    }
+}
+
+// Display status about the game in the message area.
+// Only values that changed since the last call are formatted and drawn.
+void showStatus(struct board* aboard, struct worm* aworm) {
     struct pos headpos = getWormHeadPos(aworm);
-    mvprintw(pos_line1, 1,"Anzahl verbleibender Futterbrocken: %2d ", getNumberOfFoodItems(aboard));
-    mvprintw(pos_line2, 1,"Wurm ist an Position: y=%3d x=%3d", headpos.y, headpos.x);
-    mvprintw(pos_line3, 1,"Laenge des Wurms: %3d", getWormLength(aworm) );
+    struct pos nearest;
+    int distance;
+
+    if (!isStatusDue()) {
+        return;
+    }
+    if (!thestatus.valid || thestatus.with_distance != (aboard->food_index != NULL)) {
+        initializeStatus(aboard->food_index != NULL);
+    }
+
+    updateField(0, sizeof(STATUS_FOOD) - 1, STATUS_FOOD_WIDTH,
+                &thestatus.food, getNumberOfFoodItems(aboard));
+    if (aboard->food_index != NULL) {
+        if (!findNearestFood(aboard->food_index, headpos, FOOD_KIND_ANY,
+                             &nearest, &distance)) {
+            distance = -1;
+        }
+        updateDistance(distance);
+    }
+    updateField(1, sizeof(STATUS_POS_Y) - 1, STATUS_POS_WIDTH, &thestatus.y, headpos.y);
+    updateField(1, STATUS_POS_X_COL, STATUS_POS_WIDTH, &thestatus.x, headpos.x);
+    updateField(2, sizeof(STATUS_LENGTH) - 1, STATUS_LENGTH_WIDTH,
+                &thestatus.length, getWormLength(aworm));
 }
 
 // Display a dialog in the message area and wait for confirmation
@@ -52,6 +164,12 @@ int showDialog(char* prompt1, char* prompt2) {
         return RES_FAILED;
     } 
 
+    // Tools run without curses: print the message to stderr instead
+    if (stdscr == NULL) {
+        fprintf(stderr, "%s\n", prompt1);
+        return 0;
+    }
+
     // Delete lines in the message area
     clearLineInMessageArea(pos_line1);
     clearLineInMessageArea(pos_line2);
@@ -16,6 +16,40 @@
 #include "worm_model.h"
 #include "board_model.h"
 
+// Layout of the status lines: labels and the widths of the value fields
+#define STATUS_LINES 3
+#define STATUS_LINE_MAX 100
+#define STATUS_FIELD_MAX 8
+#define STATUS_FOOD "Anzahl verbleibender Futterbrocken: "
+#define STATUS_FOOD_WIDTH 3
+#define STATUS_DISTANCE_COL (sizeof(STATUS_FOOD) - 1 + STATUS_FOOD_WIDTH + 1)
+#define STATUS_DISTANCE " Naechstes Futter: "
+#define STATUS_DISTANCE_WIDTH 5
+#define STATUS_DISTANCE_UNIT " Schritte"
+#define STATUS_DISTANCE_LABEL_WIDTH \
+    ((int) (sizeof(STATUS_DISTANCE) - 1 + STATUS_DISTANCE_WIDTH + sizeof(STATUS_DISTANCE_UNIT) - 1))
+#define STATUS_POS_Y "Wurm ist an Position: y="
+#define STATUS_POS_X " x="
+#define STATUS_POS_WIDTH 5
+#define STATUS_POS_X_COL (sizeof(STATUS_POS_Y) - 1 + STATUS_POS_WIDTH + sizeof(STATUS_POS_X) - 1)
+#define STATUS_LENGTH "Laenge des Wurms: "
+#define STATUS_LENGTH_WIDTH 5
+
+// The status lines as last drawn with the values shown in their fields
+struct status_cache
+{
+    bool valid;               // false: draw the whole status area again
+    bool with_distance;       // Line 1 has the distance to the nearest food
+    bool distance_shown;      // A distance is shown, not blanks
+    char lines[STATUS_LINES][STATUS_LINE_MAX];
+    int food;
+    int distance;
+    int y;
+    int x;
+    int length;
+};
+
+extern void resetStatus();
 extern void clearLineInMessageArea(int row);
 extern void showStatus(struct board* aboard, struct worm* aworm);
 extern int showDialog(char* prompt1, char* prompt2);
@@ -0,0 +1,193 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Minimap: the board downsampled to a few display cells
+//
+// The counts of a new minimap are reductions over the bitboard: the
+// cells of a block row are counted 64 at a time with popcount. Boards
+// without a bitboard are scanned tile by tile, skipping tiles that were
+// never written. After that only placeItem() changes the counts, one cell
+// at a time, and the glyph of a block is computed again only when a count
+// of its block changed.
+
+#include <curses.h>
+#include <stdlib.h>
+#include "worm.h"
+#include "board_model.h"
+#include "bitboard.h"
+#include "messages.h"
+#include "minimap.h"
+#include "arena.h"
+#include "render.h"
+
+// Number of set bits of a bitset row in the columns [x0, x1)
+static uint32_t countBitsInRow(const uint64_t* row, int x0, int x1) {
+  int w0 = x0 / BITS_PER_WORD;
+  int w1 = (x1 - 1) / BITS_PER_WORD;
+  uint64_t first = ~(uint64_t) 0 << (x0 % BITS_PER_WORD);
+  uint64_t last = ~(uint64_t) 0 >> (BITS_PER_WORD - 1 - (x1 - 1) % BITS_PER_WORD);
+  uint32_t count;
+  int w;
+
+  if (w0 == w1) {
+    return __builtin_popcountll(row[w0] & first & last);
+  }
+  count = __builtin_popcountll(row[w0] & first) + __builtin_popcountll(row[w1] & last);
+  for (w = w0 + 1; w < w1; w++) {
+    count += __builtin_popcountll(row[w]);
+  }
+  return count;
+}
+
+// Symbol and color of minimap cell i; worm > food > barrier
+static chtype getGlyph(struct minimap* amap, int i) {
+  if (amap -> worm[i] > 0) {
+    return MINIMAP_WORM | COLOR_PAIR(COLP_USER_WORM);
+  }
+  if (amap -> food[i] > 0) {
+    return MINIMAP_FOOD | COLOR_PAIR(COLP_FOOD_1);
+  }
+  if (2 * amap -> barrier[i] >= (uint32_t) (amap -> block_rows * amap -> block_cols)) {
+    return MINIMAP_BARRIER | COLOR_PAIR(COLP_BARRIER);
+  }
+  if (amap -> barrier[i] > 0) {
+    return MINIMAP_SOME_BARRIER | COLOR_PAIR(COLP_BARRIER);
+  }
+  return MINIMAP_FREE | COLOR_PAIR(COLP_USER_WORM);
+}
+
+static void countCell(struct minimap* amap, int i, enum BoardCodes code, int delta) {
+  switch (code) {
+    case BC_USED_BY_WORM: amap -> worm[i] += delta; break;
+    case BC_FOOD_1:
+    case BC_FOOD_2:
+    case BC_FOOD_3: amap -> food[i] += delta; break;
+    case BC_BARRIER: amap -> barrier[i] += delta; break;
+    default: break;
+  }
+}
+
+// Count all cells of the board once
+static void countBoard(struct minimap* amap, struct board* aboard) {
+  int ncols = aboard -> last_col + 1;
+  int y, x, i;
+
+  if (hasBitboard(aboard)) {
+    for (y = 0; y <= aboard -> last_row; y++) {
+      const int offset = y * aboard -> words_per_row;
+      uint32_t* worm = amap -> worm + (y / amap -> block_rows) * amap -> ncols;
+      uint32_t* food = amap -> food + (y / amap -> block_rows) * amap -> ncols;
+      uint32_t* barrier = amap -> barrier + (y / amap -> block_rows) * amap -> ncols;
+      for (i = 0; i < amap -> ncols; i++) {
+        int x0 = i * amap -> block_cols;
+        int x1 = x0 + amap -> block_cols < ncols ? x0 + amap -> block_cols : ncols;
+        worm[i] += countBitsInRow(aboard -> bits[BC_USED_BY_WORM] + offset, x0, x1);
+        food[i] += countBitsInRow(aboard -> bits[BC_FOOD_1] + offset, x0, x1)
+          + countBitsInRow(aboard -> bits[BC_FOOD_2] + offset, x0, x1)
+          + countBitsInRow(aboard -> bits[BC_FOOD_3] + offset, x0, x1);
+        barrier[i] += countBitsInRow(aboard -> bits[BC_BARRIER] + offset, x0, x1);
+      }
+    }
+    return;
+  }
+  // Huge boards: only tiles that were written can contain anything
+  for (y = 0; y <= aboard -> last_row; y += TILE_SIZE) {
+    for (x = 0; x <= aboard -> last_col; x += TILE_SIZE) {
+      int ty, tx;
+      if (isTileFree(aboard, y, x)) {
+        continue;
+      }
+      for (ty = y; ty < y + TILE_SIZE && ty <= aboard -> last_row; ty++) {
+        for (tx = x; tx < x + TILE_SIZE && tx <= aboard -> last_col; tx++) {
+          countCell(amap, (ty / amap -> block_rows) * amap -> ncols + tx / amap -> block_cols,
+                    getCellAt(aboard, ty, tx), 1);
+        }
+      }
+    }
+  }
+}
+
+// Initialize a minimap of at most nrows x ncols display cells at (top, left)
+// showing the whole board, and register it with the board
+enum ResCodes initializeMinimap(struct minimap* amap, struct board* aboard,
+                                int top, int left, int nrows, int ncols) {
+  int n, i;
+
+  amap -> top = top;
+  amap -> left = left;
+  amap -> block_rows = (aboard -> last_row + nrows) / nrows;
+  amap -> block_cols = (aboard -> last_col + ncols) / ncols;
+  amap -> nrows = (aboard -> last_row + amap -> block_rows) / amap -> block_rows;
+  amap -> ncols = (aboard -> last_col + amap -> block_cols) / amap -> block_cols;
+  n = amap -> nrows * amap -> ncols;
+
+  amap -> worm = allocMemory(aboard -> arena, 3 * n * sizeof(uint32_t));
+  amap -> glyphs = allocMemory(aboard -> arena, n * sizeof(chtype));
+  if (amap -> worm == NULL || amap -> glyphs == NULL) {
+    freeMemory(aboard -> arena, amap -> worm);
+    freeMemory(aboard -> arena, amap -> glyphs);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  amap -> food = amap -> worm + n;
+  amap -> barrier = amap -> worm + 2 * n;
+
+  countBoard(amap, aboard);
+  for (i = 0; i < n; i++) {
+    amap -> glyphs[i] = getGlyph(amap, i);
+  }
+  amap -> next = aboard -> minimaps;
+  aboard -> minimaps = amap;
+  return RES_OK;
+}
+
+void cleanupMinimap(struct minimap* amap, struct board* aboard) {
+  struct minimap** link = &aboard -> minimaps;
+
+  while (*link != NULL && *link != amap) {
+    link = &(*link) -> next;
+  }
+  if (*link == amap) {
+    *link = amap -> next;
+  }
+  freeMemory(aboard -> arena, amap -> worm);
+  freeMemory(aboard -> arena, amap -> glyphs);
+}
+
+// Called by placeItem() for every changed cell
+void updateMinimaps(struct board* aboard, int y, int x,
+                    enum BoardCodes old_code, enum BoardCodes new_code) {
+  struct minimap* amap;
+
+  for (amap = aboard -> minimaps; amap != NULL; amap = amap -> next) {
+    int i = (y / amap -> block_rows) * amap -> ncols + x / amap -> block_cols;
+    countCell(amap, i, old_code, -1);
+    countCell(amap, i, new_code, 1);
+    amap -> glyphs[i] = getGlyph(amap, i);
+  }
+}
+
+// Draw the minimap; the blocks within the viewport are shown in reverse
+void showMinimap(struct minimap* amap, struct board* aboard) {
+  int view_y0 = aboard -> view_top / amap -> block_rows;
+  int view_y1 = (aboard -> view_top + aboard -> view_rows - 1) / amap -> block_rows;
+  int view_x0 = aboard -> view_left / amap -> block_cols;
+  int view_x1 = (aboard -> view_left + aboard -> view_cols - 1) / amap -> block_cols;
+  int y, x;
+
+  for (y = 0; y < amap -> nrows; y++) {
+    for (x = 0; x < amap -> ncols; x++) {
+      chtype glyph = amap -> glyphs[y * amap -> ncols + x];
+      if (y >= view_y0 && y <= view_y1 && x >= view_x0 && x <= view_x1) {
+        glyph |= A_REVERSE;
+      }
+      drawCell(amap -> top + y, amap -> left + x, glyph);
+    }
+  }
+}
@@ -0,0 +1,59 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Minimap: the board downsampled to a few display cells
+
+#ifndef _MINIMAP_H
+#define _MINIMAP_H
+
+#include <stdint.h>
+#include <curses.h>
+#include "worm.h"
+#include "board_model.h"
+
+// Size of the minimap in the upper right corner of the viewport
+#define MINIMAP_ROWS 8
+#define MINIMAP_COLS 24
+
+// Symbols of a minimap cell; the first that applies to its block of the board
+#define MINIMAP_WORM '@'           // Block contains a worm element
+#define MINIMAP_FOOD '*'           // Block contains food
+#define MINIMAP_BARRIER '#'        // At least half of the block are barriers
+#define MINIMAP_SOME_BARRIER ':'   // Block contains barriers
+#define MINIMAP_FREE '.'           // Block is free
+
+// A minimap shows each block of block_rows x block_cols board cells as one
+// display cell. It counts worm elements, food and barriers per block.
+// placeItem() updates the counts of the changed cell, so the minimap is
+// never computed from the whole board again.
+struct minimap
+{
+    int top;            // Position of the minimap on the display
+    int left;
+    int nrows;          // Size of the minimap in display cells
+    int ncols;
+    int block_rows;     // Board cells per minimap cell
+    int block_cols;
+
+    uint32_t* worm;     // Counts per minimap cell
+    uint32_t* food;
+    uint32_t* barrier;
+    chtype* glyphs;     // Current symbol and color per minimap cell
+
+    struct minimap* next;  // Next minimap of the same board
+};
+
+extern enum ResCodes initializeMinimap(struct minimap* amap, struct board* aboard,
+                                       int top, int left, int nrows, int ncols);
+extern void cleanupMinimap(struct minimap* amap, struct board* aboard);
+extern void updateMinimaps(struct board* aboard, int y, int x,
+                           enum BoardCodes old_code, enum BoardCodes new_code);
+extern void showMinimap(struct minimap* amap, struct board* aboard);
+
+#endif  // #define _MINIMAP_H
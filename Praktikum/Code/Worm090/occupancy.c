@@ -0,0 +1,132 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Occupancy of the board
+//
+// BC_USED_BY_WORM only tells that some worm is in a cell. The occupancy
+// additionally stores the id of the worm and the ordinal of the element
+// for each cell. Entering the head and dropping the tail change one cell
+// each, so the occupancy costs O(1) per move.
+// Since the tail leaves the cells in the order of the ordinals, the number
+// of ticks until a cell becomes free follows from the ordinal and the tail
+// of its worm (see getTicksUntilElementFree) without walking the worm.
+
+#include <stdlib.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "messages.h"
+#include "occupancy.h"
+#include "arena.h"
+
+static uint32_t* getCell(struct occupancy* aoccupancy, int y, int x) {
+  return &aoccupancy -> cells[y * aoccupancy -> ncols + x];
+}
+
+// Set up an empty occupancy and register it with the board.
+// Worms already on the board are not entered; add them before showWorm().
+// Boards with more than OCCUPANCY_MAX_CELLS cells get none.
+enum ResCodes initializeOccupancy(struct occupancy* aoccupancy, struct board* aboard) {
+  long ncells = (long) (aboard -> last_row + 1) * (aboard -> last_col + 1);
+
+  aoccupancy -> ncols = aboard -> last_col + 1;
+  aoccupancy -> nworms = 0;
+  aoccupancy -> arena = aboard -> arena;
+  aoccupancy -> cells = NULL;
+  if (ncells > OCCUPANCY_MAX_CELLS) {
+    return RES_OK;
+  }
+  aoccupancy -> cells = allocMemory(aoccupancy -> arena, ncells * sizeof(uint32_t));
+  if (aoccupancy -> cells == NULL) {
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  aboard -> occupancy = aoccupancy;
+  return RES_OK;
+}
+
+void cleanupOccupancy(struct occupancy* aoccupancy, struct board* aboard) {
+  if (aboard -> occupancy == aoccupancy) {
+    aboard -> occupancy = NULL;
+  }
+  freeMemory(aoccupancy -> arena, aoccupancy -> cells);
+  aoccupancy -> cells = NULL;
+}
+
+// Give the worm an id. A worm that was initialized again keeps its old slot.
+enum ResCodes addWormToOccupancy(struct occupancy* aoccupancy, struct worm* aworm) {
+  int id;
+
+  for (id = 1; id <= aoccupancy -> nworms; id++) {
+    if (aoccupancy -> worms[id] == aworm) {
+      aworm -> id = id;
+      return RES_OK;
+    }
+  }
+  if (aoccupancy -> nworms == OCCUPANCY_MAX_WORMS) {
+    showDialog("Abbruch: Zu viele Wuermer", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  aworm -> id = ++aoccupancy -> nworms;
+  aoccupancy -> worms[aworm -> id] = aworm;
+  return RES_OK;
+}
+
+// Called by the worm model for the cell its head enters
+void setOccupant(struct board* aboard, int y, int x, struct worm* aworm, unsigned int ordinal) {
+  *getCell(aboard -> occupancy, y, x) = ((uint32_t) aworm -> id << OCCUPANCY_ORDINAL_BITS)
+    | (ordinal & OCCUPANCY_ORDINAL_MASK);
+}
+
+// Called by the worm model for a cell its tail leaves
+void clearOccupant(struct board* aboard, int y, int x) {
+  *getCell(aboard -> occupancy, y, x) = 0;
+}
+
+// The worm element in a cell; false if there is none or the board has no occupancy
+bool getOccupant(struct board* aboard, struct pos position, struct occupant* anoccupant) {
+  uint32_t cell;
+
+  if (aboard -> occupancy == NULL) {
+    return false;
+  }
+  cell = *getCell(aboard -> occupancy, position.y, position.x);
+  if (cell == 0) {
+    return false;
+  }
+  anoccupant -> worm = aboard -> occupancy -> worms[cell >> OCCUPANCY_ORDINAL_BITS];
+  anoccupant -> ordinal = cell & OCCUPANCY_ORDINAL_MASK;
+  return true;
+}
+
+// Number of ticks until a worm leaves the cell: 0 for cells without a worm.
+// This is a lower bound: food eaten in the meantime keeps the tail longer.
+// -1 for cells of a worm on boards without occupancy.
+int getTicksUntilFree(struct board* aboard, struct pos position) {
+  struct occupant theoccupant;
+
+  if (getOccupant(aboard, position, &theoccupant)) {
+    return getTicksUntilElementFree(theoccupant.worm, theoccupant.ordinal);
+  }
+  if (getContentAt(aboard, position) == BC_USED_BY_WORM) {
+    return -1;
+  }
+  return 0;
+}
+
+// Can a head that needs the given number of ticks to reach the cell enter it?
+bool isFreeAfterTicks(struct board* aboard, struct pos position, int ticks) {
+  int until_free;
+
+  if (getContentAt(aboard, position) == BC_BARRIER) {
+    return false;
+  }
+  until_free = getTicksUntilFree(aboard, position);
+  return until_free >= 0 && until_free <= ticks;
+}
@@ -0,0 +1,59 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Occupancy of the board: which worm is in a cell and which of its elements
+
+#ifndef _OCCUPANCY_H
+#define _OCCUPANCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "worm.h"
+#include "board_model.h"
+
+struct worm;  // See worm_model.h
+
+// A cell holds the id of a worm in the upper 8 bits and the ordinal of
+// the element in the lower 24 bits; 0 is a cell without a worm
+#define OCCUPANCY_ORDINAL_BITS 24
+#define OCCUPANCY_ORDINAL_MASK ((1u << OCCUPANCY_ORDINAL_BITS) - 1)
+#define OCCUPANCY_MAX_WORMS 255
+// Larger boards have no occupancy; a worm on them is shorter than 2^24 elements
+#define OCCUPANCY_MAX_CELLS (1L << OCCUPANCY_ORDINAL_BITS)
+
+// The worm and the element in a cell.
+// Elements are numbered in the order the head entered their cells, so an
+// element keeps its ordinal while the worm moves.
+struct occupant {
+    struct worm* worm;
+    unsigned int ordinal;
+};
+
+// One entry per cell, row by row.
+// The worm model keeps it up to date: showWorm() enters the head,
+// cleanWormTail() and removeWorm() free the cells they clear.
+struct occupancy
+{
+    int ncols;
+    uint32_t* cells;
+    int nworms;
+    struct worm* worms[OCCUPANCY_MAX_WORMS + 1];  // By id; id 0 is no worm
+    struct arena* arena;  // Memory of the cells: the arena of the board
+};
+
+extern enum ResCodes initializeOccupancy(struct occupancy* aoccupancy, struct board* aboard);
+extern void cleanupOccupancy(struct occupancy* aoccupancy, struct board* aboard);
+extern enum ResCodes addWormToOccupancy(struct occupancy* aoccupancy, struct worm* aworm);
+extern void setOccupant(struct board* aboard, int y, int x, struct worm* aworm, unsigned int ordinal);
+extern void clearOccupant(struct board* aboard, int y, int x);
+extern bool getOccupant(struct board* aboard, struct pos position, struct occupant* anoccupant);
+extern int getTicksUntilFree(struct board* aboard, struct pos position);
+extern bool isFreeAfterTicks(struct board* aboard, struct pos position, int ticks);
+
+#endif  // #define _OCCUPANCY_H
@@ -20,8 +20,8 @@
 #include "options.h"
 
 void usage() {
-    char buf[100];
-    sprintf(buf,"Aufruf: worm [-h] [-n ms] [-s]  [ Dateiname ]");
+    char buf[120];
+    sprintf(buf,"Aufruf: worm [-h] [-n ms] [-s] [-a|-A] [-p gewichte] [-g typ[:seed]] [-e seed] [-m] [-r] [-v]  [ Dateiname ]");
     showDialog(buf,"Bitte eine Taste druecken");
 }
 
@@ -34,9 +34,21 @@ enum ResCodes readCommandLineOptions(struct game_options* somegops, int argc, ch
     // Initialize;
     somegops -> nap_time = NAP_TIME;
     somegops -> start_single_step = 0;
+    somegops -> autopilot = false;
+    somegops -> autopilot_fill = false;
     somegops -> start_level_filename = NULL;
+    somegops -> policy_filename = NULL;
+    somegops -> generate_levels = false;
+    somegops -> level_type = LEVEL_CAVE;
+    somegops -> level_seed = 1;
+    somegops -> endless_world = false;
+    somegops -> world_seed = 1;
+    somegops -> show_minimap = false;
+    somegops -> show_overview = false;
+    somegops -> render_thread = false;
+    somegops -> vt_output = false;
 
-    while((c = getopt(argc, argv, "n:s")) != -1)
+    while((c = getopt(argc, argv, "n:saAp:g:e:mrv")) != -1)
         switch(c) {
             case('h'):
                 usage();
@@ -47,10 +59,54 @@ enum ResCodes readCommandLineOptions(struct game_options* somegops, int argc, ch
             case('s'):
                 somegops -> start_single_step = true;
                 continue;
+            case('a'):
+                somegops -> autopilot = true;
+                continue;
+            case('p'):
+                somegops -> policy_filename = strdup(optarg);
+                continue;
+            case('g'): {
+                // typ or typ:seed
+                char* colon = strchr(optarg, ':');
+                if (colon != NULL) {
+                    *colon = '\0';
+                    somegops -> level_seed = strtoul(colon + 1, NULL, 10);
+                }
+                if (getLevelType(optarg, &somegops -> level_type) != RES_OK) {
+                    usage();
+                    return RES_WRONG_OPTION;
+                }
+                somegops -> generate_levels = true;
+                continue;
+            }
+            case('e'):
+                somegops -> endless_world = true;
+                somegops -> world_seed = strtoul(optarg, NULL, 10);
+                continue;
+            case('m'):
+                somegops -> show_minimap = true;
+                continue;
+            case('r'):
+                somegops -> render_thread = true;
+                continue;
+            case('v'):
+                somegops -> vt_output = true;
+                continue;
+            case('A'):
+                somegops -> autopilot = true;
+                somegops -> autopilot_fill = true;
+                continue;
             default:
                 usage();
                 return RES_WRONG_OPTION;
         }
+    // The endless world has neither levels nor a board for autopilot and policy
+    if (somegops -> endless_world && (somegops -> autopilot || somegops -> policy_filename != NULL
+                                      || somegops -> generate_levels)) {
+        usage();
+        return RES_WRONG_OPTION;
+    }
+
     // Skip all options processed
     argc -= optind;
     argv += optind;
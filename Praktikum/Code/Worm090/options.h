@@ -14,13 +14,26 @@
 
 #include <stdbool.h>
 #include "worm.h"
+#include "levelgen.h"
 
 // A structure for the command line options
 struct game_options
 {
     int nap_time;               // Time in milliseconds to sleep at the end of level loop
     bool start_single_step;     // Start game in single step mode
+    bool autopilot;             // Worm is steered along a Hamiltonian cycle
+    bool autopilot_fill;        // Autopilot and worm grows until it fills the cycle
     char * start_level_filename;
+    char * policy_filename;     // Weights of a policy steering the worm; NULL if none
+    bool generate_levels;       // Endless campaign of generated levels
+    enum LevelTypes level_type; // Kind of the generated levels
+    unsigned long level_seed;   // Seed of the next generated level
+    bool endless_world;         // Play in the endless world instead of levels
+    unsigned long world_seed;   // Seed of the endless world
+    bool show_minimap;          // Minimap in the upper right corner (key 'm')
+    bool show_overview;         // Whole board downsampled to the viewport (key 'M')
+    bool render_thread;         // Output of the levels by a render thread
+    bool vt_output;             // Output of the levels by the raw VT backend instead of curses
 };
 
 extern void usage();
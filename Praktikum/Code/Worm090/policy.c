@@ -0,0 +1,521 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Inference of learned steering policies
+//
+// A policy is a small feed-forward network (dense layers and 3x3
+// convolutions) that maps a crop of the board around the worm's head to
+// one score per heading. Weights are read from a flat binary file:
+//
+//   char  magic[8]                  "WORMNN1"
+//   int   crop_size                 odd edge length of the crop
+//   int   nlayers
+//   per layer:
+//     int   type                    enum LayerTypes
+//     int   relu                    0 or 1
+//     int   a, b                    dense: nin, nout; conv: in_channels, out_channels
+//     float weights[], bias[]       see struct policy_layer
+//
+// All numbers are in native byte order.
+// Inputs of many games are evaluated as one batch, so each row of weights
+// is loaded once per batch. The inner products use AVX2/FMA or NEON if
+// available and fall back to plain C otherwise.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "policy.h"
+#include "bot.h"
+#include "messages.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Kernel for the inner product of two float vectors
+typedef float (*dot_kernel)(const float* a, const float* b, int n);
+// Kernel for the inner products of a with the four vectors b + j * stride.
+// Each element of a is loaded once for all four.
+typedef void (*dot4_kernel)(const float* a, const float* b, size_t stride, int n, float* sums);
+
+static float dotScalar(const float* a, const float* b, int n) {
+  float sum = 0.0f;
+  int i;
+  for (i = 0; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+static void dot4Scalar(const float* a, const float* b, size_t stride, int n, float* sums) {
+  int j;
+  for (j = 0; j < 4; j++) {
+    sums[j] = dotScalar(a, b + j * stride, n);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2,fma")))
+static float dotAVX2(const float* a, const float* b, int n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m128 s;
+  float sum;
+  int i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+  }
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+  }
+  acc0 = _mm256_add_ps(acc0, acc1);
+  s = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+  s = _mm_hadd_ps(s, s);
+  s = _mm_hadd_ps(s, s);
+  sum = _mm_cvtss_f32(s);
+  for (; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static void dot4AVX2(const float* a, const float* b, size_t stride, int n, float* sums) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  __m256 t;
+  int i = 0;
+  int j;
+
+  for (; i + 8 <= n; i += 8) {
+    __m256 va = _mm256_loadu_ps(a + i);
+    acc0 = _mm256_fmadd_ps(va, _mm256_loadu_ps(b + i), acc0);
+    acc1 = _mm256_fmadd_ps(va, _mm256_loadu_ps(b + stride + i), acc1);
+    acc2 = _mm256_fmadd_ps(va, _mm256_loadu_ps(b + 2 * stride + i), acc2);
+    acc3 = _mm256_fmadd_ps(va, _mm256_loadu_ps(b + 3 * stride + i), acc3);
+  }
+  // Lane j of the result is the sum of accj
+  t = _mm256_hadd_ps(_mm256_hadd_ps(acc0, acc1), _mm256_hadd_ps(acc2, acc3));
+  _mm_storeu_ps(sums, _mm_add_ps(_mm256_castps256_ps128(t), _mm256_extractf128_ps(t, 1)));
+  for (; i < n; i++) {
+    for (j = 0; j < 4; j++) {
+      sums[j] += a[i] * b[j * stride + i];
+    }
+  }
+}
+#endif
+
+#if defined(__ARM_NEON)
+static float dotNEON(const float* a, const float* b, int n) {
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  float32x2_t s;
+  float sum;
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+  }
+  s = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  sum = vget_lane_f32(vpadd_f32(s, s), 0);
+  for (; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+static void dot4NEON(const float* a, const float* b, size_t stride, int n, float* sums) {
+  float32x4_t acc[4];
+  int i = 0;
+  int j;
+
+  for (j = 0; j < 4; j++) {
+    acc[j] = vdupq_n_f32(0.0f);
+  }
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t va = vld1q_f32(a + i);
+    for (j = 0; j < 4; j++) {
+      acc[j] = vmlaq_f32(acc[j], va, vld1q_f32(b + j * stride + i));
+    }
+  }
+  for (j = 0; j < 4; j++) {
+    float32x2_t s = vadd_f32(vget_low_f32(acc[j]), vget_high_f32(acc[j]));
+    sums[j] = vget_lane_f32(vpadd_f32(s, s), 0);
+  }
+  for (; i < n; i++) {
+    for (j = 0; j < 4; j++) {
+      sums[j] += a[i] * b[j * stride + i];
+    }
+  }
+}
+#endif
+
+#define POLICY_TILE 8  // Inputs per tile of a dense layer
+
+static dot_kernel dot = NULL;
+static dot4_kernel dot4 = NULL;
+
+// Pick the fastest kernels supported by the CPU we are running on
+static void selectDotKernels() {
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    dot = dotAVX2;
+    dot4 = dot4AVX2;
+    return;
+  }
+#endif
+#if defined(__ARM_NEON)
+  dot = dotNEON;
+  dot4 = dot4NEON;
+  return;
+#endif
+  dot = dotScalar;
+  dot4 = dot4Scalar;
+}
+
+// Read count floats; returns NULL on error
+static float* readFloats(FILE* in, int count) {
+  float* values = malloc(count * sizeof(float));
+  if (values != NULL && fread(values, sizeof(float), count, in) != (size_t) count) {
+    free(values);
+    values = NULL;
+  }
+  return values;
+}
+
+// Load a policy from a weight file
+enum ResCodes loadPolicy(struct policy* apolicy, const char* filename) {
+  FILE* in;
+  char magic[sizeof(POLICY_MAGIC)];
+  char buf[100];
+  int cells;
+  int size;  // Output size of the previous layer
+  int l;
+  bool ok;
+
+  memset(apolicy, 0, sizeof(struct policy));
+  if (dot == NULL) {
+    selectDotKernels();
+  }
+
+  if ((in = fopen(filename, "rb")) == NULL) {
+    sprintf(buf, "Kann Datei %s nicht oeffnen", filename);
+    showDialog(buf, "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  ok = fread(magic, sizeof(magic), 1, in) == 1
+    && memcmp(magic, POLICY_MAGIC, sizeof(magic)) == 0
+    && fread(&apolicy -> crop_size, sizeof(int), 1, in) == 1
+    && fread(&apolicy -> nlayers, sizeof(int), 1, in) == 1
+    && apolicy -> crop_size > 0 && apolicy -> crop_size % 2 == 1
+    && apolicy -> nlayers > 0 && apolicy -> nlayers <= POLICY_MAX_LAYERS;
+
+  cells = apolicy -> crop_size * apolicy -> crop_size;
+  apolicy -> input_size = POLICY_CHANNELS * cells;
+  apolicy -> max_size = apolicy -> input_size;
+  size = apolicy -> input_size;
+
+  for (l = 0; ok && l < apolicy -> nlayers; l++) {
+    struct policy_layer* layer = &apolicy -> layers[l];
+    int type, relu, a, b;
+
+    ok = fread(&type, sizeof(int), 1, in) == 1
+      && fread(&relu, sizeof(int), 1, in) == 1
+      && fread(&a, sizeof(int), 1, in) == 1
+      && fread(&b, sizeof(int), 1, in) == 1
+      && a > 0 && b > 0;
+    if (!ok) {
+      break;
+    }
+    layer -> relu = relu != 0;
+    if (type == LAYER_DENSE) {
+      layer -> type = LAYER_DENSE;
+      layer -> nin = a;
+      layer -> nout = b;
+      layer -> weights = readFloats(in, a * b);
+      layer -> bias = readFloats(in, b);
+    } else if (type == LAYER_CONV3X3) {
+      layer -> type = LAYER_CONV3X3;
+      layer -> in_channels = a;
+      layer -> out_channels = b;
+      layer -> nin = a * cells;
+      layer -> nout = b * cells;
+      layer -> weights = readFloats(in, b * a * 9);
+      layer -> bias = readFloats(in, b);
+    } else {
+      ok = false;
+      break;
+    }
+    // Each layer consumes the output of its predecessor
+    ok = layer -> weights != NULL && layer -> bias != NULL && layer -> nin == size;
+    size = layer -> nout;
+    if (size > apolicy -> max_size) {
+      apolicy -> max_size = size;
+    }
+  }
+  fclose(in);
+
+  if (!ok || size != POLICY_OUTPUTS) {
+    cleanupPolicy(apolicy);
+    sprintf(buf, "Datei %s enthaelt keine gueltige Strategie", filename);
+    showDialog(buf, "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+void cleanupPolicy(struct policy* apolicy) {
+  int l;
+  for (l = 0; l < apolicy -> nlayers && l < POLICY_MAX_LAYERS; l++) {
+    free(apolicy -> layers[l].weights);
+    free(apolicy -> layers[l].bias);
+  }
+  free(apolicy -> inputs);
+  free(apolicy -> buffers[0]);
+  free(apolicy -> buffers[1]);
+  free(apolicy -> columns);
+  memset(apolicy, 0, sizeof(struct policy));
+}
+
+// Make sure the scratch memory holds a batch of the given size
+static enum ResCodes reserveScratch(struct policy* apolicy, int batch) {
+  int cells = apolicy -> crop_size * apolicy -> crop_size;
+  int max_columns = 0;
+  int l;
+
+  if (batch <= apolicy -> scratch_batch) {
+    return RES_OK;
+  }
+  for (l = 0; l < apolicy -> nlayers; l++) {
+    if (apolicy -> layers[l].type == LAYER_CONV3X3 && apolicy -> layers[l].in_channels * 9 > max_columns) {
+      max_columns = apolicy -> layers[l].in_channels * 9;
+    }
+  }
+  free(apolicy -> inputs);
+  free(apolicy -> buffers[0]);
+  free(apolicy -> buffers[1]);
+  free(apolicy -> columns);
+  apolicy -> inputs = malloc((size_t) batch * apolicy -> input_size * sizeof(float));
+  apolicy -> buffers[0] = malloc((size_t) batch * apolicy -> max_size * sizeof(float));
+  apolicy -> buffers[1] = malloc((size_t) batch * apolicy -> max_size * sizeof(float));
+  apolicy -> columns = malloc(((size_t) cells * max_columns + 1) * sizeof(float));
+  if (apolicy -> inputs == NULL || apolicy -> buffers[0] == NULL
+      || apolicy -> buffers[1] == NULL || apolicy -> columns == NULL) {
+    apolicy -> scratch_batch = 0;
+    return RES_FAILED;
+  }
+  apolicy -> scratch_batch = batch;
+  return RES_OK;
+}
+
+// Bias and ReLU for an output of a layer
+static float finishOutput(struct policy_layer* layer, int o, float sum) {
+  float v = layer -> bias[o] + sum;
+  return (layer -> relu && v < 0.0f) ? 0.0f : v;
+}
+
+// Fully connected layer for a batch of inputs.
+// The batch is split into tiles of POLICY_TILE inputs that stay in the L1 cache.
+// Within a tile the loop over the inputs is innermost: each row of weights is
+// loaded into registers once for four inputs.
+static void runDenseLayer(struct policy_layer* layer, const float* in, int batch, float* out) {
+  float sums[4];
+  int t, o, b, j;
+
+  for (t = 0; t < batch; t += POLICY_TILE) {
+    int end = t + POLICY_TILE < batch ? t + POLICY_TILE : batch;
+    for (o = 0; o < layer -> nout; o++) {
+      const float* w = layer -> weights + (size_t) o * layer -> nin;
+      for (b = t; b + 4 <= end; b += 4) {
+        dot4(w, in + (size_t) b * layer -> nin, layer -> nin, layer -> nin, sums);
+        for (j = 0; j < 4; j++) {
+          out[(size_t) (b + j) * layer -> nout + o] = finishOutput(layer, o, sums[j]);
+        }
+      }
+      for (; b < end; b++) {
+        out[(size_t) b * layer -> nout + o]
+          = finishOutput(layer, o, dot(w, in + (size_t) b * layer -> nin, layer -> nin));
+      }
+    }
+  }
+}
+
+// 3x3 convolution; the neighbourhoods are unfolded so that each output is one inner product
+static void runConvLayer(struct policy_layer* layer, int crop_size, const float* in, int batch,
+                         float* out, float* columns) {
+  int cells = crop_size * crop_size;
+  int ncol = layer -> in_channels * 9;
+  int b, c, y, x, ky, kx, o, p;
+
+  for (b = 0; b < batch; b++) {
+    const float* src = in + (size_t) b * layer -> nin;
+    float* dst = out + (size_t) b * layer -> nout;
+
+    for (y = 0; y < crop_size; y++) {
+      for (x = 0; x < crop_size; x++) {
+        float* col = columns + (size_t) (y * crop_size + x) * ncol;
+        for (c = 0; c < layer -> in_channels; c++) {
+          for (ky = 0; ky < 3; ky++) {
+            for (kx = 0; kx < 3; kx++) {
+              int sy = y + ky - 1;
+              int sx = x + kx - 1;
+              *col++ = (sy < 0 || sy >= crop_size || sx < 0 || sx >= crop_size)
+                ? 0.0f : src[c * cells + sy * crop_size + sx];
+            }
+          }
+        }
+      }
+    }
+    // Four neighbourhoods at a time share the loads of the weights
+    for (o = 0; o < layer -> out_channels; o++) {
+      const float* w = layer -> weights + (size_t) o * ncol;
+      float sums[4];
+      for (p = 0; p + 4 <= cells; p += 4) {
+        dot4(w, columns + (size_t) p * ncol, ncol, ncol, sums);
+        for (c = 0; c < 4; c++) {
+          dst[o * cells + p + c] = finishOutput(layer, o, sums[c]);
+        }
+      }
+      for (; p < cells; p++) {
+        dst[o * cells + p] = finishOutput(layer, o, dot(w, columns + (size_t) p * ncol, ncol));
+      }
+    }
+  }
+}
+
+// Evaluate the network for batch inputs of size input_size each.
+// outputs receives POLICY_OUTPUTS scores per input.
+enum ResCodes runPolicyBatch(struct policy* apolicy, const float* inputs, int batch,
+                             float* outputs) {
+  const float* in = inputs;
+  int l;
+
+  if (reserveScratch(apolicy, batch) != RES_OK) {
+    return RES_FAILED;
+  }
+  for (l = 0; l < apolicy -> nlayers; l++) {
+    struct policy_layer* layer = &apolicy -> layers[l];
+    float* out = l == apolicy -> nlayers - 1 ? outputs : apolicy -> buffers[l % 2];
+
+    if (layer -> type == LAYER_DENSE) {
+      runDenseLayer(layer, in, batch, out);
+    } else {
+      runConvLayer(layer, apolicy -> crop_size, in, batch, out, apolicy -> columns);
+    }
+    in = out;
+  }
+  return RES_OK;
+}
+
+// Encode the crop of the board centered at the worm's head.
+// Cells outside of the board count as obstacles.
+void fillPolicyInput(struct policy* apolicy, struct board* aboard, struct worm* aworm,
+                     float* input) {
+  struct pos headpos = getWormHeadPos(aworm);
+  int half = apolicy -> crop_size / 2;
+  int cells = apolicy -> crop_size * apolicy -> crop_size;
+  int cy, cx;
+
+  memset(input, 0, apolicy -> input_size * sizeof(float));
+  for (cy = 0; cy < apolicy -> crop_size; cy++) {
+    for (cx = 0; cx < apolicy -> crop_size; cx++) {
+      int y = headpos.y + cy - half;
+      int x = headpos.x + cx - half;
+      int i = cy * apolicy -> crop_size + cx;
+
+      if (y < 0 || y > aboard -> last_row || x < 0 || x > aboard -> last_col) {
+        input[i] = 1.0f;
+        continue;
+      }
+      switch (getCellAt(aboard, y, x)) {
+        case BC_BARRIER:
+          input[i] = 1.0f;
+          break;
+        case BC_USED_BY_WORM:
+          input[cells + i] = 1.0f;
+          break;
+        case BC_FOOD_1:
+          input[2 * cells + i] = 1.0f;
+          break;
+        case BC_FOOD_2:
+          input[3 * cells + i] = 1.0f;
+          break;
+        case BC_FOOD_3:
+          input[4 * cells + i] = 1.0f;
+          break;
+        default: {}
+      }
+    }
+  }
+}
+
+// Choose the headings of n worms on their boards with one batched evaluation.
+// rngs == NULL: the heading with the highest score wins.
+// Else the heading of worm i is drawn from the softmax of its scores with the
+// generator rngs[i], so games on the same level differ from each other.
+enum ResCodes choosePolicyHeadings(struct policy* apolicy, struct board** boards,
+                                   struct worm** worms, int n, uint32_t* rngs,
+                                   enum WormHeading* headings) {
+  float* outputs;
+  int i, k;
+
+  if (n <= 0) {
+    return RES_OK;
+  }
+  if (reserveScratch(apolicy, n) != RES_OK) {
+    return RES_FAILED;
+  }
+  for (i = 0; i < n; i++) {
+    fillPolicyInput(apolicy, boards[i], worms[i], apolicy -> inputs + (size_t) i * apolicy -> input_size);
+  }
+  outputs = malloc((size_t) n * POLICY_OUTPUTS * sizeof(float));
+  if (outputs == NULL || runPolicyBatch(apolicy, apolicy -> inputs, n, outputs) != RES_OK) {
+    free(outputs);
+    return RES_FAILED;
+  }
+  for (i = 0; i < n; i++) {
+    float* scores = outputs + i * POLICY_OUTPUTS;
+    float weights[POLICY_OUTPUTS];
+    float sum = 0.0f;
+    float u;
+    int best = 0;
+
+    for (k = 1; k < POLICY_OUTPUTS; k++) {
+      if (scores[k] > scores[best]) {
+        best = k;
+      }
+    }
+    if (rngs != NULL) {
+      for (k = 0; k < POLICY_OUTPUTS; k++) {
+        weights[k] = expf(scores[k] - scores[best]);
+        sum += weights[k];
+      }
+      u = sum * (nextRandom(&rngs[i]) >> 8) / (float) (1 << 24);
+      for (k = 0; k < POLICY_OUTPUTS - 1 && u >= weights[k]; k++) {
+        u -= weights[k];
+      }
+      best = k;
+    }
+    headings[i] = (enum WormHeading) best;
+  }
+  free(outputs);
+  return RES_OK;
+}
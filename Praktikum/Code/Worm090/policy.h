@@ -0,0 +1,71 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Inference of learned steering policies
+
+#ifndef _POLICY_H
+#define _POLICY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+
+#define POLICY_MAGIC "WORMNN1"   // First 8 bytes of a weight file
+#define POLICY_CHANNELS 5        // Input planes: obstacle, worm, food 1, food 2, food 3
+#define POLICY_OUTPUTS 4         // One score per enum WormHeading
+#define POLICY_MAX_LAYERS 16
+
+// Types of layers
+enum LayerTypes {
+    LAYER_DENSE,    // Fully connected: nin -> nout
+    LAYER_CONV3X3,  // 3x3 convolution with zero padding on the crop_size x crop_size grid
+};
+
+// A layer of the network
+struct policy_layer
+{
+    enum LayerTypes type;
+    bool relu;         // Apply ReLU to the outputs
+    int in_channels;   // Only for LAYER_CONV3X3
+    int out_channels;  // Only for LAYER_CONV3X3
+    int nin;           // Number of inputs
+    int nout;          // Number of outputs
+    float* weights;    // Dense: nout x nin; conv: out_channels x (in_channels * 9)
+    float* bias;       // Dense: nout; conv: out_channels
+};
+
+// A policy structure
+struct policy
+{
+    int crop_size;     // Edge length of the crop around the worm's head (odd)
+    int input_size;    // POLICY_CHANNELS * crop_size * crop_size
+    int nlayers;
+    struct policy_layer layers[POLICY_MAX_LAYERS];
+
+    // Scratch memory for batches of up to scratch_batch games
+    int scratch_batch;
+    int max_size;      // Largest input or output of any layer
+    float* inputs;
+    float* buffers[2];
+    float* columns;    // Unfolded 3x3 neighbourhoods for convolutions
+};
+
+extern enum ResCodes loadPolicy(struct policy* apolicy, const char* filename);
+extern void cleanupPolicy(struct policy* apolicy);
+extern void fillPolicyInput(struct policy* apolicy, struct board* aboard, struct worm* aworm,
+                            float* input);
+extern enum ResCodes runPolicyBatch(struct policy* apolicy, const float* inputs, int batch,
+                                    float* outputs);
+extern enum ResCodes choosePolicyHeadings(struct policy* apolicy, struct board** boards,
+                                          struct worm** worms, int n, uint32_t* rngs,
+                                          enum WormHeading* headings);
+
+#endif  // #define _POLICY_H
@@ -10,6 +10,7 @@
 // Basic functions for initialization and cleanup of curses applications
 
 #include <curses.h>
+#include "worm.h"
 #include "prep.h"
 
 // Initialize application with respect to curses settings
@@ -29,6 +30,18 @@ void initializeCursesApplication() {
     nodelay(stdscr, TRUE);  // make getch to be a non-blocking call
 }
 
+// Initialize colors of the game
+void initializeColors() {
+    // Define colors of the game
+    start_color();
+    init_pair(COLP_USER_WORM, COLOR_GREEN,   COLOR_BLACK);
+    init_pair(COLP_FREE_CELL, COLOR_BLACK,   COLOR_BLACK);
+    init_pair(COLP_FOOD_1,    COLOR_YELLOW,  COLOR_BLACK);
+    init_pair(COLP_FOOD_2,    COLOR_MAGENTA, COLOR_BLACK);
+    init_pair(COLP_FOOD_3,    COLOR_CYAN,    COLOR_BLACK);
+    init_pair(COLP_BARRIER,   COLOR_RED,     COLOR_BLACK);
+}
+
 // Reset display to normale state and terminate curses application
 void cleanupCursesApp(void)
 {
@@ -13,6 +13,7 @@
 #define _PREP_H
 
 extern void initializeCursesApplication(); 
+extern void initializeColors();
 extern void cleanupCursesApp(void);
 
 #endif  // #define _PREP_H
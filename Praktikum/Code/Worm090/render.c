@@ -0,0 +1,424 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Output to the display, optionally by a render thread
+//
+// Without a render thread the functions below call curses directly.
+// With a render thread (option -r) the simulation only fills a queue of
+// changed cells and never waits for the terminal. The render thread
+// applies the changes to the virtual screen of curses; a frame is written
+// to the terminal by refresh() only if no newer frame is complete yet.
+// So a slow terminal costs frames, not ticks.
+//
+// Backpressure: before a frame is written the render thread looks at the
+// bytes still waiting in the output queue of the tty (TIOCOUTQ) and after
+// it at the time refresh() took. If the terminal is behind, the time
+// between two frames doubles up to RENDER_MAX_INTERVAL_USEC; it halves
+// again with every fast frame. refresh() then rarely blocks on a full tty.
+//
+// Both ways write to curses or, with option -v, to the raw VT backend
+// (see vt.c); putCell() and flushScreen() choose.
+
+#include <curses.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include "worm.h"
+#include "messages.h"
+#include "render.h"
+#include "vt.h"
+
+// The running render thread; NULL: output by the calling thread
+static struct renderer* active_renderer = NULL;
+// The raw VT backend; NULL: curses
+static struct vt_screen* active_vt = NULL;
+
+// Output backends
+// ********************************************************************************************
+
+// Use the VT backend instead of curses; NULL switches back.
+// Must not be called while a render thread runs.
+void setVtScreen(struct vt_screen* avt) {
+  active_vt = avt;
+}
+
+static void putCell(int y, int x, chtype ch) {
+  if (active_vt != NULL) {
+    putVtCell(active_vt, y, x, ch);
+  } else {
+    mvaddch(y, x, ch);
+  }
+}
+
+static void flushScreen() {
+  if (active_vt != NULL) {
+    showVtFrame(active_vt);
+  } else {
+    refresh();
+  }
+}
+
+// Queues
+// ********************************************************************************************
+
+// Called by the producer only
+static bool pushOp(struct render_queue* q, struct render_op op) {
+  unsigned tail = atomic_load_explicit(&q -> tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&q -> head, memory_order_acquire);
+
+  if (tail - head == RENDER_QUEUE_SIZE) {
+    return false;
+  }
+  q -> slots[tail & (RENDER_QUEUE_SIZE - 1)] = op;
+  atomic_store_explicit(&q -> tail, tail + 1, memory_order_release);
+  return true;
+}
+
+// Number of queued operations; called by the producer
+static unsigned getQueueFill(struct render_queue* q) {
+  return atomic_load_explicit(&q -> tail, memory_order_relaxed)
+    - atomic_load_explicit(&q -> head, memory_order_acquire);
+}
+
+// Called by the consumer only
+static bool popOp(struct render_queue* q, struct render_op* op) {
+  unsigned head = atomic_load_explicit(&q -> head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&q -> tail, memory_order_acquire);
+
+  if (head == tail) {
+    return false;
+  }
+  *op = q -> slots[head & (RENDER_QUEUE_SIZE - 1)];
+  atomic_store_explicit(&q -> head, head + 1, memory_order_release);
+  return true;
+}
+
+static bool pushKey(struct key_queue* q, int key) {
+  unsigned tail = atomic_load_explicit(&q -> tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&q -> head, memory_order_acquire);
+
+  if (tail - head == KEY_QUEUE_SIZE) {
+    return false;
+  }
+  q -> slots[tail & (KEY_QUEUE_SIZE - 1)] = key;
+  atomic_store_explicit(&q -> tail, tail + 1, memory_order_release);
+  return true;
+}
+
+// ERR if there is no key
+static int popKey(struct key_queue* q) {
+  unsigned head = atomic_load_explicit(&q -> head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&q -> tail, memory_order_acquire);
+  int key;
+
+  if (head == tail) {
+    return ERR;
+  }
+  key = q -> slots[head & (KEY_QUEUE_SIZE - 1)];
+  atomic_store_explicit(&q -> head, head + 1, memory_order_release);
+  return key;
+}
+
+// Render thread
+// ********************************************************************************************
+
+static long getMicroseconds() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000L + t.tv_nsec / 1000;
+}
+
+// Bytes written to the terminal that it has not taken yet
+static int getOutputQueue() {
+  int n;
+  if (ioctl(STDOUT_FILENO, TIOCOUTQ, &n) != 0) {
+    return 0;  // Not a tty
+  }
+  return n;
+}
+
+static void adaptInterval(struct renderer* arenderer, bool behind, long took, long now) {
+  if (behind) {
+    arenderer -> interval = arenderer -> interval > 0 ? 2 * arenderer -> interval : RENDER_SLOW_USEC;
+    if (arenderer -> interval < 2 * took) {
+      arenderer -> interval = 2 * took;
+    }
+    if (arenderer -> interval > RENDER_MAX_INTERVAL_USEC) {
+      arenderer -> interval = RENDER_MAX_INTERVAL_USEC;
+    }
+  } else {
+    arenderer -> interval /= 2;
+    if (arenderer -> interval < RENDER_IDLE_USEC) {
+      arenderer -> interval = 0;
+    }
+  }
+  arenderer -> next_show = now + arenderer -> interval;
+  atomic_store(&arenderer -> backpressure, arenderer -> interval > 0);
+}
+
+// Write the virtual screen to the terminal unless the terminal is behind.
+// Returns false if the frame has to wait.
+static bool showLatestFrame(struct renderer* arenderer) {
+  long start = getMicroseconds();
+  long took;
+
+  if (start < arenderer -> next_show) {
+    return false;
+  }
+  if (getOutputQueue() > RENDER_MAX_OUTQ) {
+    adaptInterval(arenderer, true, 0, start);
+    return false;
+  }
+  flushScreen();
+  took = getMicroseconds() - start;
+  adaptInterval(arenderer, took > RENDER_SLOW_USEC, took, start + took);
+  return true;
+}
+
+static void* runRenderer(void* arg) {
+  struct renderer* arenderer = arg;
+  unsigned frames_done = 0;
+  bool unshown = false;  // The last complete frame was not written yet
+  bool partial = false;  // Changes of the next frame were applied
+  struct render_op op;
+  int key;
+
+  for (;;) {
+    // Read before draining: after the stop all frames are in the queue
+    bool stop = atomic_load(&arenderer -> stop);
+    bool busy = false;
+
+    while (popOp(&arenderer -> ops, &op)) {
+      busy = true;
+      if (op.y >= 0) {
+        putCell(op.y, op.x, op.ch);
+        partial = true;
+        continue;
+      }
+      // End of a frame: show it unless a newer frame is already queued
+      frames_done++;
+      partial = false;
+      unshown = frames_done != atomic_load(&arenderer -> frames_queued)
+        || !showLatestFrame(arenderer);
+    }
+    // A frame that had to wait is shown as soon as the terminal caught up
+    if (unshown && !partial && showLatestFrame(arenderer)) {
+      unshown = false;
+      busy = true;
+    }
+    if ((key = wgetch(arenderer -> keywin)) != ERR) {
+      pushKey(&arenderer -> keys, key);  // Keys beyond KEY_QUEUE_SIZE are dropped
+      busy = true;
+    }
+    if (stop) {
+      flushScreen();
+      break;
+    }
+    if (!busy) {
+      usleep(RENDER_IDLE_USEC);
+    }
+  }
+  return NULL;
+}
+
+// Simulation side of the merging
+// ********************************************************************************************
+
+// Keep the latest change of a screen cell until it can be queued
+static void mergeCell(struct renderer* arenderer, int y, int x, chtype ch) {
+  int i;
+
+  if (y < 0 || y >= arenderer -> nrows || x < 0 || x >= arenderer -> ncols) {
+    return;
+  }
+  i = y * arenderer -> ncols + x;
+  if (arenderer -> pending[i] == 0) {
+    arenderer -> dirty[arenderer -> ndirty++] = i;
+  }
+  arenderer -> pending[i] = ch;
+}
+
+// Queue all merged changes; returns false if there is no room for them.
+// With wait set it waits for the render thread instead.
+static bool queuePending(struct renderer* arenderer, bool wait) {
+  int k;
+
+  if (!wait && RENDER_QUEUE_SIZE - getQueueFill(&arenderer -> ops) <= arenderer -> ndirty) {
+    return false;
+  }
+  for (k = 0; k < arenderer -> ndirty; k++) {
+    int i = arenderer -> dirty[k];
+    struct render_op op = { i / arenderer -> ncols, i % arenderer -> ncols, arenderer -> pending[i] };
+    while (!pushOp(&arenderer -> ops, op)) {
+      usleep(RENDER_IDLE_USEC);
+    }
+    arenderer -> pending[i] = 0;
+  }
+  arenderer -> ndirty = 0;
+  return true;
+}
+
+// Start the render thread; from now on the calling thread must not call curses
+enum ResCodes startRenderer(struct renderer* arenderer) {
+  arenderer -> ops.slots = malloc(RENDER_QUEUE_SIZE * sizeof(struct render_op));
+  if (arenderer -> ops.slots == NULL) {
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  atomic_init(&arenderer -> ops.head, 0);
+  atomic_init(&arenderer -> ops.tail, 0);
+  atomic_init(&arenderer -> keys.head, 0);
+  atomic_init(&arenderer -> keys.tail, 0);
+  atomic_init(&arenderer -> frames_queued, 0);
+  atomic_init(&arenderer -> stop, false);
+  atomic_init(&arenderer -> backpressure, false);
+  arenderer -> keys_blocking = !is_nodelay(stdscr);
+  arenderer -> interval = 0;
+  arenderer -> next_show = 0;
+  arenderer -> ndirty = 0;
+  arenderer -> ticks = 0;
+  arenderer -> nrows = LINES;
+  arenderer -> ncols = COLS;
+  arenderer -> pending = calloc(LINES * COLS, sizeof(chtype));
+  arenderer -> dirty = malloc(LINES * COLS * sizeof(int));
+  if (arenderer -> pending == NULL || arenderer -> dirty == NULL) {
+    free(arenderer -> pending);
+    free(arenderer -> dirty);
+    free(arenderer -> ops.slots);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+
+  // A window that is never written: wgetch() on stdscr would refresh
+  // a frame that is only partly drawn
+  arenderer -> keywin = newwin(1, 1, 0, 0);
+  if (arenderer -> keywin == NULL) {
+    free(arenderer -> pending);
+    free(arenderer -> dirty);
+    free(arenderer -> ops.slots);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  untouchwin(arenderer -> keywin);
+  keypad(arenderer -> keywin, TRUE);
+  nodelay(arenderer -> keywin, TRUE);
+
+  if (pthread_create(&arenderer -> thread, NULL, runRenderer, arenderer) != 0) {
+    delwin(arenderer -> keywin);
+    free(arenderer -> pending);
+    free(arenderer -> dirty);
+    free(arenderer -> ops.slots);
+    showDialog("Abbruch: Kann keinen Thread starten", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  active_renderer = arenderer;
+  return RES_OK;
+}
+
+// Show all queued output and stop the render thread
+void stopRenderer(struct renderer* arenderer) {
+  active_renderer = NULL;
+  queuePending(arenderer, true);
+  atomic_store(&arenderer -> stop, true);
+  pthread_join(arenderer -> thread, NULL);
+  delwin(arenderer -> keywin);
+  nodelay(stdscr, !arenderer -> keys_blocking);
+  free(arenderer -> pending);
+  free(arenderer -> dirty);
+  free(arenderer -> ops.slots);
+}
+
+// Output and input
+// ********************************************************************************************
+
+// Show ch (a symbol with its color pair) at (y,x) of the display
+void drawCell(int y, int x, chtype ch) {
+  if (active_renderer == NULL) {
+    putCell(y, x, ch);
+    return;
+  }
+  struct render_op op = { y, x, ch };
+  // Changes are merged once the queue is half full, and until the
+  // merged changes are queued, so they never overtake older ones
+  if (active_renderer -> ndirty > 0 || getQueueFill(&active_renderer -> ops) >= RENDER_MERGE_FILL) {
+    mergeCell(active_renderer, y, x, ch);
+    return;
+  }
+  pushOp(&active_renderer -> ops, op);
+}
+
+void drawText(int y, int x, const char* text) {
+  for (; *text != '\0'; text++, x++) {
+    drawCell(y, x, (unsigned char) *text);
+  }
+}
+
+// Queue the changes up to now as a frame if there is room
+static void queueFrame() {
+  struct render_op op = { -1, 0, 0 };
+  // Merged ticks stay pending until they fit into the queue as one frame.
+  // Only if they cover most of the screen the simulation waits.
+  if (active_renderer -> ndirty > 0
+      && !queuePending(active_renderer, active_renderer -> ndirty >= RENDER_MERGE_FILL)) {
+    return;
+  }
+  if (getQueueFill(&active_renderer -> ops) == RENDER_QUEUE_SIZE) {
+    return;  // The changes are shown with the next frame
+  }
+  // Counted first: the render thread compares with it when it reaches the end
+  atomic_fetch_add(&active_renderer -> frames_queued, 1);
+  pushOp(&active_renderer -> ops, op);
+}
+
+// End of the output of a tick
+void showFrame() {
+  if (active_renderer == NULL) {
+    flushScreen();
+    return;
+  }
+  active_renderer -> ticks++;
+  queueFrame();
+}
+
+// Next key of the user; ERR if there is none and keys are not blocking
+int readKey() {
+  int key;
+
+  if (active_renderer == NULL) {
+    return getch();
+  }
+  while ((key = popKey(&active_renderer -> keys)) == ERR && active_renderer -> keys_blocking) {
+    // Single step: the tick must be visible while we wait
+    if (active_renderer -> ndirty > 0) {
+      queueFrame();
+    }
+    usleep(RENDER_IDLE_USEC);
+  }
+  return key;
+}
+
+// While the terminal is behind, the status lines are drawn every
+// RENDER_STATUS_TICKS ticks only. Ticks are counted on their own:
+// frames_queued stands still while the changes of several ticks are merged.
+bool isStatusDue() {
+  if (active_renderer == NULL || !atomic_load(&active_renderer -> backpressure)) {
+    return true;
+  }
+  return active_renderer -> ticks % RENDER_STATUS_TICKS == 0;
+}
+
+// Single step mode: readKey() waits for the next key
+void setKeyBlocking(bool blocking) {
+  if (active_renderer == NULL) {
+    nodelay(stdscr, !blocking);
+    return;
+  }
+  active_renderer -> keys_blocking = blocking;
+}
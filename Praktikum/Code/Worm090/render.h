@@ -0,0 +1,108 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Output to the display, optionally by a render thread
+
+#ifndef _RENDER_H
+#define _RENDER_H
+
+#include <curses.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "worm.h"
+
+#define RENDER_QUEUE_SIZE (1 << 16)  // Capacity of the queue of cell changes (power of 2)
+#define KEY_QUEUE_SIZE 64            // Capacity of the queue of keys (power of 2)
+#define RENDER_IDLE_USEC 1000        // Sleep of the render thread if there is nothing to do
+
+// Backpressure of the terminal
+#define RENDER_MERGE_FILL (RENDER_QUEUE_SIZE / 2)  // Above this fill the simulation merges ticks
+#define RENDER_SLOW_USEC 20000       // A refresh() taking longer means the terminal is behind
+#define RENDER_MAX_OUTQ 4096         // As do more bytes waiting for the terminal
+#define RENDER_MAX_INTERVAL_USEC 500000  // Longest time between two frames
+#define RENDER_STATUS_TICKS 10       // The status is drawn every n-th tick while the terminal is behind
+
+// A changed cell of the display: symbol with its color pair.
+// An operation with y < 0 ends the frame of a tick.
+struct render_op {
+    int16_t y;
+    int16_t x;
+    chtype ch;
+};
+
+// Lock-free queues for one producer and one consumer
+struct render_queue
+{
+    struct render_op* slots;
+    atomic_uint head;        // Next slot to read; written by the consumer only
+    atomic_uint tail;        // Next slot to write; written by the producer only
+};
+
+struct key_queue
+{
+    int slots[KEY_QUEUE_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+};
+
+// The render thread owns all curses calls while it runs.
+// The simulation queues the changed cells of each tick and ends the tick
+// with showFrame(). The render thread applies all queued changes, but
+// refreshes the terminal only for the last complete frame, so a slow
+// terminal drops intermediate frames instead of stretching the tick.
+// Keys travel the other way through a second queue.
+//
+// If the terminal falls behind (slow refresh() or many bytes in the output
+// queue of the tty) the render thread shows frames less often and the
+// status lines are drawn less often. If the queue fills up nevertheless,
+// the simulation merges the changes of several ticks per screen cell and
+// queues them as one frame when there is room again. The last frame is
+// always shown.
+struct renderer
+{
+    struct render_queue ops;      // Simulation -> render thread
+    struct key_queue keys;        // Render thread -> simulation
+    atomic_uint frames_queued;    // Frames ended by the simulation
+    atomic_bool stop;
+    atomic_bool backpressure;     // The terminal is behind
+
+    // Simulation: changes not queued yet, by screen cell; 0 if none
+    chtype* pending;
+    int* dirty;                   // Screen cells with pending changes
+    int ndirty;
+    unsigned int ticks;           // Ticks ended with showFrame()
+    int nrows;                    // Size of the screen
+    int ncols;
+
+    // Render thread: pacing of the frames
+    long interval;                // Minimal time between two frames in microseconds
+    long next_show;               // Earliest time for the next frame
+
+    bool keys_blocking;           // Single step: readKey() waits for a key
+    WINDOW* keywin;               // Reads the keys without refreshing stdscr
+    pthread_t thread;
+};
+
+struct vt_screen;  // See vt.h
+
+extern void setVtScreen(struct vt_screen* avt);
+extern enum ResCodes startRenderer(struct renderer* arenderer);
+extern void stopRenderer(struct renderer* arenderer);
+
+// Output and input of the game; through the render thread if one runs
+extern void drawCell(int y, int x, chtype ch);
+extern void drawText(int y, int x, const char* text);
+extern void showFrame();
+extern int readKey();
+extern void setKeyBlocking(bool blocking);
+extern bool isStatusDue();
+
+#endif  // #define _RENDER_H
@@ -0,0 +1,383 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Headless games for batch simulation
+//
+// A headless game runs the same loop as doLevel() on a copy of a level
+// that was loaded once, with a bot, a learned policy or the autopilot
+// instead of the user.
+// No curses calls are made, so games may run in parallel threads.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "bot.h"
+#include "autopilot.h"
+#include "sim.h"
+#include "hazards.h"
+#include "distance_oracle.h"
+#include "occupancy.h"
+#include "policy.h"
+
+// Load a level into a headless board.
+// nrows: number of rows of the board; ncols <= 0: width of the level file
+enum ResCodes loadHeadlessLevel(struct board* aboard, const char* filename,
+                                int nrows, int ncols) {
+  if (ncols <= 0) {
+    ncols = getLevelFileWidth(filename);
+  }
+  if (initializeHeadlessBoard(aboard, nrows, ncols) != RES_OK) {
+    return RES_FAILED;
+  }
+  if (initializeLevelFromFile(aboard, filename) != RES_OK) {
+    cleanupBoard(aboard);
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+// Load a level and its distance oracle; the oracle is read from the cache
+// next to the level file or built and stored there
+enum ResCodes loadHeadlessLevelWithOracle(struct board* aboard, struct distance_oracle* oracle,
+                                          const char* filename, int nrows, int ncols) {
+  if (loadHeadlessLevel(aboard, filename, nrows, ncols) != RES_OK) {
+    return RES_FAILED;
+  }
+  if (loadOrBuildDistanceOracle(oracle, aboard, filename) != RES_OK) {
+    cleanupBoard(aboard);
+    return RES_FAILED;
+  }
+  return RES_OK;
+}
+
+// Seed of game number game on level number level.
+// Every genome or bot plays the same games for the same base seed.
+uint32_t getGameSeed(uint32_t base_seed, int level, int game) {
+  uint32_t h = base_seed * 2654435761u;
+  h = (h ^ (uint32_t) level) * 2246822519u;
+  h = (h ^ (uint32_t) game) * 3266489917u;
+  return h ^ (h >> 15);
+}
+
+// Play one game on a copy of level with a bot using params.
+// The copy gets an occupancy, so the bot knows when the tail frees a cell.
+enum ResCodes runHeadlessGame(struct board* level, const float* params, uint32_t seed,
+                              int max_ticks, struct game_result* result) {
+  struct board theboard;
+  struct worm theworm;
+  struct bot thebot;
+  struct occupancy theoccupancy;
+  struct pos bottomLeft;
+  enum GameStates game_state = WORM_GAME_ONGOING;
+  enum ResCodes res = RES_OK;
+  int food_start;
+
+  if (copyBoard(&theboard, level) != RES_OK) {
+    return RES_FAILED;
+  }
+  if (initializeBot(&thebot, params, seed, &theboard) != RES_OK) {
+    cleanupBoard(&theboard);
+    return RES_FAILED;
+  }
+  bottomLeft.y = getLastRowOnBoard(&theboard);
+  bottomLeft.x = 0;
+  if (initializeWorm(&theworm, NULL, (theboard.last_row + 1) * (theboard.last_col + 1),
+                     WORM_INITIAL_LENGTH, bottomLeft, WORM_RIGHT, COLP_USER_WORM) != RES_OK) {
+    cleanupBot(&thebot);
+    cleanupBoard(&theboard);
+    return RES_FAILED;
+  }
+  if (initializeOccupancy(&theoccupancy, &theboard) != RES_OK
+      || addWormToOccupancy(&theoccupancy, &theworm) != RES_OK) {
+    cleanupOccupancy(&theoccupancy, &theboard);
+    cleanupWorm(&theworm);
+    cleanupBot(&thebot);
+    cleanupBoard(&theboard);
+    return RES_FAILED;
+  }
+  food_start = getNumberOfFoodItems(&theboard);
+  res = showWorm(&theboard, &theworm);
+
+  result -> ticks = 0;
+  while (res == RES_OK && result -> ticks < max_ticks && getNumberOfFoodItems(&theboard) > 0) {
+    setWormHeading(&theworm, getBotHeading(&thebot, &theboard, &theworm));
+    cleanWormTail(&theboard, &theworm);
+    moveWorm(&theboard, &theworm, &game_state);
+    result -> ticks++;
+    if (game_state != WORM_GAME_ONGOING) {
+      break;
+    }
+    if (showWorm(&theboard, &theworm) != RES_OK || updateHazards(&theboard) != RES_OK) {
+      res = RES_FAILED;
+    }
+  }
+
+  result -> state = game_state;
+  result -> cleared = getNumberOfFoodItems(&theboard) == 0;
+  result -> food_eaten = food_start - getNumberOfFoodItems(&theboard);
+  result -> length = getWormLength(&theworm);
+
+  cleanupOccupancy(&theoccupancy, &theboard);
+  cleanupWorm(&theworm);
+  cleanupBot(&thebot);
+  cleanupBoard(&theboard);
+  return res;
+}
+
+// Play one game on a copy of level with the autopilot, as doLevel() does
+// with -a (fill == false) or -A (fill == true)
+enum ResCodes runAutopilotGame(struct board* level, bool fill, int max_ticks,
+                               struct autopilot_result* result) {
+  struct board theboard;
+  struct worm theworm;
+  struct autopilot thepilot;
+  struct pos bottomLeft;
+  enum GameStates game_state = WORM_GAME_ONGOING;
+  enum ResCodes res = RES_OK;
+  int food_start;
+
+  if (copyBoard(&theboard, level) != RES_OK) {
+    return RES_FAILED;
+  }
+  bottomLeft.y = getLastRowOnBoard(&theboard);
+  bottomLeft.x = 0;
+  if (initializeAutopilot(&thepilot, &theboard, bottomLeft, !fill) != RES_OK) {
+    cleanupBoard(&theboard);
+    return RES_FAILED;
+  }
+  if (initializeWorm(&theworm, NULL, getCycleLength(&thepilot), WORM_INITIAL_LENGTH,
+                     bottomLeft, WORM_RIGHT, COLP_USER_WORM) != RES_OK) {
+    cleanupAutopilot(&thepilot);
+    cleanupBoard(&theboard);
+    return RES_FAILED;
+  }
+  food_start = getNumberOfFoodItems(&theboard);
+  res = showWorm(&theboard, &theworm);
+
+  result -> end = AUTOPILOT_OUT_OF_TIME;
+  result -> game.ticks = 0;
+  while (res == RES_OK && result -> game.ticks < max_ticks) {
+    setWormHeading(&theworm, getAutopilotHeading(&thepilot, &theboard, &theworm));
+    // In fill mode the worm grows by one element per tick on average
+    if (fill && result -> game.ticks % BONUS_1 == 0) {
+      growWorm(&theworm, BONUS_1);
+    }
+    cleanWormTail(&theboard, &theworm);
+    moveWorm(&theboard, &theworm, &game_state);
+    result -> game.ticks++;
+    if (game_state != WORM_GAME_ONGOING) {
+      result -> end = AUTOPILOT_LOST;
+      break;
+    }
+    if (showWorm(&theboard, &theworm) != RES_OK || updateHazards(&theboard) != RES_OK) {
+      res = RES_FAILED;
+      break;
+    }
+    // The same checks as at the end of the loop of doLevel()
+    if (getNumberOfFoodItems(&theboard) == 0) {
+      result -> end = AUTOPILOT_CLEARED;
+      break;
+    }
+    if (fill && getWormLength(&theworm) == getWormMaxLength(&theworm)) {
+      result -> end = AUTOPILOT_FILLED;
+      break;
+    }
+    if (!fill && getCycleDistanceToFood(&thepilot, &theboard, getWormHeadPos(&theworm)) < 0) {
+      result -> end = AUTOPILOT_FOOD_OFF_CYCLE;
+      break;
+    }
+  }
+
+  result -> game.state = game_state;
+  result -> game.cleared = getNumberOfFoodItems(&theboard) == 0;
+  result -> game.food_eaten = food_start - getNumberOfFoodItems(&theboard);
+  result -> game.length = getWormLength(&theworm);
+  result -> cycle_length = getCycleLength(&thepilot);
+
+  cleanupWorm(&theworm);
+  cleanupAutopilot(&thepilot);
+  cleanupBoard(&theboard);
+  return res;
+}
+
+// State of a game of runPolicyGames()
+struct policy_game {
+  struct board board;
+  struct worm worm;
+  enum GameStates state;
+  uint32_t rng;
+  int food_start;
+};
+
+// Play the jobs in lockstep with a policy instead of a bot. In every tick the
+// policy chooses the headings of all running games in one batched evaluation,
+// so its weights are read once per tick and not once per game.
+// The jobs may use different levels; their params are not used. The seed of a
+// job drives the sampling of its headings (see choosePolicyHeadings()).
+// Runs in the calling thread, as the policy holds the scratch memory.
+enum ResCodes runPolicyGames(struct policy* apolicy, struct game_job* jobs, int njobs) {
+  struct policy_game* games = calloc(njobs, sizeof(struct policy_game));
+  struct board** boards = malloc(njobs * sizeof(struct board*));
+  struct worm** worms = malloc(njobs * sizeof(struct worm*));
+  uint32_t* rngs = malloc(njobs * sizeof(uint32_t));
+  enum WormHeading* headings = malloc(njobs * sizeof(enum WormHeading));
+  int* running = malloc(njobs * sizeof(int));
+  enum ResCodes res = RES_OK;
+  int ninit = 0;
+  int nrunning, i, j;
+
+  if (games == NULL || boards == NULL || worms == NULL || rngs == NULL
+      || headings == NULL || running == NULL) {
+    res = RES_FAILED;
+  }
+  for (ninit = 0; res == RES_OK && ninit < njobs; ninit++) {
+    struct policy_game* g = &games[ninit];
+    struct pos bottomLeft;
+
+    if (copyBoard(&g -> board, jobs[ninit].level) != RES_OK) {
+      res = RES_FAILED;
+      break;
+    }
+    bottomLeft.y = getLastRowOnBoard(&g -> board);
+    bottomLeft.x = 0;
+    if (initializeWorm(&g -> worm, NULL, (g -> board.last_row + 1) * (g -> board.last_col + 1),
+                       WORM_INITIAL_LENGTH, bottomLeft, WORM_RIGHT, COLP_USER_WORM) != RES_OK) {
+      cleanupBoard(&g -> board);
+      res = RES_FAILED;
+      break;
+    }
+    g -> state = WORM_GAME_ONGOING;
+    g -> rng = jobs[ninit].seed != 0 ? jobs[ninit].seed : 0x9e3779b9;  // As in initializeBot()
+    g -> food_start = getNumberOfFoodItems(&g -> board);
+    jobs[ninit].result -> ticks = 0;
+    res = showWorm(&g -> board, &g -> worm);
+  }
+
+  while (res == RES_OK) {
+    // Collect the games that are still running
+    nrunning = 0;
+    for (i = 0; i < njobs; i++) {
+      if (games[i].state == WORM_GAME_ONGOING && jobs[i].result -> ticks < jobs[i].max_ticks
+          && getNumberOfFoodItems(&games[i].board) > 0) {
+        running[nrunning] = i;
+        boards[nrunning] = &games[i].board;
+        worms[nrunning] = &games[i].worm;
+        rngs[nrunning] = games[i].rng;
+        nrunning++;
+      }
+    }
+    if (nrunning == 0) {
+      break;
+    }
+    if (choosePolicyHeadings(apolicy, boards, worms, nrunning, rngs, headings) != RES_OK) {
+      res = RES_FAILED;
+      break;
+    }
+    // One tick of each game, as in runHeadlessGame()
+    for (j = 0; j < nrunning; j++) {
+      struct policy_game* g = &games[running[j]];
+
+      g -> rng = rngs[j];
+      setWormHeading(&g -> worm, headings[j]);
+      cleanWormTail(&g -> board, &g -> worm);
+      moveWorm(&g -> board, &g -> worm, &g -> state);
+      jobs[running[j]].result -> ticks++;
+      if (g -> state == WORM_GAME_ONGOING
+          && (showWorm(&g -> board, &g -> worm) != RES_OK || updateHazards(&g -> board) != RES_OK)) {
+        res = RES_FAILED;
+        break;
+      }
+    }
+  }
+
+  for (i = 0; i < ninit; i++) {
+    struct game_result* result = jobs[i].result;
+
+    result -> state = games[i].state;
+    result -> cleared = getNumberOfFoodItems(&games[i].board) == 0;
+    result -> food_eaten = games[i].food_start - getNumberOfFoodItems(&games[i].board);
+    result -> length = getWormLength(&games[i].worm);
+    cleanupWorm(&games[i].worm);
+    cleanupBoard(&games[i].board);
+  }
+  free(games);
+  free(boards);
+  free(worms);
+  free(rngs);
+  free(headings);
+  free(running);
+  return res;
+}
+
+// Shared state of the threads of runHeadlessGames()
+struct game_pool {
+  struct game_job* jobs;
+  int njobs;
+  atomic_int next_job;
+  atomic_int failed;
+};
+
+static void* runGameThread(void* arg) {
+  struct game_pool* pool = arg;
+  int job;
+
+  while ((job = atomic_fetch_add(&pool -> next_job, 1)) < pool -> njobs) {
+    struct game_job* j = &pool -> jobs[job];
+    if (runHeadlessGame(j -> level, j -> params, j -> seed, j -> max_ticks, j -> result) != RES_OK) {
+      atomic_store(&pool -> failed, 1);
+    }
+  }
+  return NULL;
+}
+
+// Play all jobs in nthreads threads. Threads fetch the next job from an
+// atomic counter and write to the result of the job only, so the results
+// do not depend on the number of threads.
+enum ResCodes runHeadlessGames(struct game_job* jobs, int njobs, int nthreads) {
+  pthread_t threads[SIM_MAX_THREADS];
+  struct game_pool pool;
+  int started = 0;
+  int i;
+
+  pool.jobs = jobs;
+  pool.njobs = njobs;
+  atomic_init(&pool.next_job, 0);
+  atomic_init(&pool.failed, 0);
+
+  if (nthreads > SIM_MAX_THREADS) {
+    nthreads = SIM_MAX_THREADS;
+  }
+  if (nthreads > njobs) {
+    nthreads = njobs;
+  }
+  for (i = 1; i < nthreads; i++) {
+    if (pthread_create(&threads[started], NULL, runGameThread, &pool) == 0) {
+      started++;
+    }
+  }
+  runGameThread(&pool);  // The calling thread helps
+  for (i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  return atomic_load(&pool.failed) ? RES_FAILED : RES_OK;
+}
+
+// Number of online processors
+int getDefaultThreadCount() {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n < 1) {
+    return 1;
+  }
+  return n < SIM_MAX_THREADS ? n : SIM_MAX_THREADS;
+}
@@ -0,0 +1,78 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Headless games for batch simulation
+
+#ifndef _SIM_H
+#define _SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "worm.h"
+#include "board_model.h"
+
+#define SIM_MAX_TICKS 2000  // Default time limit of a headless game
+
+// Result of a headless game
+struct game_result
+{
+    enum GameStates state;  // WORM_GAME_ONGOING if cleared or out of time
+    bool cleared;           // All food items eaten
+    int ticks;
+    int food_eaten;
+    int length;
+};
+
+// Why a headless game of the autopilot ended
+enum AutopilotEnds {
+    AUTOPILOT_CLEARED,        // All food items eaten
+    AUTOPILOT_FILLED,         // The worm covers the entire cycle (fill mode)
+    AUTOPILOT_FOOD_OFF_CYCLE, // The remaining food does not lie on the cycle
+    AUTOPILOT_OUT_OF_TIME,    // max_ticks reached
+    AUTOPILOT_LOST,           // The worm crashed; see the state of the game
+};
+
+// Result of runAutopilotGame()
+struct autopilot_result
+{
+    struct game_result game;
+    enum AutopilotEnds end;
+    int cycle_length;       // Cells on the cycle; the coverage is game.length / cycle_length
+};
+
+// A game for runHeadlessGames()
+struct game_job
+{
+    struct board* level;
+    const float* params;    // Of the bot; not used by runPolicyGames()
+    uint32_t seed;
+    int max_ticks;
+    struct game_result* result;
+};
+
+#define SIM_MAX_THREADS 64
+
+extern enum ResCodes loadHeadlessLevel(struct board* aboard, const char* filename,
+                                       int nrows, int ncols);
+struct distance_oracle;  // See distance_oracle.h
+
+extern enum ResCodes loadHeadlessLevelWithOracle(struct board* aboard, struct distance_oracle* oracle,
+                                                 const char* filename, int nrows, int ncols);
+extern enum ResCodes runHeadlessGame(struct board* level, const float* params, uint32_t seed,
+                                     int max_ticks, struct game_result* result);
+extern enum ResCodes runHeadlessGames(struct game_job* jobs, int njobs, int nthreads);
+extern enum ResCodes runAutopilotGame(struct board* level, bool fill, int max_ticks,
+                                      struct autopilot_result* result);
+struct policy;  // See policy.h
+
+extern enum ResCodes runPolicyGames(struct policy* apolicy, struct game_job* jobs, int njobs);
+extern int getDefaultThreadCount();
+extern uint32_t getGameSeed(uint32_t base_seed, int level, int game);
+
+#endif  // #define _SIM_H
@@ -0,0 +1,224 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Raw output to VT/ANSI terminals, bypassing curses
+//
+// Curses computes the changes of the screen on every refresh() from its
+// virtual screens and emits them with its own cursor optimization. The
+// game already knows which cells change, so this backend only compares
+// these cells with what the terminal shows and writes
+// - a cursor jump only if the next changed cell is not the next one on
+//   the row (up to VT_MAX_SKIP unchanged cells are rewritten instead)
+// - an SGR sequence only if the attributes or the color pair change
+// The output of a frame goes to the terminal with one writev().
+//
+// Curses still owns the terminal outside of the level loop (dialogs).
+// Handing the screen back, the backend copies its cells to stdscr and lets
+// curses repaint everything once, since curses cannot know the cursor
+// position and attributes left behind.
+
+#include <curses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/uio.h>
+#include "worm.h"
+#include "messages.h"
+#include "vt.h"
+
+// Take over the screen as curses left it on the terminal
+enum ResCodes initializeVtScreen(struct vt_screen* avt, int fd) {
+  int y, x;
+  short pair;
+
+  avt -> fd = fd;
+  avt -> nrows = LINES;
+  avt -> ncols = COLS;
+  avt -> front = malloc(LINES * COLS * sizeof(chtype));
+  avt -> back = malloc(LINES * COLS * sizeof(chtype));
+  avt -> out = malloc(LINES * COLS * VT_BYTES_PER_CELL);
+  if (avt -> front == NULL || avt -> back == NULL || avt -> out == NULL) {
+    free(avt -> front);
+    free(avt -> back);
+    free(avt -> out);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  for (y = 0; y < avt -> nrows; y++) {
+    for (x = 0; x < avt -> ncols; x++) {
+      avt -> front[y * avt -> ncols + x] = mvwinch(curscr, y, x);
+    }
+  }
+  memcpy(avt -> back, avt -> front, LINES * COLS * sizeof(chtype));
+  for (pair = 0; pair < VT_MAX_PAIRS; pair++) {
+    if (pair_content(pair, &avt -> fg[pair], &avt -> bg[pair]) == ERR) {
+      avt -> fg[pair] = avt -> bg[pair] = -1;
+    }
+  }
+  avt -> cur_y = -1;
+  avt -> attr_known = false;
+  avt -> bytes = 0;
+  return RES_OK;
+}
+
+// Write all of the output, also if writev() takes only a part of it
+static void writeVt(struct vt_screen* avt, struct iovec* iov, int n) {
+  while (n > 0) {
+    ssize_t written = writev(avt -> fd, iov, n);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;  // Terminal is gone
+    }
+    avt -> bytes += written;
+    while (n > 0 && (size_t) written >= iov -> iov_len) {
+      written -= iov -> iov_len;
+      iov++;
+      n--;
+    }
+    if (n > 0) {
+      iov -> iov_base = (char*) iov -> iov_base + written;
+      iov -> iov_len -= written;
+    }
+  }
+}
+
+// Hand the screen back to curses
+void cleanupVtScreen(struct vt_screen* avt) {
+  struct iovec reset = { "\x1b[0m", 4 };
+  int y, x;
+
+  writeVt(avt, &reset, 1);
+  for (y = 0; y < avt -> nrows; y++) {
+    for (x = 0; x < avt -> ncols; x++) {
+      mvaddch(y, x, avt -> back[y * avt -> ncols + x]);
+    }
+  }
+  clearok(curscr, TRUE);  // Repaint everything with the next refresh()
+  free(avt -> front);
+  free(avt -> back);
+  free(avt -> out);
+}
+
+void putVtCell(struct vt_screen* avt, int y, int x, chtype ch) {
+  if (y >= 0 && y < avt -> nrows && x >= 0 && x < avt -> ncols) {
+    avt -> back[y * avt -> ncols + x] = ch;
+  }
+}
+
+static char* putVtAttr(struct vt_screen* avt, char* p, chtype attr) {
+  int pair = PAIR_NUMBER(attr);
+
+  p += sprintf(p, "\x1b[0");
+  if (attr & A_BOLD) {
+    p += sprintf(p, ";1");
+  }
+  if (attr & A_REVERSE) {
+    p += sprintf(p, ";7");
+  }
+  if (pair > 0 && pair < VT_MAX_PAIRS && avt -> fg[pair] >= 0 && avt -> fg[pair] < 8
+      && avt -> bg[pair] >= 0 && avt -> bg[pair] < 8) {
+    p += sprintf(p, ";%d;%d", 30 + avt -> fg[pair], 40 + avt -> bg[pair]);
+  }
+  *p++ = 'm';
+  avt -> cur_attr = attr;
+  avt -> attr_known = true;
+  return p;
+}
+
+// Background color of the attributes; -1 for the default
+static int getVtBackground(struct vt_screen* avt, chtype attr) {
+  int pair = PAIR_NUMBER(attr);
+  return pair > 0 && pair < VT_MAX_PAIRS ? avt -> bg[pair] : -1;
+}
+
+// Does ch look the same with the current attributes?
+// Blanks only show their background.
+static bool fitsVtAttr(struct vt_screen* avt, chtype ch) {
+  chtype attr = ch & A_ATTRIBUTES;
+
+  if (!avt -> attr_known) {
+    return false;
+  }
+  if (attr == avt -> cur_attr) {
+    return true;
+  }
+  return (ch & A_CHARTEXT) == ' ' && !(attr & A_REVERSE) && !(avt -> cur_attr & A_REVERSE)
+    && getVtBackground(avt, attr) == getVtBackground(avt, avt -> cur_attr);
+}
+
+// Write one cell at the cursor
+static char* putVtChar(struct vt_screen* avt, char* p, chtype ch) {
+  chtype attr = ch & A_ATTRIBUTES;
+
+  if (!fitsVtAttr(avt, ch)) {
+    p = putVtAttr(avt, p, attr);
+  }
+  *p++ = ch & A_CHARTEXT;
+  avt -> cur_x++;
+  if (avt -> cur_x >= avt -> ncols) {
+    avt -> cur_y = -1;  // Depends on the autowrap of the terminal
+  }
+  return p;
+}
+
+// Bring the cursor to (y,x): rewrite a few unchanged cells or jump
+static char* moveVtCursor(struct vt_screen* avt, char* p, int y, int x) {
+  int k;
+
+  if (avt -> cur_y == y && avt -> cur_x == x) {
+    return p;
+  }
+  if (avt -> cur_y == y && x > avt -> cur_x && x - avt -> cur_x <= VT_MAX_SKIP) {
+    // Cells left of x already show the back buffer
+    for (k = avt -> cur_x; k < x; k++) {
+      if (!fitsVtAttr(avt, avt -> front[y * avt -> ncols + k])) {
+        break;
+      }
+    }
+    if (k == x) {
+      for (k = avt -> cur_x; k < x; k++) {
+        *p++ = avt -> front[y * avt -> ncols + k] & A_CHARTEXT;
+      }
+      avt -> cur_x = x;
+      return p;
+    }
+  }
+  p += sprintf(p, "\x1b[%d;%dH", y + 1, x + 1);
+  avt -> cur_y = y;
+  avt -> cur_x = x;
+  return p;
+}
+
+// Write the changes of the back buffer to the terminal
+void showVtFrame(struct vt_screen* avt) {
+  struct iovec iov[3] = {
+    { VT_BEGIN_FRAME, sizeof(VT_BEGIN_FRAME) - 1 },
+    { avt -> out, 0 },
+    { VT_END_FRAME, sizeof(VT_END_FRAME) - 1 },
+  };
+  char* p = avt -> out;
+  int i;
+
+  for (i = 0; i < avt -> nrows * avt -> ncols; i++) {
+    if (avt -> back[i] != avt -> front[i]) {
+      p = moveVtCursor(avt, p, i / avt -> ncols, i % avt -> ncols);
+      p = putVtChar(avt, p, avt -> back[i]);
+      avt -> front[i] = avt -> back[i];
+    }
+  }
+  if (p == avt -> out) {
+    return;  // Nothing changed
+  }
+  iov[1].iov_len = p - avt -> out;
+  writeVt(avt, iov, 3);
+}
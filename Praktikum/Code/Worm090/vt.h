@@ -0,0 +1,54 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Raw output to VT/ANSI terminals, bypassing curses
+
+#ifndef _VT_H
+#define _VT_H
+
+#include <curses.h>
+#include <stdbool.h>
+#include "worm.h"
+
+#define VT_MAX_PAIRS 16     // Color pairs known to the backend (see enum ColorPairs)
+#define VT_MAX_SKIP 4       // Unchanged cells rewritten instead of a cursor jump
+#define VT_BYTES_PER_CELL 32  // Upper bound of the output for one cell
+
+// Frames are framed by the synchronized update mode of the terminal;
+// terminals without it ignore these sequences
+#define VT_BEGIN_FRAME "\x1b[?2026h"
+#define VT_END_FRAME "\x1b[?2026l"
+
+// The screen as two buffers of cells (symbol with attributes and color pair).
+// The back buffer collects the changes of a frame; showVtFrame() writes
+// the cells that differ from the front buffer with a single writev().
+// Between start and end of a level this replaces curses (option -v).
+struct vt_screen
+{
+    int fd;              // Output, usually the terminal
+    int nrows;
+    int ncols;
+    chtype* front;       // What the terminal shows
+    chtype* back;        // What the next frame shows
+    int cur_y;           // Cursor of the terminal; -1 if unknown
+    int cur_x;
+    chtype cur_attr;     // Attributes of the last SGR sequence
+    bool attr_known;
+    char* out;           // Output of a frame
+    short fg[VT_MAX_PAIRS];  // Colors of the color pairs
+    short bg[VT_MAX_PAIRS];
+    long bytes;          // Written so far
+};
+
+extern enum ResCodes initializeVtScreen(struct vt_screen* avt, int fd);
+extern void cleanupVtScreen(struct vt_screen* avt);
+extern void putVtCell(struct vt_screen* avt, int y, int x, chtype ch);
+extern void showVtFrame(struct vt_screen* avt);
+
+#endif  // #define _VT_H
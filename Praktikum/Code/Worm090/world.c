@@ -0,0 +1,507 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Endless world streamed in chunks
+//
+// The world is an unbounded plane of CHUNK_SIZE x CHUNK_SIZE chunks. Only
+// the WORLD_CHUNKS x WORLD_CHUNKS chunks around the head are on the board.
+// A worker thread generates chunks (arena levels of levelgen.c, seeded by
+// the chunk coordinates). Requests and finished chunks are passed through
+// two lock-free single producer/single consumer queues; the main thread
+// only posts a semaphore, so a tick never waits for the worker.
+// Chunks that leave the window are kept with their current contents
+// (eaten food stays eaten) in a cache of CHUNK_CACHE_SIZE chunks. The
+// oldest chunk is dropped when the cache is full and generated anew when
+// it is needed again. All chunks come from a fixed pool, so memory does
+// not depend on the distance travelled.
+//
+// The worm cannot grow beyond WORLD_RADIUS * CHUNK_SIZE elements. Then its
+// body always lies within the window, and a chunk is never evicted while
+// the worm covers part of it.
+
+#include <curses.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "levelgen.h"
+#include "messages.h"
+#include "world.h"
+
+// Helpers
+// ********************************************************************************************
+
+static int floorDiv(int a, int b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static int wrap(int a, int n) {
+  return ((a % n) + n) % n;
+}
+
+static enum ResCodes placeCode(struct board* aboard, int y, int x, enum BoardCodes code) {
+  switch (code) {
+    case BC_BARRIER:
+      return placeItem(aboard, y, x, BC_BARRIER, SYMBOL_BARRIER, COLP_BARRIER);
+    case BC_FOOD_1:
+      return placeItem(aboard, y, x, BC_FOOD_1, SYMBOL_FOOD_1, COLP_FOOD_1);
+    case BC_FOOD_2:
+      return placeItem(aboard, y, x, BC_FOOD_2, SYMBOL_FOOD_2, COLP_FOOD_2);
+    case BC_FOOD_3:
+      return placeItem(aboard, y, x, BC_FOOD_3, SYMBOL_FOOD_3, COLP_FOOD_3);
+    default:
+      return placeItem(aboard, y, x, BC_FREE_CELL, SYMBOL_FREE_CELL, COLP_FREE_CELL);
+  }
+}
+
+static bool isFood(enum BoardCodes code) {
+  return code == BC_FOOD_1 || code == BC_FOOD_2 || code == BC_FOOD_3;
+}
+
+// Queues
+// ********************************************************************************************
+
+// Called by the producer only
+static bool pushChunk(struct chunk_queue* q, struct chunk* c) {
+  unsigned tail = atomic_load_explicit(&q -> tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&q -> head, memory_order_acquire);
+
+  if (tail - head == CHUNK_QUEUE_SIZE) {
+    return false;
+  }
+  q -> slots[tail & (CHUNK_QUEUE_SIZE - 1)] = c;
+  atomic_store_explicit(&q -> tail, tail + 1, memory_order_release);
+  return true;
+}
+
+// Called by the consumer only
+static struct chunk* popChunk(struct chunk_queue* q) {
+  unsigned head = atomic_load_explicit(&q -> head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&q -> tail, memory_order_acquire);
+  struct chunk* c;
+
+  if (head == tail) {
+    return NULL;
+  }
+  c = q -> slots[head & (CHUNK_QUEUE_SIZE - 1)];
+  atomic_store_explicit(&q -> head, head + 1, memory_order_release);
+  return c;
+}
+
+// Worker
+// ********************************************************************************************
+
+struct worker_args {
+  struct world* world;
+  struct board scratch;    // Headless CHUNK_SIZE x CHUNK_SIZE board for generateLevel()
+};
+
+static void* runWorldWorker(void* arg) {
+  struct worker_args* args = arg;
+  struct world* aworld = args -> world;
+  struct chunk* c;
+  int y, x;
+
+  for (;;) {
+    sem_wait(&aworld -> requests_pending);
+    if (atomic_load(&aworld -> stop)) {
+      break;
+    }
+    if ((c = popChunk(&aworld -> requests)) == NULL) {
+      continue;
+    }
+    generateLevel(&args -> scratch, LEVEL_ARENA,
+                  aworld -> seed ^ ((uint64_t) (uint32_t) c -> cy << 32) ^ (uint32_t) c -> cx, 0, false);
+    for (y = 0; y < CHUNK_SIZE; y++) {
+      for (x = 0; x < CHUNK_SIZE; x++) {
+        c -> cells[y * CHUNK_SIZE + x] = getCellAt(&args -> scratch, y, x);
+      }
+    }
+    // Never full: at most CHUNK_QUEUE_SIZE chunks are requested at a time
+    pushChunk(&aworld -> ready, c);
+  }
+  cleanupBoard(&args -> scratch);
+  free(args);
+  return NULL;
+}
+
+// Chunk memory and cache
+// ********************************************************************************************
+
+static void releaseChunk(struct world* aworld, struct chunk* c) {
+  aworld -> free_chunks[aworld -> nfree++] = c;
+}
+
+// Drop the least recently used chunk of the cache
+static void dropOldestChunk(struct world* aworld) {
+  int oldest = 0;
+  int i;
+
+  for (i = 1; i < aworld -> ncached; i++) {
+    if (aworld -> cache[i] -> stamp < aworld -> cache[oldest] -> stamp) {
+      oldest = i;
+    }
+  }
+  releaseChunk(aworld, aworld -> cache[oldest]);
+  aworld -> cache[oldest] = aworld -> cache[--aworld -> ncached];
+}
+
+// A chunk from the pool; drops the oldest cached chunk if the pool is empty
+static struct chunk* acquireChunk(struct world* aworld) {
+  if (aworld -> nfree == 0) {
+    if (aworld -> ncached == 0) {
+      return NULL;
+    }
+    dropOldestChunk(aworld);
+  }
+  return aworld -> free_chunks[--aworld -> nfree];
+}
+
+static void addToCache(struct world* aworld, struct chunk* c) {
+  c -> stamp = aworld -> tick;
+  if (aworld -> ncached == CHUNK_CACHE_SIZE) {
+    dropOldestChunk(aworld);
+  }
+  aworld -> cache[aworld -> ncached++] = c;
+}
+
+// Take a chunk out of the cache; NULL if it is not cached
+static struct chunk* takeFromCache(struct world* aworld, int cy, int cx) {
+  int i;
+  for (i = 0; i < aworld -> ncached; i++) {
+    struct chunk* c = aworld -> cache[i];
+    if (c -> cy == cy && c -> cx == cx) {
+      aworld -> cache[i] = aworld -> cache[--aworld -> ncached];
+      return c;
+    }
+  }
+  return NULL;
+}
+
+// Slots of the board
+// ********************************************************************************************
+
+// Copy a chunk into its slot; cells covered by the worm are kept.
+// Returns RES_FAILED if there is no memory for the tiles of the slot.
+static enum ResCodes installChunk(struct world* aworld, int sy, int sx, struct chunk* c) {
+  struct board* aboard = &aworld -> board;
+  int y, x;
+
+  for (y = 0; y < CHUNK_SIZE; y++) {
+    for (x = 0; x < CHUNK_SIZE; x++) {
+      int by = sy * CHUNK_SIZE + y;
+      int bx = sx * CHUNK_SIZE + x;
+      enum BoardCodes code = c -> cells[y * CHUNK_SIZE + x];
+      if (getCellAt(aboard, by, bx) == BC_USED_BY_WORM) {
+        continue;
+      }
+      if (placeCode(aboard, by, bx, code) != RES_OK) {
+        setNumberOfFoodItems(aboard, aworld -> food_on_board);
+        return RES_FAILED;
+      }
+      aworld -> food_on_board += isFood(code);
+    }
+  }
+  setNumberOfFoodItems(aboard, aworld -> food_on_board);
+  aworld -> slot_state[sy][sx] = SLOT_FILLED;
+  return RES_OK;
+}
+
+// Save the contents of a slot to the cache and clear the slot
+static void evictSlot(struct world* aworld, int sy, int sx) {
+  struct board* aboard = &aworld -> board;
+  struct chunk* c = NULL;
+  int y, x;
+
+  if (aworld -> slot_state[sy][sx] == SLOT_FILLED && (c = acquireChunk(aworld)) != NULL) {
+    c -> cy = aworld -> slot_cy[sy][sx];
+    c -> cx = aworld -> slot_cx[sy][sx];
+  }
+  for (y = 0; y < CHUNK_SIZE; y++) {
+    for (x = 0; x < CHUNK_SIZE; x++) {
+      int by = sy * CHUNK_SIZE + y;
+      int bx = sx * CHUNK_SIZE + x;
+      enum BoardCodes code = getCellAt(aboard, by, bx);
+      if (c != NULL) {
+        c -> cells[y * CHUNK_SIZE + x] = code == BC_USED_BY_WORM ? BC_FREE_CELL : code;
+      }
+      if (code != BC_FREE_CELL && code != BC_USED_BY_WORM) {
+        aworld -> food_on_board -= isFood(code);
+        placeItem(aboard, by, bx, BC_FREE_CELL, SYMBOL_FREE_CELL, COLP_FREE_CELL);
+      }
+    }
+  }
+  setNumberOfFoodItems(aboard, aworld -> food_on_board);
+  if (c != NULL) {
+    addToCache(aworld, c);
+  }
+}
+
+// Fill a slot from the cache or ask the worker for its chunk
+static enum ResCodes requestSlot(struct world* aworld, int sy, int sx) {
+  int cy = aworld -> slot_cy[sy][sx];
+  int cx = aworld -> slot_cx[sy][sx];
+  struct chunk* c = takeFromCache(aworld, cy, cx);
+  enum ResCodes res_code;
+  unsigned in_flight;
+
+  if (c != NULL) {
+    res_code = installChunk(aworld, sy, sx, c);
+    releaseChunk(aworld, c);
+    return res_code;
+  }
+  in_flight = atomic_load(&aworld -> requests.tail) - atomic_load(&aworld -> ready.head);
+  if (in_flight >= CHUNK_QUEUE_SIZE || (c = acquireChunk(aworld)) == NULL) {
+    aworld -> slot_state[sy][sx] = SLOT_WAITING;
+    return RES_OK;
+  }
+  c -> cy = cy;
+  c -> cx = cx;
+  pushChunk(&aworld -> requests, c);
+  sem_post(&aworld -> requests_pending);
+  aworld -> slot_state[sy][sx] = SLOT_PENDING;
+  return RES_OK;
+}
+
+// Install the chunks finished by the worker
+static enum ResCodes collectChunks(struct world* aworld) {
+  struct chunk* c;
+
+  while ((c = popChunk(&aworld -> ready)) != NULL) {
+    int sy = wrap(c -> cy, WORLD_CHUNKS);
+    int sx = wrap(c -> cx, WORLD_CHUNKS);
+    if (aworld -> slot_state[sy][sx] == SLOT_PENDING
+        && aworld -> slot_cy[sy][sx] == c -> cy && aworld -> slot_cx[sy][sx] == c -> cx) {
+      enum ResCodes res_code = installChunk(aworld, sy, sx, c);
+      releaseChunk(aworld, c);
+      if (res_code != RES_OK) {
+        return res_code;
+      }
+    } else {
+      // The window moved on while the chunk was generated
+      addToCache(aworld, c);
+    }
+  }
+  return RES_OK;
+}
+
+// Make the slots hold the chunks around the chunk of the head
+static enum ResCodes moveWindow(struct world* aworld) {
+  int cy = floorDiv(aworld -> head.y, CHUNK_SIZE);
+  int cx = floorDiv(aworld -> head.x, CHUNK_SIZE);
+  int sy, sx;
+
+  for (sy = 0; sy < WORLD_CHUNKS; sy++) {
+    for (sx = 0; sx < WORLD_CHUNKS; sx++) {
+      // The chunk of the window that maps to this slot
+      int want_cy = cy - WORLD_RADIUS + wrap(sy - (cy - WORLD_RADIUS), WORLD_CHUNKS);
+      int want_cx = cx - WORLD_RADIUS + wrap(sx - (cx - WORLD_RADIUS), WORLD_CHUNKS);
+
+      if (aworld -> slot_cy[sy][sx] != want_cy || aworld -> slot_cx[sy][sx] != want_cx) {
+        evictSlot(aworld, sy, sx);
+        aworld -> slot_cy[sy][sx] = want_cy;
+        aworld -> slot_cx[sy][sx] = want_cx;
+        if (requestSlot(aworld, sy, sx) != RES_OK) {
+          return RES_FAILED;
+        }
+      } else if (aworld -> slot_state[sy][sx] == SLOT_WAITING
+                 && requestSlot(aworld, sy, sx) != RES_OK) {
+        return RES_FAILED;
+      }
+    }
+  }
+  return RES_OK;
+}
+
+// Interface
+// ********************************************************************************************
+
+enum ResCodes initializeWorld(struct world* aworld, uint64_t seed) {
+  struct worker_args* args;
+  int i, sy, sx;
+  bool complete;
+
+  memset(aworld, 0, sizeof(struct world));
+  aworld -> seed = seed;
+  if (initializeHeadlessBoard(&aworld -> board, WORLD_SIZE, WORLD_SIZE) != RES_OK) {
+    return RES_FAILED;
+  }
+  aworld -> board.wraps = true;
+  aworld -> board.food_items = 0;
+
+  aworld -> pool = malloc(CHUNK_POOL_SIZE * sizeof(struct chunk));
+  args = malloc(sizeof(struct worker_args));
+  if (aworld -> pool == NULL || args == NULL
+      || initializeHeadlessBoard(&args -> scratch, CHUNK_SIZE, CHUNK_SIZE) != RES_OK) {
+    free(args);
+    cleanupWorld(aworld);
+    showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  for (i = 0; i < CHUNK_POOL_SIZE; i++) {
+    releaseChunk(aworld, &aworld -> pool[i]);
+  }
+  atomic_init(&aworld -> requests.head, 0);
+  atomic_init(&aworld -> requests.tail, 0);
+  atomic_init(&aworld -> ready.head, 0);
+  atomic_init(&aworld -> ready.tail, 0);
+  atomic_init(&aworld -> stop, false);
+  sem_init(&aworld -> requests_pending, 0, 0);
+  args -> world = aworld;
+  if (pthread_create(&aworld -> worker, NULL, runWorldWorker, args) != 0) {
+    cleanupBoard(&args -> scratch);
+    free(args);
+    cleanupWorld(aworld);
+    showDialog("Abbruch: Kann keinen Thread starten", "Bitte eine Taste druecken");
+    return RES_FAILED;
+  }
+  aworld -> worker_started = true;
+
+  // The worm starts in the lower left corner of chunk (0, 0)
+  aworld -> head = getWorldStartPos(aworld);
+  aworld -> torus_head = aworld -> head;
+  for (sy = 0; sy < WORLD_CHUNKS; sy++) {
+    for (sx = 0; sx < WORLD_CHUNKS; sx++) {
+      aworld -> slot_state[sy][sx] = SLOT_WAITING;
+      aworld -> slot_cy[sy][sx] = INT_MIN;
+      aworld -> slot_cx[sy][sx] = INT_MIN;
+    }
+  }
+
+  // Only here we wait for the worker: the first window must be complete
+  do {
+    if (moveWindow(aworld) != RES_OK || collectChunks(aworld) != RES_OK) {
+      cleanupWorld(aworld);
+      showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+      return RES_FAILED;
+    }
+    complete = true;
+    for (sy = 0; sy < WORLD_CHUNKS; sy++) {
+      for (sx = 0; sx < WORLD_CHUNKS; sx++) {
+        complete = complete && aworld -> slot_state[sy][sx] == SLOT_FILLED;
+      }
+    }
+    if (!complete) {
+      usleep(1000);
+    }
+  } while (!complete);
+  return RES_OK;
+}
+
+void cleanupWorld(struct world* aworld) {
+  if (aworld -> worker_started) {
+    atomic_store(&aworld -> stop, true);
+    sem_post(&aworld -> requests_pending);
+    pthread_join(aworld -> worker, NULL);
+    sem_destroy(&aworld -> requests_pending);
+    aworld -> worker_started = false;
+  }
+  free(aworld -> pool);
+  aworld -> pool = NULL;
+  cleanupBoard(&aworld -> board);
+}
+
+struct board* getWorldBoard(struct world* aworld) {
+  return &aworld -> board;
+}
+
+struct pos getWorldStartPos(struct world* aworld) {
+  struct pos start = { CHUNK_SIZE - 1, 0 };
+  return start;
+}
+
+// Longest worm whose body always lies within the window
+int getWorldMaxWormLength() {
+  return WORLD_RADIUS * CHUNK_SIZE;
+}
+
+// Follow the head and stream chunks; call once per tick after moveWorm().
+// Returns RES_FAILED if there is no memory for the tiles of a new chunk.
+enum ResCodes updateWorld(struct world* aworld, struct worm* aworm) {
+  struct pos torus_head = getWormHeadPos(aworm);
+  int dy = torus_head.y - aworld -> torus_head.y;
+  int dx = torus_head.x - aworld -> torus_head.x;
+
+  // Steps across the seam of the torus
+  if (dy > 1) dy -= WORLD_SIZE;
+  if (dy < -1) dy += WORLD_SIZE;
+  if (dx > 1) dx -= WORLD_SIZE;
+  if (dx < -1) dx += WORLD_SIZE;
+  aworld -> head.y += dy;
+  aworld -> head.x += dx;
+  aworld -> torus_head = torus_head;
+
+  aworld -> food_eaten += aworld -> food_on_board - getNumberOfFoodItems(&aworld -> board);
+  aworld -> food_on_board = getNumberOfFoodItems(&aworld -> board);
+  aworld -> tick++;
+
+  if (moveWindow(aworld) != RES_OK) {
+    return RES_FAILED;
+  }
+  return collectChunks(aworld);
+}
+
+// Draw the part of the world around the head that fits on the display.
+// Only the visible cells are drawn; the board itself is headless.
+void showWorldView(struct world* aworld, struct worm* aworm) {
+  struct board* aboard = &aworld -> board;
+  int rows = LINES - ROWS_RESERVED;
+  int cols = COLS;
+  int max = 2 * WORLD_RADIUS * CHUNK_SIZE;  // Beyond this the torus would show stale cells
+  int top = aworld -> torus_head.y - (rows < max ? rows : max) / 2;
+  int left = aworld -> torus_head.x - (cols < max ? cols : max) / 2;
+  int y, x;
+
+  for (y = 0; y < rows; y++) {
+    for (x = 0; x < cols; x++) {
+      chtype symbol = SYMBOL_FREE_CELL;
+      enum ColorPairs color = COLP_FREE_CELL;
+      if (y < max && x < max) {
+        int by = wrap(top + y, WORLD_SIZE);
+        int bx = wrap(left + x, WORLD_SIZE);
+        switch (getCellAt(aboard, by, bx)) {
+          case BC_USED_BY_WORM:
+            symbol = by == aworld -> torus_head.y && bx == aworld -> torus_head.x
+              ? SYMBOL_WORM_HEAD_ELEMENT : SYMBOL_WORM_INNER_ELEMENT;
+            color = COLP_USER_WORM;
+            break;
+          case BC_FOOD_1: symbol = SYMBOL_FOOD_1; color = COLP_FOOD_1; break;
+          case BC_FOOD_2: symbol = SYMBOL_FOOD_2; color = COLP_FOOD_2; break;
+          case BC_FOOD_3: symbol = SYMBOL_FOOD_3; color = COLP_FOOD_3; break;
+          case BC_BARRIER: symbol = SYMBOL_BARRIER; color = COLP_BARRIER; break;
+          default: break;
+        }
+      }
+      move(y, x);
+      attron(COLOR_PAIR(color));
+      addch(symbol);
+      attroff(COLOR_PAIR(color));
+    }
+  }
+  // Separator line above the message area
+  attron(COLOR_PAIR(COLP_BARRIER));
+  for (x = 0; x < cols; x++) {
+    mvaddch(rows, x, SYMBOL_BARRIER);
+  }
+  attroff(COLOR_PAIR(COLP_BARRIER));
+}
+
+void showWorldStatus(struct world* aworld, struct worm* aworm) {
+  int pos_line1 = LINES -ROWS_RESERVED + 1;
+  int pos_line2 = LINES -ROWS_RESERVED + 2;
+  int pos_line3 = LINES -ROWS_RESERVED + 3;
+
+  mvprintw(pos_line1, 1, "Gefressene Futterbrocken: %5d ", aworld -> food_eaten);
+  mvprintw(pos_line2, 1, "Wurm ist an Position: y=%7d x=%7d ", aworld -> head.y, aworld -> head.x);
+  mvprintw(pos_line3, 1, "Laenge des Wurms: %3d von %3d ", getWormLength(aworm),
+           getWorldMaxWormLength());
+}
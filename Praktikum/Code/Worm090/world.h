@@ -0,0 +1,104 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// Endless world streamed in chunks
+
+#ifndef _WORLD_H
+#define _WORLD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+
+#define CHUNK_SIZE 32           // Edge length of a chunk in cells
+#define WORLD_RADIUS 3          // Chunks kept around the chunk of the head in each direction
+#define WORLD_CHUNKS (2 * WORLD_RADIUS + 1)      // Resident chunks per axis
+#define WORLD_SIZE (WORLD_CHUNKS * CHUNK_SIZE)   // Resident cells per axis
+#define CHUNK_CACHE_SIZE 64     // Evicted chunks kept with their current contents
+#define CHUNK_QUEUE_SIZE 64     // Capacity of the queues to and from the worker (power of 2)
+#define CHUNK_POOL_SIZE (CHUNK_CACHE_SIZE + CHUNK_QUEUE_SIZE)
+
+// A chunk of the world outside of the board
+struct chunk
+{
+    int cy;                  // Chunk coordinates in the world
+    int cx;
+    long stamp;              // Last use, for evicting the oldest chunk from the cache
+    uint8_t cells[CHUNK_SIZE * CHUNK_SIZE];  // Board codes, one byte per cell
+};
+
+// Lock-free queue for one producer and one consumer
+struct chunk_queue
+{
+    struct chunk* slots[CHUNK_QUEUE_SIZE];
+    atomic_uint head;        // Next slot to read; written by the consumer only
+    atomic_uint tail;        // Next slot to write; written by the producer only
+};
+
+// States of the chunk slots of the board
+enum SlotStates {
+    SLOT_FILLED,             // Slot holds its chunk
+    SLOT_PENDING,            // Chunk was requested from the worker
+    SLOT_WAITING,            // Chunk still has to be requested (queue was full)
+};
+
+// The endless world.
+// The board is a torus of WORLD_CHUNKS x WORLD_CHUNKS chunks. World chunk
+// (cy, cx) lives in slot (cy mod WORLD_CHUNKS, cx mod WORLD_CHUNKS), and the
+// worm moves in torus coordinates. When the head enters another chunk, the
+// slots that drop out of the window around it are evicted to the cache and
+// refilled from the cache or by the worker thread.
+struct world
+{
+    struct board board;
+    uint64_t seed;
+
+    // Slots of the board
+    enum SlotStates slot_state[WORLD_CHUNKS][WORLD_CHUNKS];
+    int slot_cy[WORLD_CHUNKS][WORLD_CHUNKS];
+    int slot_cx[WORLD_CHUNKS][WORLD_CHUNKS];
+
+    // Position of the head in the world and on the torus
+    struct pos head;
+    struct pos torus_head;
+    int food_eaten;
+    int food_on_board;       // To notice eaten food
+    long tick;
+
+    // Chunk memory: a fixed pool, so memory does not grow with the distance
+    struct chunk* pool;
+    struct chunk* free_chunks[CHUNK_POOL_SIZE];
+    int nfree;
+    struct chunk* cache[CHUNK_CACHE_SIZE];
+    int ncached;
+
+    // Worker thread generating chunks
+    pthread_t worker;
+    bool worker_started;
+    sem_t requests_pending;
+    atomic_bool stop;
+    struct chunk_queue requests;  // Main thread -> worker
+    struct chunk_queue ready;     // Worker -> main thread
+};
+
+extern enum ResCodes initializeWorld(struct world* aworld, uint64_t seed);
+extern void cleanupWorld(struct world* aworld);
+extern struct board* getWorldBoard(struct world* aworld);
+extern struct pos getWorldStartPos(struct world* aworld);
+extern int getWorldMaxWormLength();
+extern enum ResCodes updateWorld(struct world* aworld, struct worm* aworm);
+extern void showWorldView(struct world* aworld, struct worm* aworm);
+extern void showWorldStatus(struct world* aworld, struct worm* aworm);
+
+#endif  // #define _WORLD_H
@@ -22,34 +22,34 @@
 #include "worm_model.h"
 #include "board_model.h"
 #include "options.h"
+#include "autopilot.h"
+#include "policy.h"
+#include "levelgen.h"
+#include "world.h"
+#include "minimap.h"
+#include "hazards.h"
+#include "food_index.h"
+#include "occupancy.h"
+#include "arena.h"
+#include "render.h"
+#include "vt.h"
 
 // Forward declarations of functions
 // ********************************************************************************************
 
 // Management of the game
-void initializeColors();
-void readUserInput(struct worm* aworm, enum GameStates* agame_state );
+void readUserInput(struct game_options* somegops, struct worm* aworm, enum GameStates* agame_state );
 enum ResCodes doLevel();
+void showMaps();
+enum ResCodes doEndlessWorld();
 
 // Management of the game
 // ************************************
 
-// Initialize colors of the game
-void initializeColors() {
-    // Define colors of the game
-    start_color();
-    init_pair(COLP_USER_WORM, COLOR_GREEN,   COLOR_BLACK);
-    init_pair(COLP_FREE_CELL, COLOR_BLACK,   COLOR_BLACK);
-    init_pair(COLP_FOOD_1,    COLOR_YELLOW,  COLOR_BLACK);
-    init_pair(COLP_FOOD_2,    COLOR_MAGENTA, COLOR_BLACK);
-    init_pair(COLP_FOOD_3,    COLOR_CYAN,    COLOR_BLACK);
-    init_pair(COLP_BARRIER,   COLOR_RED,     COLOR_BLACK);
-}
-
-void readUserInput(struct worm* aworm, enum GameStates* agame_state ) {
+void readUserInput(struct game_options* somegops, struct worm* aworm, enum GameStates* agame_state ) {
     int ch; // For storing the key codes
 
-    if ((ch = getch()) > 0) {
+    if ((ch = readKey()) > 0) {
         // Is there some user input?
         // Blocking or non-blocking depends of config of getch
         switch(ch) {
@@ -69,36 +69,91 @@ void readUserInput(struct worm* aworm, enum GameStates* agame_state ) {
                 setWormHeading(aworm, WORM_RIGHT);
                 break;
             case 's' : // User wants single step
-                nodelay(stdscr, FALSE);  // We simply make getch blocking
+                setKeyBlocking(true);   // We simply make readKey blocking
                 break;
             case ' ' : // Terminate single step; make getch non-blocking again
-                nodelay(stdscr, TRUE);   // Make getch non-blocking again
+                setKeyBlocking(false);  // Make readKey non-blocking again
                 break;
             case 'g' : //For development: let the worm grow by BONUS_3 elements
                 growWorm(aworm, BONUS_3);
                 break;
+            case 'm' : // Toggle the minimap
+                somegops -> show_minimap = !somegops -> show_minimap;
+                break;
+            case 'M' : // Toggle the overview of the whole board
+                somegops -> show_overview = !somegops -> show_overview;
+                break;
         }
     }
     return;
 }
 
-enum ResCodes doLevel(struct game_options* somegops, enum GameStates* agame_state, char* level_filename) {
+// Show the minimap or the overview of the whole board as selected by the user.
+// The viewport is drawn again when one of them disappears.
+void showMaps(struct game_options* somegops, struct board* aboard, struct minimap* aminimap,
+              struct minimap* aoverview, bool* minimap_shown) {
+    bool redraw = (aboard->view_covered && !somegops->show_overview)
+        || (*minimap_shown && !somegops->show_minimap);
+
+    aboard->view_covered = somegops->show_overview;
+    *minimap_shown = somegops->show_minimap;
+    if (redraw) {
+        showViewport(aboard);
+    }
+    if (somegops->show_overview) {
+        showMinimap(aoverview, aboard);
+    } else if (somegops->show_minimap) {
+        showMinimap(aminimap, aboard);
+    }
+}
+
+// All memory of the level comes from the arena and is released at once
+// when the next level resets it
+enum ResCodes doLevel(struct game_options* somegops, struct arena* anarena,
+                      enum GameStates* agame_state, char* level_filename) {
     struct worm userworm; // Local variable for storing the user's worm
     struct board theboard;
+    struct autopilot thepilot; // Only used if somegops->autopilot is set
+    struct policy thepolicy;   // Only used if somegops->policy_filename is set
+    struct minimap theminimap;  // Minimap in the upper right corner
+    struct minimap theoverview; // The whole board downsampled to the viewport
+    struct food_index thefood;  // Positions of the food for the status line
+    struct occupancy theoccupancy;  // Worm and element per cell
+    struct renderer therenderer;    // Only used if somegops->render_thread is set
+    struct vt_screen thevt;         // Only used if somegops->vt_output is set
+    bool minimap_shown = false;
+    struct board* boardptr = &theboard;
+    struct worm* wormptr = &userworm;
 
     enum ResCodes res_code; // Result code from functions
     int end_level_loop;    // Indicates whether we should leave the main loop
+    int len_max;           // Maximal length of the worm
+    int tick;              // Number of iterations of the level loop
 
     struct pos bottomLeft;  // Start positions of the worm
 
-    // Setup the board
-    res_code = initializeBoard(&theboard);
+    // The memory of the previous level is reused
+    resetArena(anarena);
+
+    // Setup the board: as large as the level, but at least as large as the display.
+    // Generated levels fill the display.
+    if (level_filename != NULL) {
+        res_code = initializeBoard(&theboard, anarena, getLevelFileHeight(level_filename),
+                                   getLevelFileWidth(level_filename));
+    } else {
+        res_code = initializeBoard(&theboard, anarena, 0, 0);
+    }
     if (res_code != RES_OK) {
       return res_code;
     }
 
-    // Initialize the current level
-    res_code = initializeLevelFromFile(&theboard, level_filename);
+    // Initialize the current level: from the file or generated
+    if (level_filename != NULL) {
+        res_code = initializeLevelFromFile(&theboard, level_filename);
+    } else {
+        res_code = generateLevel(&theboard, somegops->level_type, somegops->level_seed, 0,
+                                 somegops->autopilot);
+    }
     if (res_code != RES_OK) {
       return res_code;
     }
@@ -107,27 +162,118 @@ enum ResCodes doLevel(struct game_options* somegops, enum GameStates* agame_stat
     // Initialize the userworm with its size, position, heading.
     bottomLeft.y =  getLastRowOnBoard(&theboard);
     bottomLeft.x =  0;
+
+    // The worm may grow until it covers the entire board.
+    // The autopilot confines it to the cells on its cycle.
+    len_max = (theboard.last_row + 1) * (theboard.last_col + 1);
+    if (somegops->autopilot) {
+        res_code = initializeAutopilot(&thepilot, &theboard, bottomLeft, !somegops->autopilot_fill);
+        if (res_code != RES_OK) {
+            return res_code;
+        }
+        len_max = getCycleLength(&thepilot);
+    } else if (somegops->policy_filename != NULL) {
+        res_code = loadPolicy(&thepolicy, somegops->policy_filename);
+        if (res_code != RES_OK) {
+            return res_code;
+        }
+    }
  
-    res_code = initializeWorm(&userworm, (theboard.last_row + 1) * (theboard.last_col + 1), WORM_INITIAL_LENGTH, bottomLeft, WORM_RIGHT, COLP_USER_WORM);
+    res_code = initializeWorm(&userworm, anarena, len_max, WORM_INITIAL_LENGTH, bottomLeft, WORM_RIGHT, COLP_USER_WORM);
     if ( res_code !=  RES_OK) {
+        if (!somegops->autopilot && somegops->policy_filename != NULL) {
+            cleanupPolicy(&thepolicy);
+        }
+        return res_code;
+    }
+
+    // From now on placeItem() keeps both maps and the food index up to date,
+    // the worm model keeps the occupancy up to date
+    res_code = initializeMinimap(&theminimap, &theboard, 0, theboard.view_cols - MINIMAP_COLS,
+                                 MINIMAP_ROWS, MINIMAP_COLS);
+    if (res_code == RES_OK) {
+        res_code = initializeMinimap(&theoverview, &theboard, 0, 0,
+                                     theboard.view_rows, theboard.view_cols);
+    }
+    if (res_code == RES_OK) {
+        res_code = initializeFoodIndex(&thefood, &theboard);
+    }
+    if (res_code == RES_OK) {
+        res_code = initializeOccupancy(&theoccupancy, &theboard);
+    }
+    if (res_code == RES_OK) {
+        res_code = addWormToOccupancy(&theoccupancy, &userworm);
+    }
+    if (res_code != RES_OK) {
+        if (!somegops->autopilot && somegops->policy_filename != NULL) {
+            cleanupPolicy(&thepolicy);
+        }
         return res_code;
     }
 
     // Show worm at its initial position
-    showWorm(&theboard, &userworm);
+    updateViewport(&theboard, bottomLeft);
+    if (showWorm(&theboard, &userworm) != RES_OK) {
+        showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+        if (!somegops->autopilot && somegops->policy_filename != NULL) {
+            cleanupPolicy(&thepolicy);
+        }
+        return RES_FAILED;
+    }
+    showMaps(somegops, &theboard, &theminimap, &theoverview, &minimap_shown);
     // Display all what we hev set up until now
     refresh();
 
+    // From now on the raw VT backend replaces curses for the level
+    if (somegops->vt_output) {
+        res_code = initializeVtScreen(&thevt, STDOUT_FILENO);
+        if (res_code == RES_OK) {
+            setVtScreen(&thevt);
+        }
+    }
+    // From now on only the render thread calls curses
+    if (res_code == RES_OK && somegops->render_thread) {
+        res_code = startRenderer(&therenderer);
+        if (res_code != RES_OK && somegops->vt_output) {
+            setVtScreen(NULL);
+            cleanupVtScreen(&thevt);
+        }
+    }
+    if (res_code != RES_OK) {
+        if (!somegops->autopilot && somegops->policy_filename != NULL) {
+            cleanupPolicy(&thepolicy);
+        }
+        return res_code;
+    }
+
     // Start the loop for this level
     end_level_loop = false; // Flag for controlling the main loop
+    tick = 0;
     while(!end_level_loop) {
         // Process optional user input
-        readUserInput(&userworm, agame_state); 
+        readUserInput(somegops, &userworm, agame_state); 
         if ( *agame_state == WORM_GAME_QUIT ) {
             end_level_loop = true;
             continue; // Go to beginning of the loop's block and check loop condition
         }
 
+        // The autopilot overrides the heading chosen by the user
+        if (somegops->autopilot) {
+            setWormHeading(&userworm, getAutopilotHeading(&thepilot, &theboard, &userworm));
+            // In fill mode the worm grows by one element per tick on average
+            if (somegops->autopilot_fill && tick % BONUS_1 == 0) {
+                growWorm(&userworm, BONUS_1);
+            }
+        }
+        // A learned policy overrides the heading chosen by the user
+        if (!somegops->autopilot && somegops->policy_filename != NULL) {
+            enum WormHeading heading;
+            if (choosePolicyHeadings(&thepolicy, &boardptr, &wormptr, 1, NULL, &heading) == RES_OK) {
+                setWormHeading(&userworm, heading);
+            }
+        }
+        tick++;
+
         // Process userworm
         // Clean the tail of the worm
         cleanWormTail(&theboard, &userworm);
@@ -139,26 +285,59 @@ enum ResCodes doLevel(struct game_options* somegops, enum GameStates* agame_stat
             end_level_loop = true;
             continue; // Go to beginning of the loop's block and check loop condition
         }
-        // Show the worm at its new position
-        showWorm(&theboard, &userworm);
+        // Scroll the viewport if the head comes close to its edge
+        updateViewport(&theboard, getWormHeadPos(&userworm));
+        // Show the worm at its new position and move the hazards of the level.
+        // Without memory for a tile the level cannot go on; the error is
+        // reported after the render thread has stopped.
+        if (showWorm(&theboard, &userworm) != RES_OK || updateHazards(&theboard) != RES_OK) {
+            res_code = RES_FAILED;
+            end_level_loop = true;
+            continue;
+        }
         // END process userworm
         
         // Inform user about position and length of userworm in status window
         showStatus(&theboard, &userworm);
+        showMaps(somegops, &theboard, &theminimap, &theoverview, &minimap_shown);
 
         // Sleep a bit before we show the updated window
         napms(somegops->nap_time);
 
         // Display all the updates
-        refresh();
+        showFrame();
 
         // Are we done with that level?
         if (getNumberOfFoodItems(&theboard) == 0) {
           end_level_loop = true;
         }
+        // In fill mode we are done once the worm covers the entire cycle
+        if (somegops->autopilot_fill && getWormLength(&userworm) == getWormMaxLength(&userworm)) {
+          end_level_loop = true;
+        }
+        // Otherwise the autopilot stops if no more food lies on its cycle
+        if (somegops->autopilot && !somegops->autopilot_fill
+            && getCycleDistanceToFood(&thepilot, &theboard, getWormHeadPos(&userworm)) < 0) {
+          end_level_loop = true;
+        }
 
         // Start next iteration
     }
+    if (somegops->render_thread) {
+        stopRenderer(&therenderer);
+    }
+    if (somegops->vt_output) {
+        setVtScreen(NULL);
+        cleanupVtScreen(&thevt);
+    }
+    if (res_code != RES_OK) {
+        showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+        removeWorm(&theboard, &userworm);
+        if (!somegops->autopilot && somegops->policy_filename != NULL) {
+            cleanupPolicy(&thepolicy);
+        }
+        return res_code;
+    }
 
     // Preset res_code for rest of the function
     res_code = RES_OK;
@@ -169,6 +348,10 @@ enum ResCodes doLevel(struct game_options* somegops, enum GameStates* agame_stat
       case WORM_GAME_ONGOING:
         if (getNumberOfFoodItems(&theboard) == 0) {
           showDialog("Runde erfolgreich beendet!", "Bitte Taste drücken");
+        } else if (somegops->autopilot_fill && getWormLength(&userworm) == getWormMaxLength(&userworm)) {
+          showDialog("Der Wurm fuellt das Spielfeld!", "Bitte Taste druecken");
+        } else if (somegops->autopilot) {
+          showDialog("Autopilot: restliches Futter liegt nicht auf dem Zyklus", "Bitte Taste druecken");
         } else {
           showDialog("Interner Fehler!", "Bitte Taste drücken");
           // correct result code
@@ -203,13 +386,118 @@ enum ResCodes doLevel(struct game_options* somegops, enum GameStates* agame_stat
     
     // remove the worm from display and board
     removeWorm(&theboard, &userworm);
-    // Because initialize Worm allocates memory
-    cleanupWorm(&userworm);
 
-    cleanupBoard(&theboard);
+    // The policy is loaded from its own file and kept on the heap.
+    // Board, worm, autopilot, maps and food index stay in the arena
+    // until the next level.
+    if (!somegops->autopilot && somegops->policy_filename != NULL) {
+        cleanupPolicy(&thepolicy);
+    }
     return res_code; 
 }
 
+// Play in the endless world until the worm dies or the user quits
+enum ResCodes doEndlessWorld(struct game_options* somegops, enum GameStates* agame_state) {
+    struct worm userworm; // Local variable for storing the user's worm
+    struct world* theworld;
+    struct board* boardptr;
+
+    enum ResCodes res_code; // Result code from functions
+    int end_level_loop;    // Indicates whether we should leave the main loop
+
+    // The world is too large for the stack
+    theworld = malloc(sizeof(struct world));
+    if (theworld == NULL) {
+        showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+        return RES_FAILED;
+    }
+    res_code = initializeWorld(theworld, somegops->world_seed);
+    if (res_code != RES_OK) {
+        free(theworld);
+        return res_code;
+    }
+    boardptr = getWorldBoard(theworld);
+
+    res_code = initializeWorm(&userworm, NULL, getWorldMaxWormLength(), WORM_INITIAL_LENGTH,
+                              getWorldStartPos(theworld), WORM_RIGHT, COLP_USER_WORM);
+    if ( res_code !=  RES_OK) {
+        cleanupWorld(theworld);
+        free(theworld);
+        return res_code;
+    }
+
+    if (showWorm(boardptr, &userworm) != RES_OK) {
+        showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+        cleanupWorm(&userworm);
+        cleanupWorld(theworld);
+        free(theworld);
+        return RES_FAILED;
+    }
+    showWorldView(theworld, &userworm);
+    refresh();
+
+    end_level_loop = false;
+    while(!end_level_loop) {
+        readUserInput(somegops, &userworm, agame_state);
+        if ( *agame_state == WORM_GAME_QUIT ) {
+            end_level_loop = true;
+            continue;
+        }
+
+        cleanWormTail(boardptr, &userworm);
+        moveWorm(boardptr, &userworm, agame_state);
+        if ( *agame_state !=  WORM_GAME_ONGOING ) {
+            end_level_loop = true;
+            continue;
+        }
+        // Stream chunks around the new head position; never waits for the worker
+        if (showWorm(boardptr, &userworm) != RES_OK || updateWorld(theworld, &userworm) != RES_OK) {
+            res_code = RES_FAILED;
+            end_level_loop = true;
+            continue;
+        }
+
+        showWorldView(theworld, &userworm);
+        showWorldStatus(theworld, &userworm);
+        napms(somegops->nap_time);
+        refresh();
+    }
+    if (res_code != RES_OK) {
+        showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
+        removeWorm(boardptr, &userworm);
+        cleanupWorm(&userworm);
+        cleanupWorld(theworld);
+        free(theworld);
+        return res_code;
+    }
+
+    res_code = RES_OK;
+    switch (*agame_state) {
+      case WORM_GAME_QUIT:
+        showDialog("Sie haben die Reise durch die Welt abgebrochen!", "Bitte Taste druecken");
+        break;
+      case WORM_CRASH:
+        showDialog("Sie haben das Spiel verloren,"
+            " weil Sie eine Barriere getroffen haben",
+            "Bitte Taste druecken");
+        break;
+      case WORM_CROSSING:
+        showDialog("Sie haben das Spiel verloren,"
+            " weil Sie einen Wurm gekreuzt haben",
+            "Bitte Taste druecken");
+        break;
+      default:
+        showDialog("InternerFehler", "Bitte Taste druecken...");
+        res_code = RES_INTERNAL_ERROR;
+    }
+
+    removeWorm(boardptr, &userworm);
+    cleanupWorm(&userworm);
+    cleanupWorld(theworld);
+    free(theworld);
+    return res_code;
+}
+
 enum ResCodes playGame(int argc, char* argv[]) {
   enum ResCodes res_code; // Result code from functions
   enum GameStates game_state; // The current game_state
@@ -224,6 +512,7 @@ enum ResCodes playGame(int argc, char* argv[]) {
   int cur_level = 0;  // The current level
 
   struct game_options thegops; // For options passed on the command line
+  struct arena thearena;       // Memory of the current level
 
   // Read the command line options
   res_code = readCommandLineOptions(&thegops, argc, argv);
@@ -239,10 +528,21 @@ enum ResCodes playGame(int argc, char* argv[]) {
   //Play the game
   // At the beginnung of the level, we still have a chance to win
   game_state = WORM_GAME_ONGOING;
-  if(thegops.start_level_filename != NULL) {
+  initializeArena(&thearena, ARENA_BLOCK_SIZE);
+  if (thegops.endless_world) {
+    res_code = doEndlessWorld(&thegops, &game_state);
+    free(thegops.start_level_filename);
+  } else if (thegops.generate_levels) {
+    // Endless campaign: a new level for the next seed after each cleared level
+    while (res_code == RES_OK && game_state == WORM_GAME_ONGOING) {
+      res_code = doLevel(&thegops, &thearena, &game_state, NULL);
+      thegops.level_seed++;
+    }
+    free(thegops.start_level_filename);
+  } else if(thegops.start_level_filename != NULL) {
     // User provided a filename on the command line.
     // Play only this level
-    res_code = doLevel(&thegops, &game_state, thegops.start_level_filename);
+    res_code = doLevel(&thegops, &thearena, &game_state, thegops.start_level_filename);
     
     // From here on we no longer need thegops.start_level_filename
     // Free the memory allocated by strdup in options.c
@@ -251,8 +551,10 @@ enum ResCodes playGame(int argc, char* argv[]) {
   } else {
     // Play standard level
     while (level_list[cur_level] != NULL && res_code == RES_OK && game_state == WORM_GAME_ONGOING) {
-    res_code = doLevel(&thegops, &game_state, level_list[cur_level]);
+    res_code = doLevel(&thegops, &thearena, &game_state, level_list[cur_level]);
     if (res_code != RES_OK) {
+      cleanupArena(&thearena);
+      free(thegops.policy_filename);
       return res_code;
     }
     cur_level++;
@@ -261,6 +563,9 @@ enum ResCodes playGame(int argc, char* argv[]) {
      showDialog("Du hast alle Level geschafft!", "Bitte druecke eine Taste");
     } 
   }
+  cleanupArena(&thearena);
+  // Free the memory allocated by strdup in options.c
+  free(thegops.policy_filename);
   return res_code;
 }
 // ********************************************************************************************
@@ -280,13 +585,13 @@ int main(int argc, char* argv[]) {
 
     // Check if the window is large enough to display messages in the message area
     // a has space for at least one line for the worm
-    if ( LINES < ROWS_RESERVED + MIN_NUMBER_OF_ROWS || COLS < MIN_NUMBER_OF_COLS ) {
+    if ( LINES < ROWS_RESERVED + MIN_VIEW_ROWS || COLS < MIN_VIEW_COLS ) {
         // Since we not even have the space for displaying messages
         // we print a conventional error message via printf after
         // the call of cleanupCursesApp()
         cleanupCursesApp();
         printf("Das Fenster ist zu klein: wir brauchen mindestens %dx%d\n",
-                MIN_NUMBER_OF_COLS, MIN_NUMBER_OF_ROWS );
+                MIN_VIEW_COLS, MIN_VIEW_ROWS + ROWS_RESERVED );
         res_code = RES_FAILED;
     } else {
         res_code = playGame(argc, argv);
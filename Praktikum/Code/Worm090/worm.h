@@ -24,6 +24,8 @@ enum ResCodes {
 #define ROWS_RESERVED 4   // Lines reserved for the status area + 1 for the separator line
 #define MIN_NUMBER_OF_ROWS 26  // The guaranteed number of rows available for the board
 #define MIN_NUMBER_OF_COLS 70  // The guaranteed number of columns available for the board
+#define MIN_VIEW_ROWS 10       // Smallest viewport; larger boards scroll
+#define MIN_VIEW_COLS 40
 
 // Numbers for color pairs used by curses macro COLOR_PAIR
 enum ColorPairs {
@@ -41,6 +43,9 @@ enum ColorPairs {
 #define SYMBOL_FOOD_1   '2'
 #define SYMBOL_FOOD_2   '4'
 #define SYMBOL_FOOD_3   '6'
+#define SYMBOL_PATROL_H '-'   // Barrier patrolling left and right (see hazards.c)
+#define SYMBOL_PATROL_V '|'   // Barrier patrolling up and down
+#define SYMBOL_BOUNCER  '%'   // Obstacle bouncing diagonally
 #define SYMBOL_WORM_HEAD_ELEMENT '0'
 #define SYMBOL_WORM_INNER_ELEMENT 'o'
 #define SYMBOL_WORM_TAIL_ELEMENT '`'
@@ -0,0 +1,274 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// worm-bench: timing of the engine core, used by make bench
+//
+// For each level the tool times the three operations every game needs:
+// - load:  read the level file into a new headless board
+// - reset: copy the loaded board for a new game (as runHeadlessGame does)
+// - move:  one tick of the worm: cleanWormTail, moveWorm, showWorm, updateHazards
+// The worm follows a trivial rule (straight on, else the first free turn),
+// so the numbers do not include any search of a bot or the autopilot.
+// A worm that crashes is started again on a fresh copy of the board;
+// this restart is not counted as moves.
+//
+// With -a or -A the tool plays one game per level with the autopilot
+// instead (as worm -a or worm -A, without curses) and reports the ticks,
+// the part of the cycle the worm covers and why the game ended.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "hazards.h"
+#include "autopilot.h"
+#include "sim.h"
+
+#define BENCH_LOADS 200        // Default number of loads per level
+#define BENCH_RESETS 2000      // Default number of resets per level
+#define BENCH_MOVES 1000000    // Default number of moves per level
+
+enum BenchModes {
+    BENCH_TIMING,
+    BENCH_AUTOPILOT,       // -a: autopilot with shortcuts
+    BENCH_AUTOPILOT_FILL,  // -A: autopilot without shortcuts, growing every tick
+};
+
+struct bench_settings {
+    enum BenchModes mode;
+    int loads;
+    int resets;
+    int moves;             // Time limit in ticks in the autopilot modes
+};
+
+static void usageBench() {
+    fprintf(stderr, "Aufruf: worm-bench [-h] [-a|-A] [-l loads] [-r resets] [-m moves] level ...\n");
+}
+
+static double getNanoseconds() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// Can the head enter the cell next to it in the given direction?
+static bool isStepFree(struct board* aboard, struct pos head, enum WormHeading dir) {
+    static const int dy[] = { [WORM_UP] = -1, [WORM_DOWN] = 1, [WORM_LEFT] = 0, [WORM_RIGHT] = 0 };
+    static const int dx[] = { [WORM_UP] = 0, [WORM_DOWN] = 0, [WORM_LEFT] = -1, [WORM_RIGHT] = 1 };
+    struct pos next;
+    enum BoardCodes content;
+
+    next.y = head.y + dy[dir];
+    next.x = head.x + dx[dir];
+    if (next.y < 0 || next.y > getLastRowOnBoard(aboard)
+        || next.x < 0 || next.x > getLastColOnBoard(aboard)) {
+        return false;
+    }
+    content = getContentAt(aboard, next);
+    return content != BC_BARRIER && content != BC_USED_BY_WORM;
+}
+
+// Straight on if possible, else the first free turn
+static enum WormHeading getBenchHeading(struct board* aboard, struct worm* aworm) {
+    static const enum WormHeading turns[][3] = {
+        [WORM_UP] = { WORM_UP, WORM_RIGHT, WORM_LEFT },
+        [WORM_DOWN] = { WORM_DOWN, WORM_LEFT, WORM_RIGHT },
+        [WORM_LEFT] = { WORM_LEFT, WORM_UP, WORM_DOWN },
+        [WORM_RIGHT] = { WORM_RIGHT, WORM_DOWN, WORM_UP },
+    };
+    enum WormHeading heading = getWormHeading(aworm);
+    struct pos head = getWormHeadPos(aworm);
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        if (isStepFree(aboard, head, turns[heading][i])) {
+            return turns[heading][i];
+        }
+    }
+    return heading;
+}
+
+// Time the moves of worms on copies of level; result in nanoseconds per move
+static enum ResCodes timeMoves(struct board* level, int moves, double* ns_per_move) {
+    double elapsed = 0;
+    int done = 0;
+
+    while (done < moves) {
+        struct board theboard;
+        struct worm theworm;
+        struct pos bottomLeft;
+        enum GameStates game_state = WORM_GAME_ONGOING;
+        enum ResCodes res_code = RES_OK;
+        double start;
+        int before = done;
+
+        if (copyBoard(&theboard, level) != RES_OK) {
+            return RES_FAILED;
+        }
+        bottomLeft.y = getLastRowOnBoard(&theboard);
+        bottomLeft.x = 0;
+        if (initializeWorm(&theworm, NULL, (theboard.last_row + 1) * (theboard.last_col + 1),
+                           WORM_INITIAL_LENGTH, bottomLeft, WORM_RIGHT, COLP_USER_WORM) != RES_OK) {
+            cleanupBoard(&theboard);
+            return RES_FAILED;
+        }
+        if (showWorm(&theboard, &theworm) != RES_OK) {
+            cleanupWorm(&theworm);
+            cleanupBoard(&theboard);
+            return RES_FAILED;
+        }
+
+        start = getNanoseconds();
+        while (done < moves && game_state == WORM_GAME_ONGOING) {
+            setWormHeading(&theworm, getBenchHeading(&theboard, &theworm));
+            cleanWormTail(&theboard, &theworm);
+            moveWorm(&theboard, &theworm, &game_state);
+            if (game_state == WORM_GAME_ONGOING
+                && (showWorm(&theboard, &theworm) != RES_OK || updateHazards(&theboard) != RES_OK)) {
+                res_code = RES_FAILED;
+                break;
+            }
+            done++;
+        }
+        elapsed += getNanoseconds() - start;
+
+        cleanupWorm(&theworm);
+        cleanupBoard(&theboard);
+        if (res_code != RES_OK) {
+            return res_code;
+        }
+        if (done == before + 1 && game_state != WORM_GAME_ONGOING) {
+            return RES_FAILED;  // The worm cannot move at all on this level
+        }
+    }
+    *ns_per_move = elapsed / moves;
+    return RES_OK;
+}
+
+static enum ResCodes benchLevel(const char* filename, struct bench_settings* settings) {
+    struct board level;
+    struct board copy;
+    int nrows = getLevelFileHeight(filename);
+    double start, load_ns, reset_ns, move_ns;
+    int i;
+
+    start = getNanoseconds();
+    for (i = 0; i < settings -> loads; i++) {
+        if (loadHeadlessLevel(&level, filename, nrows, 0) != RES_OK) {
+            return RES_FAILED;
+        }
+        cleanupBoard(&level);
+    }
+    load_ns = (getNanoseconds() - start) / settings -> loads;
+
+    if (loadHeadlessLevel(&level, filename, nrows, 0) != RES_OK) {
+        return RES_FAILED;
+    }
+    start = getNanoseconds();
+    for (i = 0; i < settings -> resets; i++) {
+        if (copyBoard(&copy, &level) != RES_OK) {
+            cleanupBoard(&level);
+            return RES_FAILED;
+        }
+        cleanupBoard(&copy);
+    }
+    reset_ns = (getNanoseconds() - start) / settings -> resets;
+
+    if (timeMoves(&level, settings -> moves, &move_ns) != RES_OK) {
+        cleanupBoard(&level);
+        return RES_FAILED;
+    }
+    cleanupBoard(&level);
+
+    printf("%-28s %12.1f %12.2f %12.1f\n", filename, load_ns / 1e3, reset_ns / 1e3, move_ns);
+    return RES_OK;
+}
+
+static const char* getAutopilotEndName(struct autopilot_result* result) {
+    switch (result -> end) {
+        case AUTOPILOT_CLEARED: return "alles Futter";
+        case AUTOPILOT_FILLED: return "Zyklus voll";
+        case AUTOPILOT_FOOD_OFF_CYCLE: return "Futter nicht auf Zyklus";
+        case AUTOPILOT_OUT_OF_TIME: return "Zeit abgelaufen";
+        default: break;
+    }
+    switch (result -> game.state) {
+        case WORM_CRASH: return "Barriere getroffen";
+        case WORM_OUT_OF_BOUNDS: return "Spielfeld verlassen";
+        case WORM_CROSSING: return "Wurm gekreuzt";
+        default: return "Interner Fehler";
+    }
+}
+
+// Play one game with the autopilot on the level
+static enum ResCodes benchAutopilot(const char* filename, struct bench_settings* settings) {
+    struct board level;
+    struct autopilot_result result;
+    double start, move_ns;
+
+    if (loadHeadlessLevel(&level, filename, getLevelFileHeight(filename), 0) != RES_OK) {
+        return RES_FAILED;
+    }
+    start = getNanoseconds();
+    if (runAutopilotGame(&level, settings -> mode == BENCH_AUTOPILOT_FILL, settings -> moves,
+                         &result) != RES_OK) {
+        cleanupBoard(&level);
+        return RES_FAILED;
+    }
+    move_ns = (getNanoseconds() - start) / (result.game.ticks > 0 ? result.game.ticks : 1);
+    cleanupBoard(&level);
+
+    printf("%-28s %9d %7d %7d %6.1f%% %9.1f  %s\n", filename, result.game.ticks,
+           result.game.length, result.cycle_length,
+           100.0 * result.game.length / result.cycle_length, move_ns,
+           getAutopilotEndName(&result));
+    return RES_OK;
+}
+
+int main(int argc, char* argv[]) {
+    struct bench_settings settings = { BENCH_TIMING, BENCH_LOADS, BENCH_RESETS, BENCH_MOVES };
+    int i, c;
+
+    while ((c = getopt(argc, argv, "haAl:r:m:")) != -1) {
+        switch (c) {
+            case 'a': settings.mode = BENCH_AUTOPILOT; break;
+            case 'A': settings.mode = BENCH_AUTOPILOT_FILL; break;
+            case 'l': settings.loads = atoi(optarg); break;
+            case 'r': settings.resets = atoi(optarg); break;
+            case 'm': settings.moves = atoi(optarg); break;
+            default:
+                usageBench();
+                return RES_WRONG_OPTION;
+        }
+    }
+    if (optind == argc || settings.loads < 1 || settings.resets < 1 || settings.moves < 1) {
+        usageBench();
+        return RES_WRONG_OPTION;
+    }
+
+    if (settings.mode == BENCH_TIMING) {
+        printf("%-28s %12s %12s %12s\n", "Level", "Laden us", "Kopie us", "Zug ns");
+    } else {
+        printf("%-28s %9s %7s %7s %7s %9s  %s\n", "Level", "Ticks", "Laenge", "Zyklus",
+               "Anteil", "Zug ns", "Ende");
+    }
+    for (i = optind; i < argc; i++) {
+        enum ResCodes res_code = settings.mode == BENCH_TIMING
+            ? benchLevel(argv[i], &settings) : benchAutopilot(argv[i], &settings);
+        if (res_code != RES_OK) {
+            fprintf(stderr, "%s: Level kann nicht gemessen werden\n", argv[i]);
+            return RES_FAILED;
+        }
+    }
+    return RES_OK;
+}
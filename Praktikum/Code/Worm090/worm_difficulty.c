@@ -0,0 +1,313 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// worm-difficulty: estimate the difficulty of levels by mass simulation
+//
+// Reference bots of graded strength play batches of headless games on each
+// level. After every batch the 95% confidence interval (Wilson) of the clear
+// rate is computed; a bot stops as soon as the interval is narrow enough or
+// the maximum number of games is reached. The batches run in parallel threads.
+//
+// For each bot the tool reports the clear rate, a survival curve, the
+// distribution of the ticks needed to clear the level and the most frequent
+// causes of failure. The difficulty of a level is 100 * (1 - mean clear rate).
+// The last line for each level is "Schwierigkeit <score> <file>" so that the
+// output for many levels can be sorted easily.
+// The board is as large as the level file; -r sets the number of rows.
+//
+// With -p a learned policy plays as well and is reported like a bot, but does
+// not count for the difficulty. Its games of a batch run in lockstep with one
+// batched evaluation of the policy per tick instead of in threads.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "worm.h"
+#include "board_model.h"
+#include "bot.h"
+#include "sim.h"
+#include "policy.h"
+
+#define Z_95 1.96                // Quantile of the normal distribution for 95%
+#define SURVIVAL_POINTS 10       // Number of points of the survival curve
+#define NUMBER_OF_CAUSES 5       // enum GameStates without WORM_GAME_QUIT, plus time out
+#define CAUSE_TIME_OUT WORM_GAME_QUIT  // Slot of time outs among the causes
+
+// A reference bot
+struct reference_bot {
+    const char* name;
+    float params[BOT_NUMBER_OF_PARAMS];
+};
+
+// Ordered from strong to weak. Weaker bots weigh the food distance less
+// against the noise; the weakest one ignores the size of the region it enters.
+static const struct reference_bot reference_bots[] = {
+    { "stark",   { 100.0f, 8.0f, 0.2f, 0.2f, 0.5f } },
+    { "mittel",  {  50.0f, 8.0f, 0.5f, 0.5f, 1.0f } },
+    { "schwach", {  20.0f, 0.0f, 0.0f, 0.0f, 1.0f } },
+};
+#define NUMBER_OF_BOTS (sizeof(reference_bots) / sizeof(reference_bots[0]))
+#define POLICY_PLAYER NUMBER_OF_BOTS  // Player number of the policy after the bots
+
+static const char* cause_names[NUMBER_OF_CAUSES] = {
+    [WORM_CRASH] = "Hindernis",
+    [WORM_OUT_OF_BOUNDS] = "Rand",
+    [WORM_CROSSING] = "Selbstkreuzung",
+    [CAUSE_TIME_OUT] = "Zeitlimit",
+};
+
+// Settings of a run
+struct settings {
+    int max_games;       // Per bot and level
+    int batch;           // Games between two checks of the confidence interval
+    double epsilon;      // Stop if the half width of the interval is at most epsilon
+    int max_ticks;
+    uint32_t seed;
+    int nthreads;
+    int nrows;           // Rows of the board; 0: height of the level file
+    bool quiet;          // Only print the difficulty
+    struct policy* policy;  // Plays after the bots; NULL if none
+};
+
+// Half width of the Wilson score interval for k successes in n trials
+static double getWilsonHalfWidth(int k, int n) {
+    double p = (double) k / n;
+    double z2 = Z_95 * Z_95;
+    return Z_95 * sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+}
+
+static int compareInts(const void* a, const void* b) {
+    return *(const int*) a - *(const int*) b;
+}
+
+static const char* getPlayerName(int player) {
+    return player == POLICY_PLAYER ? "Strategie" : reference_bots[player].name;
+}
+
+// Play batches of games with a bot or the policy until the clear rate is
+// known well enough. Returns the number of games played.
+static int playUntilConverged(struct settings* set, struct board* level, int bot,
+                              struct game_job* jobs, struct game_result* results) {
+    int n = 0;
+    int cleared = 0;
+
+    while (n < set -> max_games) {
+        int batch = set -> batch < set -> max_games - n ? set -> batch : set -> max_games - n;
+        int i;
+
+        for (i = 0; i < batch; i++) {
+            jobs[i].level = level;
+            jobs[i].params = bot == POLICY_PLAYER ? NULL : reference_bots[bot].params;
+            jobs[i].seed = getGameSeed(set -> seed, bot, n + i);
+            jobs[i].max_ticks = set -> max_ticks;
+            jobs[i].result = &results[n + i];
+        }
+        if (bot == POLICY_PLAYER) {
+            if (runPolicyGames(set -> policy, jobs, batch) != RES_OK) {
+                return -1;
+            }
+        } else if (runHeadlessGames(jobs, batch, set -> nthreads) != RES_OK) {
+            return -1;
+        }
+        for (i = n; i < n + batch; i++) {
+            cleared += results[i].cleared;
+        }
+        n += batch;
+        if (getWilsonHalfWidth(cleared, n) <= set -> epsilon) {
+            break;
+        }
+    }
+    return n;
+}
+
+// Print the statistics of the games of a bot or the policy; returns the clear rate
+static double reportBot(struct settings* set, int bot, struct game_result* results, int n,
+                        int* ticks) {
+    int causes[NUMBER_OF_CAUSES] = { 0 };
+    int order[NUMBER_OF_CAUSES];
+    int cleared = 0;
+    int i, j;
+    double rate, half;
+
+    for (i = 0; i < n; i++) {
+        if (results[i].cleared) {
+            ticks[cleared++] = results[i].ticks;
+        } else if (results[i].state == WORM_GAME_ONGOING) {
+            causes[CAUSE_TIME_OUT]++;
+        } else {
+            causes[results[i].state]++;
+        }
+    }
+    rate = (double) cleared / n;
+    if (set -> quiet) {
+        return rate;
+    }
+    half = getWilsonHalfWidth(cleared, n);
+    printf("  Bot %-8s %5d Spiele, geschafft %5.1f%% [%5.1f%%, %5.1f%%]\n",
+           getPlayerName(bot), n, 100.0 * rate,
+           100.0 * (rate - half > 0.0 ? rate - half : 0.0),
+           100.0 * (rate + half < 1.0 ? rate + half : 1.0));
+
+    if (cleared > 0) {
+        qsort(ticks, cleared, sizeof(int), compareInts);
+        printf("    Ticks bis geschafft: min %d, Median %d, 90%% %d, max %d\n",
+               ticks[0], ticks[cleared / 2], ticks[(cleared * 9) / 10], ticks[cleared - 1]);
+    }
+
+    // Fraction of games still running (or cleared) at tick t
+    printf("    Ueberleben:");
+    for (j = 1; j <= SURVIVAL_POINTS; j++) {
+        int t = (set -> max_ticks * j) / SURVIVAL_POINTS;
+        int alive = 0;
+        for (i = 0; i < n; i++) {
+            alive += results[i].state == WORM_GAME_ONGOING || results[i].ticks > t;
+        }
+        printf(" %d:%.0f%%", t, 100.0 * alive / n);
+    }
+    printf("\n");
+
+    // Causes of failure, most frequent first
+    for (i = 0; i < NUMBER_OF_CAUSES; i++) {
+        order[i] = i;
+    }
+    for (i = 1; i < NUMBER_OF_CAUSES; i++) {
+        for (j = i; j > 0 && causes[order[j]] > causes[order[j - 1]]; j--) {
+            int tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    }
+    printf("    Ausfaelle:");
+    for (i = 0; i < NUMBER_OF_CAUSES && causes[order[i]] > 0; i++) {
+        printf(" %s %d", cause_names[order[i]], causes[order[i]]);
+    }
+    printf(i == 0 ? " keine\n" : "\n");
+    return rate;
+}
+
+// Estimate the difficulty of one level
+static enum ResCodes rateLevel(struct settings* set, const char* filename,
+                               struct game_job* jobs, struct game_result* results, int* ticks) {
+    struct board level;
+    double sum = 0.0;
+    int bot;
+
+    if (loadHeadlessLevel(&level, filename,
+                          set -> nrows > 0 ? set -> nrows : getLevelFileHeight(filename), 0) != RES_OK) {
+        return RES_FAILED;
+    }
+    if (!set -> quiet) {
+        printf("Level %s (%d x %d, %d Futter)\n", filename, level.last_row + 1,
+               level.last_col + 1, getNumberOfFoodItems(&level));
+    }
+    for (bot = 0; bot < NUMBER_OF_BOTS; bot++) {
+        int n = playUntilConverged(set, &level, bot, jobs, results);
+        if (n < 0) {
+            cleanupBoard(&level);
+            return RES_FAILED;
+        }
+        sum += reportBot(set, bot, results, n, ticks);
+    }
+    if (set -> policy != NULL) {
+        int n = playUntilConverged(set, &level, POLICY_PLAYER, jobs, results);
+        if (n < 0) {
+            cleanupBoard(&level);
+            return RES_FAILED;
+        }
+        reportBot(set, POLICY_PLAYER, results, n, ticks);
+    }
+    printf("Schwierigkeit %5.1f %s\n", 100.0 * (1.0 - sum / NUMBER_OF_BOTS), filename);
+    fflush(stdout);
+    cleanupBoard(&level);
+    return RES_OK;
+}
+
+static void usageDifficulty() {
+    fprintf(stderr, "Aufruf: worm-difficulty [-h] [-q] [-n spiele] [-b batch] [-e epsilon]"
+            " [-m ticks] [-s seed] [-t threads] [-r zeilen] [-p strategie] Dateiname...\n");
+}
+
+int main(int argc, char* argv[]) {
+    struct settings set;
+    struct policy thepolicy;
+    char* policy_filename = NULL;
+    struct game_job* jobs;
+    struct game_result* results;
+    int* ticks;
+    enum ResCodes res = RES_OK;
+    int i, c;
+
+    set.max_games = 1000;
+    set.batch = 64;
+    set.epsilon = 0.05;
+    set.max_ticks = SIM_MAX_TICKS;
+    set.seed = 1;
+    set.nthreads = getDefaultThreadCount();
+    set.nrows = 0;
+    set.quiet = false;
+    set.policy = NULL;
+
+    while ((c = getopt(argc, argv, "hqn:b:e:m:s:t:r:p:")) != -1) {
+        switch (c) {
+            case 'q': set.quiet = true; break;
+            case 'n': set.max_games = atoi(optarg); break;
+            case 'b': set.batch = atoi(optarg); break;
+            case 'e': set.epsilon = atof(optarg); break;
+            case 'm': set.max_ticks = atoi(optarg); break;
+            case 's': set.seed = strtoul(optarg, NULL, 10); break;
+            case 't': set.nthreads = atoi(optarg); break;
+            case 'r': set.nrows = atoi(optarg); break;
+            case 'p': policy_filename = optarg; break;
+            default:
+                usageDifficulty();
+                return RES_WRONG_OPTION;
+        }
+    }
+    if (optind == argc || set.max_games < 1 || set.batch < 1 || set.max_ticks < 1
+        || (set.nrows != 0 && set.nrows < MIN_NUMBER_OF_ROWS)) {
+        usageDifficulty();
+        return RES_WRONG_OPTION;
+    }
+    if (set.nthreads < 1) {
+        set.nthreads = 1;
+    }
+
+    if (policy_filename != NULL) {
+        if (loadPolicy(&thepolicy, policy_filename) != RES_OK) {
+            return RES_FAILED;
+        }
+        set.policy = &thepolicy;
+    }
+
+    jobs = malloc(set.batch * sizeof(struct game_job));
+    results = malloc(set.max_games * sizeof(struct game_result));
+    ticks = malloc(set.max_games * sizeof(int));
+    if (jobs == NULL || results == NULL || ticks == NULL) {
+        fprintf(stderr, "Kein Speicher mehr\n");
+        return RES_FAILED;
+    }
+
+    // A broken level does not stop the others
+    for (i = optind; i < argc; i++) {
+        if (rateLevel(&set, argv[i], jobs, results, ticks) != RES_OK) {
+            res = RES_FAILED;
+        }
+    }
+
+    free(jobs);
+    free(results);
+    free(ticks);
+    if (set.policy != NULL) {
+        cleanupPolicy(set.policy);
+    }
+    return res;
+}
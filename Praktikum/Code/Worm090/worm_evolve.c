@@ -0,0 +1,487 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// worm-evolve: genetic tuning of the parameters of the heuristic bot
+//
+// A population of parameter vectors (genomes, see enum BotParams) is
+// evolved by tournament selection, uniform crossover, gaussian mutation
+// and elitism. The fitness of a genome is the mean score of headless games
+// on all given levels. Game seeds depend only on the base seed, the level
+// and the number of the game, so a genome always gets the same fitness.
+// Therefore fitness values are cached by genome and each genome is played
+// only once. All games of a generation run in parallel threads.
+//
+// After every generation the population is written to a checkpoint file
+// together with the number of the next generation. With option -r the
+// evolution resumes from that file with the next generation.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "worm.h"
+#include "board_model.h"
+#include "bot.h"
+#include "sim.h"
+
+#define MAX_LEVELS 64
+#define ELITES 2                 // Best genomes copied unchanged into the next generation
+#define TOURNAMENT_SIZE 3
+#define MUTATION_RATE 0.3        // Probability of mutating a parameter
+#define MUTATION_SIGMA 1.0       // Standard deviation of a mutation
+#define PARAM_INIT_MAX 10.0      // Initial parameters are drawn from [0, PARAM_INIT_MAX)
+#define CHECKPOINT_MAGIC "WORMEVOLVE1"
+
+// A genome and its fitness
+struct genome {
+    float params[BOT_NUMBER_OF_PARAMS];
+    double fitness;
+    int evaluated;
+};
+
+// An entry of the fitness cache
+struct cache_entry {
+    float params[BOT_NUMBER_OF_PARAMS];
+    double fitness;
+    int used;
+};
+
+// State of the evolution
+struct evolution {
+    int npop;
+    int generation;
+    int nthreads;
+    int games_per_level;
+    int max_ticks;
+    uint32_t seed;            // Base seed of the games
+    uint32_t rng;             // Random numbers for the genetic operators
+    int nlevels;
+    struct board levels[MAX_LEVELS];
+
+    struct genome* pop;
+    struct genome* next;
+
+    struct cache_entry* cache; // Open addressing, size is a power of two
+    int cache_size;
+    int cache_used;
+
+    // Games of the current generation
+    int* eval;                 // Indices of the genomes to evaluate
+    int neval;
+    struct game_job* jobs;       // neval x nlevels x games_per_level
+    struct game_result* results;
+};
+
+static const char* default_levels[] = {
+    "basic.level.1",
+    "squaredance.level.2",
+    "pirates-doom.level.3",
+    "pirates-doubledoom.level.4",
+    NULL
+};
+
+// Random number in [0, 1)
+static double nextUniform(struct evolution* evo) {
+    return (nextRandom(&evo -> rng) >> 8) / (double) (1 << 24);
+}
+
+// Normally distributed random number (Box-Muller)
+static double nextGaussian(struct evolution* evo) {
+    double u1 = nextUniform(evo);
+    double u2 = nextUniform(evo);
+    return sqrt(-2.0 * log(1.0 - u1)) * cos(2.0 * M_PI * u2);
+}
+
+// Fitness cache
+// ********************************************************************************************
+
+static uint32_t hashParams(const float* params) {
+    const unsigned char* bytes = (const unsigned char*) params;
+    uint32_t hash = 2166136261u;
+    size_t i;
+    for (i = 0; i < BOT_NUMBER_OF_PARAMS * sizeof(float); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static struct cache_entry* findCacheEntry(struct evolution* evo, const float* params) {
+    uint32_t i = hashParams(params) & (evo -> cache_size - 1);
+    while (evo -> cache[i].used
+           && memcmp(evo -> cache[i].params, params, sizeof(evo -> cache[i].params)) != 0) {
+        i = (i + 1) & (evo -> cache_size - 1);
+    }
+    return &evo -> cache[i];
+}
+
+static enum ResCodes insertCacheEntry(struct evolution* evo, const float* params, double fitness) {
+    struct cache_entry* entry;
+
+    // Keep the load factor below 1/2
+    if (2 * (evo -> cache_used + 1) > evo -> cache_size) {
+        struct cache_entry* old = evo -> cache;
+        int old_size = evo -> cache_size;
+        int i;
+
+        evo -> cache = calloc(2 * old_size, sizeof(struct cache_entry));
+        if (evo -> cache == NULL) {
+            evo -> cache = old;
+            return RES_FAILED;
+        }
+        evo -> cache_size = 2 * old_size;
+        for (i = 0; i < old_size; i++) {
+            if (old[i].used) {
+                *findCacheEntry(evo, old[i].params) = old[i];
+            }
+        }
+        free(old);
+    }
+    entry = findCacheEntry(evo, params);
+    if (!entry -> used) {
+        memcpy(entry -> params, params, sizeof(entry -> params));
+        entry -> used = 1;
+        evo -> cache_used++;
+    }
+    entry -> fitness = fitness;
+    return RES_OK;
+}
+
+// Evaluation
+// ********************************************************************************************
+
+// Score of a single game: food eaten, plus the ticks left if the level was cleared
+static double getGameScore(struct evolution* evo, struct game_result* result) {
+    return 100.0 * result -> food_eaten + (result -> cleared ? evo -> max_ticks - result -> ticks : 0);
+}
+
+// Compute the fitness of all genomes of the population.
+// Genomes found in the cache are not played again.
+static enum ResCodes evaluatePopulation(struct evolution* evo, int* games_played) {
+    int games = evo -> nlevels * evo -> games_per_level;
+    int i, j;
+
+    evo -> neval = 0;
+    for (i = 0; i < evo -> npop; i++) {
+        struct genome* g = &evo -> pop[i];
+        struct cache_entry* entry;
+        bool duplicate = false;
+
+        if (g -> evaluated) {
+            continue;
+        }
+        entry = findCacheEntry(evo, g -> params);
+        if (entry -> used) {
+            g -> fitness = entry -> fitness;
+            g -> evaluated = 1;
+            continue;
+        }
+        // Identical genomes within this generation are played once
+        for (j = 0; j < evo -> neval && !duplicate; j++) {
+            duplicate = memcmp(evo -> pop[evo -> eval[j]].params, g -> params, sizeof(g -> params)) == 0;
+        }
+        if (!duplicate) {
+            evo -> eval[evo -> neval++] = i;
+        }
+    }
+
+    for (i = 0; i < evo -> neval * games; i++) {
+        struct game_job* job = &evo -> jobs[i];
+        int level = (i % games) / evo -> games_per_level;
+        job -> level = &evo -> levels[level];
+        job -> params = evo -> pop[evo -> eval[i / games]].params;
+        job -> seed = getGameSeed(evo -> seed, level, i % evo -> games_per_level);
+        job -> max_ticks = evo -> max_ticks;
+        job -> result = &evo -> results[i];
+    }
+    if (runHeadlessGames(evo -> jobs, evo -> neval * games, evo -> nthreads) != RES_OK) {
+        return RES_FAILED;
+    }
+    *games_played = evo -> neval * games;
+
+    for (i = 0; i < evo -> neval; i++) {
+        struct genome* g = &evo -> pop[evo -> eval[i]];
+        double sum = 0.0;
+        for (j = 0; j < games; j++) {
+            sum += getGameScore(evo, &evo -> results[i * games + j]);
+        }
+        g -> fitness = sum / games;
+        g -> evaluated = 1;
+        if (insertCacheEntry(evo, g -> params, g -> fitness) != RES_OK) {
+            return RES_FAILED;
+        }
+    }
+    // Duplicates get their fitness from the cache now
+    for (i = 0; i < evo -> npop; i++) {
+        if (!evo -> pop[i].evaluated) {
+            evo -> pop[i].fitness = findCacheEntry(evo, evo -> pop[i].params) -> fitness;
+            evo -> pop[i].evaluated = 1;
+        }
+    }
+    return RES_OK;
+}
+
+// Genetic operators
+// ********************************************************************************************
+
+static void randomizeGenome(struct evolution* evo, struct genome* g) {
+    int k;
+    for (k = 0; k < BOT_NUMBER_OF_PARAMS; k++) {
+        g -> params[k] = PARAM_INIT_MAX * nextUniform(evo);
+    }
+    g -> evaluated = 0;
+}
+
+static struct genome* selectByTournament(struct evolution* evo) {
+    struct genome* best = NULL;
+    int i;
+    for (i = 0; i < TOURNAMENT_SIZE; i++) {
+        struct genome* g = &evo -> pop[nextRandom(&evo -> rng) % evo -> npop];
+        if (best == NULL || g -> fitness > best -> fitness) {
+            best = g;
+        }
+    }
+    return best;
+}
+
+static int compareFitness(const void* a, const void* b) {
+    double fa = ((const struct genome*) a) -> fitness;
+    double fb = ((const struct genome*) b) -> fitness;
+    return (fa < fb) - (fa > fb);  // Descending
+}
+
+// Breed the next generation from the evaluated (and sorted) population
+static void breedNextGeneration(struct evolution* evo) {
+    struct genome* tmp;
+    int i, k;
+
+    for (i = 0; i < evo -> npop; i++) {
+        struct genome* child = &evo -> next[i];
+        if (i < ELITES) {
+            *child = evo -> pop[i];
+            continue;
+        }
+        struct genome* mother = selectByTournament(evo);
+        struct genome* father = selectByTournament(evo);
+        for (k = 0; k < BOT_NUMBER_OF_PARAMS; k++) {
+            child -> params[k] = nextUniform(evo) < 0.5 ? mother -> params[k] : father -> params[k];
+            if (nextUniform(evo) < MUTATION_RATE) {
+                child -> params[k] += MUTATION_SIGMA * nextGaussian(evo);
+                if (child -> params[k] < 0.0f) {
+                    child -> params[k] = 0.0f;
+                }
+            }
+        }
+        child -> evaluated = 0;
+    }
+    tmp = evo -> pop;
+    evo -> pop = evo -> next;
+    evo -> next = tmp;
+}
+
+// Checkpoints
+// ********************************************************************************************
+
+// Write the evaluated population and the number of the next generation;
+// a temporary file is renamed so that a crash never leaves a truncated
+// checkpoint behind
+static enum ResCodes writeCheckpoint(struct evolution* evo, const char* filename) {
+    char tmpname[FILENAME_MAX];
+    FILE* out;
+    int i, k;
+
+    snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+    if ((out = fopen(tmpname, "w")) == NULL) {
+        fprintf(stderr, "Kann Datei %s nicht schreiben\n", tmpname);
+        return RES_FAILED;
+    }
+    fprintf(out, "%s\n%d %u %u %d %d\n", CHECKPOINT_MAGIC, evo -> generation + 1, evo -> rng,
+            evo -> seed, evo -> npop, BOT_NUMBER_OF_PARAMS);
+    for (i = 0; i < evo -> npop; i++) {
+        for (k = 0; k < BOT_NUMBER_OF_PARAMS; k++) {
+            fprintf(out, "%.9g ", evo -> pop[i].params[k]);
+        }
+        fprintf(out, "%.17g %d\n", evo -> pop[i].fitness, evo -> pop[i].evaluated);
+    }
+    if (fclose(out) != 0 || rename(tmpname, filename) != 0) {
+        fprintf(stderr, "Kann Datei %s nicht schreiben\n", filename);
+        return RES_FAILED;
+    }
+    return RES_OK;
+}
+
+static enum ResCodes readCheckpoint(struct evolution* evo, const char* filename) {
+    char magic[sizeof(CHECKPOINT_MAGIC) + 1];
+    FILE* in;
+    int nparams, npop;
+    int i, k;
+    bool ok;
+
+    if ((in = fopen(filename, "r")) == NULL) {
+        fprintf(stderr, "Kann Datei %s nicht oeffnen\n", filename);
+        return RES_FAILED;
+    }
+    ok = fscanf(in, "%12s %d %u %u %d %d", magic, &evo -> generation, &evo -> rng,
+                &evo -> seed, &npop, &nparams) == 6
+        && strcmp(magic, CHECKPOINT_MAGIC) == 0
+        && nparams == BOT_NUMBER_OF_PARAMS && npop == evo -> npop;
+    for (i = 0; ok && i < evo -> npop; i++) {
+        for (k = 0; ok && k < BOT_NUMBER_OF_PARAMS; k++) {
+            ok = fscanf(in, "%f", &evo -> pop[i].params[k]) == 1;
+        }
+        ok = ok && fscanf(in, "%lf %d", &evo -> pop[i].fitness, &evo -> pop[i].evaluated) == 2;
+        if (ok && evo -> pop[i].evaluated) {
+            ok = insertCacheEntry(evo, evo -> pop[i].params, evo -> pop[i].fitness) == RES_OK;
+        }
+    }
+    fclose(in);
+    if (!ok) {
+        fprintf(stderr, "Datei %s ist kein passender Checkpoint (Populationsgroesse %d?)\n",
+                filename, evo -> npop);
+        return RES_FAILED;
+    }
+    return RES_OK;
+}
+
+// Main
+// ********************************************************************************************
+
+static void usageEvolve() {
+    fprintf(stderr, "Aufruf: worm-evolve [-h] [-p population] [-g generationen] [-k spiele]"
+            " [-m ticks] [-s seed] [-t threads] [-c checkpoint [-r]] [Dateiname...]\n");
+}
+
+int main(int argc, char* argv[]) {
+    struct evolution* evo;
+    const char* checkpoint = NULL;
+    bool resume = false;
+    int ngenerations = 20;
+    int i, k, c;
+
+    evo = calloc(1, sizeof(struct evolution));
+    if (evo == NULL) {
+        return RES_FAILED;
+    }
+    evo -> npop = 64;
+    evo -> games_per_level = 4;
+    evo -> max_ticks = SIM_MAX_TICKS;
+    evo -> seed = 1;
+    evo -> nthreads = getDefaultThreadCount();
+
+    while ((c = getopt(argc, argv, "hp:g:k:m:s:t:c:r")) != -1) {
+        switch (c) {
+            case 'p': evo -> npop = atoi(optarg); break;
+            case 'g': ngenerations = atoi(optarg); break;
+            case 'k': evo -> games_per_level = atoi(optarg); break;
+            case 'm': evo -> max_ticks = atoi(optarg); break;
+            case 's': evo -> seed = strtoul(optarg, NULL, 10); break;
+            case 't': evo -> nthreads = atoi(optarg); break;
+            case 'c': checkpoint = optarg; break;
+            case 'r': resume = true; break;
+            default:
+                usageEvolve();
+                return RES_WRONG_OPTION;
+        }
+    }
+    if (evo -> npop <= ELITES || evo -> games_per_level < 1 || evo -> max_ticks < 1
+        || (resume && checkpoint == NULL)) {
+        usageEvolve();
+        return RES_WRONG_OPTION;
+    }
+    if (evo -> nthreads < 1) {
+        evo -> nthreads = 1;
+    }
+
+    // Load all levels once
+    for (i = optind; i < argc || (optind == argc && default_levels[i - optind] != NULL); i++) {
+        const char* filename = optind < argc ? argv[i] : default_levels[i - optind];
+        if (evo -> nlevels == MAX_LEVELS) {
+            break;
+        }
+        if (loadHeadlessLevel(&evo -> levels[evo -> nlevels], filename,
+                              getLevelFileHeight(filename), 0) != RES_OK) {
+            return RES_FAILED;
+        }
+        evo -> nlevels++;
+    }
+
+    evo -> pop = calloc(evo -> npop, sizeof(struct genome));
+    evo -> next = calloc(evo -> npop, sizeof(struct genome));
+    evo -> eval = malloc(evo -> npop * sizeof(int));
+    evo -> jobs = malloc((size_t) evo -> npop * evo -> nlevels * evo -> games_per_level
+                         * sizeof(struct game_job));
+    evo -> results = malloc((size_t) evo -> npop * evo -> nlevels * evo -> games_per_level
+                            * sizeof(struct game_result));
+    evo -> cache_size = 1024;
+    evo -> cache = calloc(evo -> cache_size, sizeof(struct cache_entry));
+    if (evo -> pop == NULL || evo -> next == NULL || evo -> eval == NULL
+        || evo -> jobs == NULL || evo -> results == NULL || evo -> cache == NULL) {
+        fprintf(stderr, "Kein Speicher mehr\n");
+        return RES_FAILED;
+    }
+
+    if (resume) {
+        if (readCheckpoint(evo, checkpoint) != RES_OK) {
+            return RES_FAILED;
+        }
+    } else {
+        evo -> rng = evo -> seed != 0 ? evo -> seed : 1;
+        for (i = 0; i < evo -> npop; i++) {
+            randomizeGenome(evo, &evo -> pop[i]);
+        }
+    }
+
+    for (; evo -> generation < ngenerations; evo -> generation++) {
+        struct timespec t_start, t_end;
+        int games_played;
+        double mean = 0.0;
+
+        if (evo -> generation > 0 && evo -> pop[0].evaluated && evo -> pop[evo -> npop - 1].evaluated) {
+            // Resumed after a complete generation: breed first
+            breedNextGeneration(evo);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        if (evaluatePopulation(evo, &games_played) != RES_OK) {
+            fprintf(stderr, "Kein Speicher mehr\n");
+            return RES_FAILED;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        qsort(evo -> pop, evo -> npop, sizeof(struct genome), compareFitness);
+
+        for (i = 0; i < evo -> npop; i++) {
+            mean += evo -> pop[i].fitness;
+        }
+        printf("Generation %d: beste Fitness %.1f, Mittel %.1f, %d Spiele in %.3f s, Parameter:",
+               evo -> generation, evo -> pop[0].fitness, mean / evo -> npop, games_played,
+               (t_end.tv_sec - t_start.tv_sec) + (t_end.tv_nsec - t_start.tv_nsec) / 1e9);
+        for (k = 0; k < BOT_NUMBER_OF_PARAMS; k++) {
+            printf(" %.3f", evo -> pop[0].params[k]);
+        }
+        printf("\n");
+        fflush(stdout);
+
+        if (checkpoint != NULL && writeCheckpoint(evo, checkpoint) != RES_OK) {
+            return RES_FAILED;
+        }
+    }
+
+    for (i = 0; i < evo -> nlevels; i++) {
+        cleanupBoard(&evo -> levels[i]);
+    }
+    free(evo -> pop);
+    free(evo -> next);
+    free(evo -> eval);
+    free(evo -> jobs);
+    free(evo -> results);
+    free(evo -> cache);
+    free(evo);
+    return RES_OK;
+}
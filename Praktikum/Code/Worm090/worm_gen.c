@@ -0,0 +1,99 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// worm-gen: write procedurally generated levels to level files
+//
+// Without -n one level is written to the file given by -o or to standard
+// output. With -n count the levels <name>.level.1 ... <name>.level.<count>
+// are written for the seeds seed, seed + 1, ..., where <name> is given by -o.
+// With -a the barriers are placed in 2x2 blocks, so that the autopilot can
+// eat all food of the levels.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "worm.h"
+#include "board_model.h"
+#include "levelgen.h"
+
+static void usageGen() {
+    fprintf(stderr, "Aufruf: worm-gen [-h] [-v] [-a] [-t hoehle|labyrinth|arena] [-s seed]"
+            " [-r zeilen] [-c spalten] [-f futter] [-n anzahl] [-o datei]\n");
+}
+
+int main(int argc, char* argv[]) {
+    struct board level;
+    enum LevelTypes type = LEVEL_CAVE;
+    unsigned long long seed = 1;
+    const char* output = NULL;
+    char filename[FILENAME_MAX];
+    bool verbose = false;
+    bool blocks = false;
+    int nrows = MIN_NUMBER_OF_ROWS;
+    int ncols = MIN_NUMBER_OF_COLS;
+    int nfood = 0;
+    int count = 0;
+    int i, c;
+
+    while ((c = getopt(argc, argv, "hvat:s:r:c:f:n:o:")) != -1) {
+        switch (c) {
+            case 'v': verbose = true; break;
+            case 'a': blocks = true; break;
+            case 't':
+                if (getLevelType(optarg, &type) != RES_OK) {
+                    usageGen();
+                    return RES_WRONG_OPTION;
+                }
+                break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'r': nrows = atoi(optarg); break;
+            case 'c': ncols = atoi(optarg); break;
+            case 'f': nfood = atoi(optarg); break;
+            case 'n': count = atoi(optarg); break;
+            case 'o': output = optarg; break;
+            default:
+                usageGen();
+                return RES_WRONG_OPTION;
+        }
+    }
+    if (optind != argc || nrows < 1 || ncols < 1 || count < 0 || (count > 0 && output == NULL)) {
+        usageGen();
+        return RES_WRONG_OPTION;
+    }
+
+    if (initializeHeadlessBoard(&level, nrows, ncols) != RES_OK) {
+        return RES_FAILED;
+    }
+    for (i = 0; i < (count > 0 ? count : 1); i++) {
+        struct timespec t_start, t_end;
+
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        if (generateLevel(&level, type, seed + i, nfood, blocks) != RES_OK) {
+            cleanupBoard(&level);
+            return RES_FAILED;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        if (count > 0) {
+            snprintf(filename, sizeof(filename), "%s.level.%d", output, i + 1);
+        }
+        if (saveLevelToFile(&level, count > 0 ? filename : output) != RES_OK) {
+            cleanupBoard(&level);
+            return RES_FAILED;
+        }
+        if (verbose) {
+            fprintf(stderr, "%s %dx%d Seed %llu: %d Futter, erzeugt in %.3f ms\n",
+                    getLevelTypeName(type), nrows, ncols, seed + i, getNumberOfFoodItems(&level),
+                    (t_end.tv_sec - t_start.tv_sec) * 1e3 + (t_end.tv_nsec - t_start.tv_nsec) / 1e6);
+        }
+    }
+    cleanupBoard(&level);
+    return RES_OK;
+}
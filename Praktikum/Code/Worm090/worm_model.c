@@ -12,7 +12,10 @@
 #include "board_model.h"
 #include "worm_model.h"
 #include <stdlib.h>
+#include <string.h>
 #include "messages.h"
+#include "arena.h"
+#include "occupancy.h"
 
 // The worm model
 // ********************************************************************************************
@@ -25,40 +28,62 @@
 // START WORM_DETAIL
 // The following functions all depend on the model of the worm
 
+// Position of the element at index in wormpos
+static struct pos getElementPos(struct worm* aworm, int index) {
+  struct pos p = { aworm -> wormpos[index].y, aworm -> wormpos[index].x };
+  return p;
+}
+
+static void setElementPos(struct worm* aworm, int index, struct pos p) {
+  aworm -> wormpos[index].y = p.y;
+  aworm -> wormpos[index].x = p.x;
+}
+
+// Index of the element that is n elements behind the head
+static int getIndexBehindHead(struct worm* aworm, int n) {
+  return (aworm -> headindex - n) & (aworm -> capacity - 1);
+}
+
 // Initialize the worm
-enum ResCodes initializeWorm(struct worm* aworm, int len_max, int len_cur,
+enum ResCodes initializeWorm(struct worm* aworm, struct arena* anarena, int len_max, int len_cur,
     struct pos headpos, enum WormHeading dir, enum ColorPairs color) {
-  // Local variables for loops etc.
-  int i;
-
-  // Initialize last usable index to len_max -1
-  aworm -> maxindex = len_max - 1;
+  // The worm may grow up to len_max elements
+  aworm -> maxlength = len_max;
   
-  // Current last usable index in array. May grow upto maxindex
-  aworm -> cur_lastindex = len_cur - 1;
+  // Current length of the worm. May grow upto maxlength
+  aworm -> length = len_cur;
 
-  //Initialize headindex
+  // Only the head is on the board.
+  // This allows for the effect that the worm appears element by element at the start of each level
+  aworm -> used = 1;
   aworm -> headindex = 0;
+  aworm -> arena = anarena;
+  aworm -> id = 0;
+  aworm -> head_ordinal = 0;
 
-  // Initialize the array for element positons
-  // Allocate an array of the worms length
-  aworm -> wormpos = malloc(len_max * sizeof(struct pos));
+#ifdef BOARD_ROWS
+  // The ring is part of the worm and as large as the board
+  aworm -> capacity = WORM_FIXED_CAPACITY;
+  if (aworm -> maxlength > aworm -> capacity) {
+    aworm -> maxlength = aworm -> capacity;
+  }
+#else
+  // Allocate a ring buffer for the current length; growWorm() enlarges it.
+  // The maximal length may be as large as the board.
+  aworm -> capacity = WORM_INITIAL_CAPACITY;
+  while (aworm -> capacity < len_cur) {
+    aworm -> capacity *= 2;
+  }
+  aworm -> wormpos = allocMemory(aworm -> arena, aworm -> capacity * sizeof(struct worm_pos));
 
   if (aworm->wormpos == NULL) {
     showDialog("Abbruch: Zu wenig Speicher", "Bitte eine Taste druecken");
-    exit(RES_FAILED); // No memory -> direct exit
+    return RES_FAILED;
   }
-
-  // Mark all elements as unused in the arrays of positions
-  // This allows for the effect that the worm appears element by element at the start of each level
-
-  for (i = 0; i <= aworm -> maxindex; i++){
-    aworm -> wormpos[i].y = len_cur;
-    aworm -> wormpos[i].x = 1;
-    }
+#endif
 
     // Initialize position of worms head
-    aworm -> wormpos[aworm -> headindex] = headpos;
+    setElementPos(aworm, aworm -> headindex, headpos);
 
     // Initialize the heading of the worm
     setWormHeading(aworm, dir);
@@ -71,21 +96,28 @@ enum ResCodes initializeWorm(struct worm* aworm, int len_max, int len_cur,
 
 // Show the worms's elements on the display
 // Simple version
-extern void showWorm(struct board* aboard, struct worm* aworm) {
+// Returns RES_FAILED if the head enters a tile without memory (see placeItem()).
+extern enum ResCodes showWorm(struct board* aboard, struct worm* aworm) {
     // Due to our encoding we just need to show the head element
     // All other elements are already displayed
-    placeItem(
+    if (placeItem(
             aboard,
             aworm -> wormpos[aworm -> headindex].y,
             aworm -> wormpos[aworm -> headindex].x,
             BC_USED_BY_WORM,
             SYMBOL_WORM_HEAD_ELEMENT,
-            aworm -> wcolor);
-    int innerindex;
-    innerindex = aworm -> headindex - 1;
-    if (innerindex < 0) {
-      innerindex = aworm -> cur_lastindex - 1;
+            aworm -> wcolor) != RES_OK) {
+      return RES_FAILED;
     }
+    if (aboard -> occupancy != NULL && aworm -> id != 0) {
+      setOccupant(aboard, aworm -> wormpos[aworm -> headindex].y,
+                  aworm -> wormpos[aworm -> headindex].x, aworm, aworm -> head_ordinal);
+    }
+    if (aworm -> used < 2) {
+      return RES_OK;
+    }
+    int innerindex;
+    innerindex = getIndexBehindHead(aworm, 1);
     placeItem(
             aboard,
             aworm -> wormpos[innerindex].y,
@@ -94,29 +126,25 @@ extern void showWorm(struct board* aboard, struct worm* aworm) {
             SYMBOL_WORM_INNER_ELEMENT, 
             aworm -> wcolor);
     int tailindex;
-    tailindex = (aworm -> headindex + 1) % aworm -> cur_lastindex;
-    if (aworm -> wormpos[tailindex].y != UNUSED_POS_ELEM) {
-      placeItem(
-              aboard,
-              aworm -> wormpos[tailindex].y,
-              aworm -> wormpos[tailindex].x,
-              BC_USED_BY_WORM,
-              SYMBOL_WORM_TAIL_ELEMENT,
-              aworm -> wcolor);
-    }
-
+    tailindex = getIndexBehindHead(aworm, aworm -> used - 1);
+    placeItem(
+            aboard,
+            aworm -> wormpos[tailindex].y,
+            aworm -> wormpos[tailindex].x,
+            BC_USED_BY_WORM,
+            SYMBOL_WORM_TAIL_ELEMENT,
+            aworm -> wcolor);
+    // The cells behind the head are in tiles with memory already
+    return RES_OK;
 }
 
 extern void cleanWormTail(struct board* aboard, struct worm* aworm) {
-    // Compute tailindex
-    int tailindex = (aworm -> headindex + 1) % aworm -> cur_lastindex;
-
-    // Check the array of worm elements.
-    // Is the array element at tailindex already in use?
-    // Checking either array theworm_wormpos_y
-    // or theworm_wormpos_x is enough.
-    if (aworm -> wormpos[tailindex].x != UNUSED_POS_ELEM) {
-      // YES: place a SYMBOL_FREE_CELL at the tails position
+    // Has the worm reached its full length?
+    // If not, it grows by one element in the next move and keeps its tail.
+    if (aworm -> used >= aworm -> length) {
+      // YES: place a SYMBOL_FREE_CELL at the tails position and drop the tail.
+      // The position of the head stays in the buffer even if used drops to 0.
+      int tailindex = getIndexBehindHead(aworm, aworm -> used - 1);
       placeItem(
               aboard,
               aworm -> wormpos[tailindex].y,
@@ -124,12 +152,16 @@ extern void cleanWormTail(struct board* aboard, struct worm* aworm) {
               BC_FREE_CELL,
               SYMBOL_FREE_CELL,
               COLP_FREE_CELL);
+      if (aboard -> occupancy != NULL && aworm -> id != 0) {
+        clearOccupant(aboard, aworm -> wormpos[tailindex].y, aworm -> wormpos[tailindex].x);
+      }
+      aworm -> used--;
     }
 }
 
 extern void moveWorm(struct board* aboard, struct worm* aworm, enum GameStates* agame_state) {
     //struct pos headpos;
-    struct pos headpos = aworm -> wormpos[aworm -> headindex];
+    struct pos headpos = getElementPos(aworm, aworm -> headindex);
 
     // Get the current position of the worm's head element and
     // compute the new head position according to current heading.
@@ -139,6 +171,11 @@ extern void moveWorm(struct board* aboard, struct worm* aworm, enum GameStates*
 
     headpos.x = headpos.x + aworm -> dx;
     headpos.y = headpos.y + aworm -> dy;
+    // On a wrapping board the worm leaves at one edge and enters at the opposite one
+    if (aboard -> wraps) {
+      headpos.x = (headpos.x + getLastColOnBoard(aboard) + 1) % (getLastColOnBoard(aboard) + 1);
+      headpos.y = (headpos.y + getLastRowOnBoard(aboard) + 1) % (getLastRowOnBoard(aboard) + 1);
+    }
     // Check if we would hit something (for good or bad) or are going to leave
     // the display if we move the worm's head according to worm's last
     // direction. We are not allowed to leave the display's window.
@@ -178,33 +215,94 @@ extern void moveWorm(struct board* aboard, struct worm* aworm, enum GameStates*
       }
     }
 
-      if (*agame_state == WORM_GAME_ONGOING) {
-        aworm -> headindex = (aworm -> headindex + 1) % aworm -> cur_lastindex;
-        if (aworm -> headindex >= aworm -> cur_lastindex)  {
-          aworm -> headindex = 0;
-       }
+    if (*agame_state == WORM_GAME_ONGOING) {
+      // Push the new head; growWorm() made room for it
+      aworm -> headindex = (aworm -> headindex + 1) & (aworm -> capacity - 1);
+      aworm -> used++;
+      aworm -> head_ordinal++;
       // Store new coordinates of head element in worm structure
-      aworm -> wormpos[aworm -> headindex] = headpos;
+      setElementPos(aworm, aworm -> headindex, headpos);
     }
 }
 
 void growWorm(struct worm* aworm, enum Boni growth) {
-  if (aworm -> cur_lastindex + growth <= aworm -> maxindex) {
-    aworm -> cur_lastindex += growth;
+  int new_length;
+
+  if (aworm -> length + growth <= aworm -> maxlength) {
+    new_length = aworm -> length + growth;
   } else {
-    aworm -> cur_lastindex = aworm -> maxindex;
+    new_length = aworm -> maxlength;
+  }
+#ifndef BOARD_ROWS
+  // Enlarge the ring buffer by doubling
+  if (new_length > aworm -> capacity) {
+    int capacity = aworm -> capacity;
+    int tailindex = getIndexBehindHead(aworm, aworm -> used - 1);
+    struct worm_pos* wormpos;
+
+    while (capacity < new_length) {
+      capacity *= 2;
+    }
+    if ((wormpos = resizeMemory(aworm -> arena, aworm -> wormpos, aworm -> capacity * sizeof(struct worm_pos),
+                                capacity * sizeof(struct worm_pos))) == NULL) {
+      // No memory: the worm stops growing
+      new_length = aworm -> capacity;
+    } else {
+      // Elements that wrapped around to the start of the old buffer
+      // are moved behind its end, so the ring stays contiguous
+      if (tailindex + aworm -> used > aworm -> capacity) {
+        memcpy(wormpos + aworm -> capacity, wormpos, (aworm -> headindex + 1) * sizeof(struct worm_pos));
+        aworm -> headindex += aworm -> capacity;
+      }
+      aworm -> wormpos = wormpos;
+      aworm -> capacity = capacity;
+    }
   }
+#endif
+  aworm -> length = new_length;
 }
 
 // Getters
 struct pos getWormHeadPos(struct worm* aworm){
   // Structures are passed by value!
   // -> we return a copy here
-  return aworm -> wormpos[aworm -> headindex];
+  return getElementPos(aworm, aworm -> headindex);
+}
+
+// Position of the oldest element of the worm
+struct pos getWormTailPos(struct worm* aworm){
+  int used = aworm -> used > 0 ? aworm -> used : 1;
+  return getElementPos(aworm, getIndexBehindHead(aworm, used - 1));
+}
+
+enum WormHeading getWormHeading(struct worm* aworm){
+  if (aworm -> dy < 0) {
+    return WORM_UP;
+  } else if (aworm -> dy > 0) {
+    return WORM_DOWN;
+  } else if (aworm -> dx < 0) {
+    return WORM_LEFT;
+  }
+  return WORM_RIGHT;
 }
 
 int getWormLength(struct worm* aworm){
-  return aworm -> cur_lastindex;
+  return aworm -> length;
+}
+
+int getWormMaxLength(struct worm* aworm){
+  return aworm -> maxlength;
+}
+
+// Number of ticks until the element with the given ordinal leaves its cell.
+// The tail leaves one cell per tick once the worm has its full length.
+// Ordinals are compared modulo 2^24 (see occupancy.h).
+int getTicksUntilElementFree(struct worm* aworm, unsigned int ordinal) {
+  unsigned int tail_ordinal = aworm -> head_ordinal - (aworm -> used - 1);
+  int behind_tail = (ordinal - tail_ordinal) & OCCUPANCY_ORDINAL_MASK;
+  int growing = aworm -> length > aworm -> used ? aworm -> length - aworm -> used : 0;
+
+  return growing + behind_tail + 1;
 }
 
 // Setters
@@ -230,19 +328,22 @@ extern void setWormHeading(struct worm* aworm, enum WormHeading dir) {
 }
 
 void cleanupWorm(struct worm* aworm) {
+#ifndef BOARD_ROWS
   // free array of wormpos
-  free(aworm->wormpos);
+  freeMemory(aworm -> arena, aworm -> wormpos);
+#endif
 }
 
 // Remove a worm from the board and clean the display
 void removeWorm(struct board* aboard, struct worm* aworm) {
   int i;
-  i = aworm -> headindex;
-  do {
-    placeItem(aboard, aworm -> wormpos[i].y, aworm -> wormpos[i].x, BC_FREE_CELL, SYMBOL_FREE_CELL, COLP_FREE_CELL);
-    // Advance index; go round after aworm -> cur_lastindex
-    i = (i - 1);
-  } while (i != 0);
+  for (i = 0; i < aworm -> used; i++) {
+    int index = getIndexBehindHead(aworm, i);
+    placeItem(aboard, aworm -> wormpos[index].y, aworm -> wormpos[index].x, BC_FREE_CELL, SYMBOL_FREE_CELL, COLP_FREE_CELL);
+    if (aboard -> occupancy != NULL && aworm -> id != 0) {
+      clearOccupant(aboard, aworm -> wormpos[index].y, aworm -> wormpos[index].x);
+    }
+  }
 }
 
 // END WORM_DETAIL
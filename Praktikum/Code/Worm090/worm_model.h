@@ -13,14 +13,25 @@
 #define _WORM_MODEL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "worm.h"
 #include "board_model.h"
 
-// Codes for the array of positions
-#define UNUSED_POS_ELEM -1  // Unused element in the worm arrays of positions
-
 // Dimensions and bounds
 #define WORM_INITIAL_LENGTH 4  // Initial length of the user's worm
+#define WORM_INITIAL_CAPACITY 64 // Initial size of the ring of positions (power of 2); grows with the worm
+
+// Fixed-size build: the ring is part of struct worm and holds a worm
+// that fills the whole board; its size is the next power of 2
+#ifdef BOARD_ROWS
+#define WORM_CELLS_SMEAR1 ((BOARD_ROWS * BOARD_COLS - 1) | ((BOARD_ROWS * BOARD_COLS - 1) >> 1))
+#define WORM_CELLS_SMEAR2 (WORM_CELLS_SMEAR1 | (WORM_CELLS_SMEAR1 >> 2))
+#define WORM_CELLS_SMEAR4 (WORM_CELLS_SMEAR2 | (WORM_CELLS_SMEAR2 >> 4))
+#define WORM_CELLS_SMEAR8 (WORM_CELLS_SMEAR4 | (WORM_CELLS_SMEAR4 >> 8))
+#define WORM_CELLS_SMEAR16 (WORM_CELLS_SMEAR8 | (WORM_CELLS_SMEAR8 >> 16))
+#define WORM_FIXED_CAPACITY (WORM_CELLS_SMEAR16 + 1 > WORM_INITIAL_CAPACITY \
+                             ? WORM_CELLS_SMEAR16 + 1 : WORM_INITIAL_CAPACITY)
+#endif
 
 // Boni for eating food
 enum Boni {
@@ -29,16 +40,35 @@ enum Boni {
     BONUS_3 = 6, // additional length for worm when consuming food of type 3
 };
 
+// Position of an element of the worm as stored in the ring buffer.
+// The getters convert it to struct pos (see MAX_BOARD_SIZE).
+struct worm_pos {
+    uint16_t y;
+    uint16_t x;
+};
+
 // A worm structure
 struct worm
 {
-    int cur_lastindex; // The current last index in the array of worm's element positions
-    int maxindex;      // Last usable index into the array pointed to by wormpos
-
-    int headindex;     // An index into the array for the head position of the worm
-    // 0 <= headindex <= maxindex
-
-    struct pos* wormpos; // Array of x,y positions of all elements of the worm
+    int length;        // Number of elements the worm has or is growing to
+    int maxlength;     // Length the worm may grow to
+    int used;          // Number of elements on the board; grows by one per move up to length
+    int capacity;      // Number of elements allocated for wormpos; a power of 2
+                       // (WORM_FIXED_CAPACITY in fixed-size builds)
+
+    int headindex;     // Index of the head position in wormpos
+    // The tail is used - 1 elements behind the head:
+    // tailindex = (headindex - used + 1) & (capacity - 1)
+
+#ifdef BOARD_ROWS
+    struct worm_pos wormpos[WORM_FIXED_CAPACITY]; // Ring buffer of x,y positions of all elements of the worm
+#else
+    struct worm_pos* wormpos; // Ring buffer of x,y positions of all elements of the worm
+#endif
+    struct arena* arena; // Memory of wormpos; NULL: from the heap
+
+    int id;                    // Id in the occupancy of the board; 0 if none
+    unsigned int head_ordinal; // Number of moves of the head: ordinal of the head element
 
     // The current heading of the worm
     // These are offsets from the set {-1,0,+1}
@@ -56,11 +86,11 @@ enum WormHeading {
     WORM_RIGHT
 };
 
-extern enum ResCodes initializeWorm(struct worm* aworm, int len_max, int len_cur,
+extern enum ResCodes initializeWorm(struct worm* aworm, struct arena* anarena, int len_max, int len_cur,
                                     struct pos headpos, enum WormHeading dir, enum ColorPairs color);
 
 extern void growWorm(struct worm* aworm, enum Boni growth);
-extern void showWorm(struct board* aboard, struct worm* aworm);
+extern enum ResCodes showWorm(struct board* aboard, struct worm* aworm);
 extern void cleanWormTail(struct board* aboard, struct worm* aworm);
 extern void moveWorm(struct board* aboard, struct worm* aworm, enum GameStates* agame_state);
 extern void cleanupWorm(struct worm* aworm);
@@ -68,7 +98,11 @@ extern void removeWorm(struct board* aboard, struct worm* aworm);
 
 // Getters
 extern struct pos getWormHeadPos(struct worm* aworm);
+extern struct pos getWormTailPos(struct worm* aworm);
+extern enum WormHeading getWormHeading(struct worm* aworm);
 extern int getWormLength(struct worm* aworm);
+extern int getWormMaxLength(struct worm* aworm);
+extern int getTicksUntilElementFree(struct worm* aworm, unsigned int ordinal);
 
 //Setters
 extern void setWormHeading(struct worm* aworm, enum WormHeading dir);
@@ -0,0 +1,213 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// worm-render: cost of the output with curses and with the raw VT backend
+//
+// Each level is played twice by the autopilot on a virtual terminal of
+// RENDER_LINES x RENDER_COLS cells whose output goes to a temporary file:
+// once with curses and once with the VT backend (option -v of the game).
+// Both games show the same frames, so the bytes written per frame and the
+// CPU time of showFrame() per frame can be compared directly.
+
+#include <curses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "prep.h"
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "autopilot.h"
+#include "hazards.h"
+#include "messages.h"
+#include "render.h"
+#include "vt.h"
+
+#define RENDER_LINES "30"
+#define RENDER_COLS "100"
+
+struct render_result {
+    int frames;
+    long bytes;
+    double cpu_us;   // CPU time of showFrame()
+};
+
+static void usageRender() {
+    fprintf(stderr, "Aufruf: worm-render [-h] [-t ticks] level ...\n");
+}
+
+static double getCpuMicroseconds() {
+    struct timespec t;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static long getFileSize(FILE* f) {
+    struct stat st;
+    fflush(f);
+    return fstat(fileno(f), &st) == 0 ? st.st_size : 0;
+}
+
+// Play the level like doLevel() with the autopilot for at most max_ticks ticks
+static enum ResCodes playLevel(const char* filename, bool vt_output, int max_ticks,
+                               FILE* out, struct render_result* result) {
+    struct board theboard;
+    struct worm theworm;
+    struct autopilot thepilot;
+    struct vt_screen thevt;
+    enum GameStates game_state = WORM_GAME_ONGOING;
+    enum ResCodes res_code = RES_OK;
+    struct pos bottomLeft;
+    long bytes_start;
+
+    if (initializeBoard(&theboard, NULL, getLevelFileHeight(filename),
+                        getLevelFileWidth(filename)) != RES_OK) {
+        return RES_FAILED;
+    }
+    if (initializeLevelFromFile(&theboard, filename) != RES_OK) {
+        cleanupBoard(&theboard);
+        return RES_FAILED;
+    }
+    bottomLeft.y = getLastRowOnBoard(&theboard);
+    bottomLeft.x = 0;
+    if (initializeAutopilot(&thepilot, &theboard, bottomLeft, true) != RES_OK) {
+        cleanupBoard(&theboard);
+        return RES_FAILED;
+    }
+    if (initializeWorm(&theworm, NULL, getCycleLength(&thepilot), WORM_INITIAL_LENGTH,
+                       bottomLeft, WORM_RIGHT, COLP_USER_WORM) != RES_OK) {
+        cleanupAutopilot(&thepilot);
+        cleanupBoard(&theboard);
+        return RES_FAILED;
+    }
+    updateViewport(&theboard, bottomLeft);
+    if (showWorm(&theboard, &theworm) != RES_OK) {
+        cleanupWorm(&theworm);
+        cleanupAutopilot(&thepilot);
+        cleanupBoard(&theboard);
+        return RES_FAILED;
+    }
+    refresh();
+    if (vt_output) {
+        if (initializeVtScreen(&thevt, fileno(out)) != RES_OK) {
+            cleanupWorm(&theworm);
+            cleanupAutopilot(&thepilot);
+            cleanupBoard(&theboard);
+            return RES_FAILED;
+        }
+        setVtScreen(&thevt);
+    }
+
+    bytes_start = getFileSize(out);
+    result -> frames = 0;
+    result -> cpu_us = 0;
+    while (result -> frames < max_ticks && getNumberOfFoodItems(&theboard) > 0
+           && getCycleDistanceToFood(&thepilot, &theboard, getWormHeadPos(&theworm)) >= 0) {
+        double cpu_start;
+
+        setWormHeading(&theworm, getAutopilotHeading(&thepilot, &theboard, &theworm));
+        cleanWormTail(&theboard, &theworm);
+        moveWorm(&theboard, &theworm, &game_state);
+        if (game_state != WORM_GAME_ONGOING) {
+            break;
+        }
+        updateViewport(&theboard, getWormHeadPos(&theworm));
+        if (showWorm(&theboard, &theworm) != RES_OK || updateHazards(&theboard) != RES_OK) {
+            res_code = RES_FAILED;
+            break;
+        }
+        showStatus(&theboard, &theworm);
+
+        cpu_start = getCpuMicroseconds();
+        showFrame();
+        result -> cpu_us += getCpuMicroseconds() - cpu_start;
+        result -> frames++;
+    }
+    result -> bytes = getFileSize(out) - bytes_start;
+
+    if (vt_output) {
+        setVtScreen(NULL);
+        cleanupVtScreen(&thevt);
+    }
+    cleanupWorm(&theworm);
+    cleanupAutopilot(&thepilot);
+    cleanupBoard(&theboard);
+    return res_code;
+}
+
+// Play the level on a new virtual terminal
+static enum ResCodes renderLevel(const char* filename, bool vt_output, int max_ticks,
+                                 struct render_result* result) {
+    FILE* out = tmpfile();
+    FILE* in = fopen("/dev/null", "r");
+    SCREEN* screen = NULL;
+    enum ResCodes res_code = RES_FAILED;
+
+    if (out != NULL && in != NULL) {
+        screen = newterm("xterm", out, in);
+    }
+    if (screen != NULL) {
+        initializeColors();
+        curs_set(0);
+        res_code = playLevel(filename, vt_output, max_ticks, out, result);
+        endwin();
+        delscreen(screen);
+    }
+    if (out != NULL) {
+        fclose(out);
+    }
+    if (in != NULL) {
+        fclose(in);
+    }
+    return res_code;
+}
+
+int main(int argc, char* argv[]) {
+    int max_ticks = 2000;
+    int i, c;
+
+    while ((c = getopt(argc, argv, "ht:")) != -1) {
+        switch (c) {
+            case 't': max_ticks = atoi(optarg); break;
+            default:
+                usageRender();
+                return RES_WRONG_OPTION;
+        }
+    }
+    if (optind == argc || max_ticks < 1) {
+        usageRender();
+        return RES_WRONG_OPTION;
+    }
+
+    // The size of the virtual terminal
+    setenv("LINES", RENDER_LINES, 1);
+    setenv("COLUMNS", RENDER_COLS, 1);
+
+    printf("%-28s %-7s %6s %12s %12s\n", "Level", "Ausgabe", "Bilder", "Bytes/Bild", "us/Bild");
+    for (i = optind; i < argc; i++) {
+        struct render_result results[2];
+        int k;
+
+        for (k = 0; k < 2; k++) {
+            int frames;
+
+            if (renderLevel(argv[i], k == 1, max_ticks, &results[k]) != RES_OK) {
+                fprintf(stderr, "%s: Level kann nicht gespielt werden\n", argv[i]);
+                return RES_FAILED;
+            }
+            frames = results[k].frames > 0 ? results[k].frames : 1;
+            printf("%-28s %-7s %6d %12.1f %12.2f\n", argv[i], k == 1 ? "vt" : "curses",
+                   results[k].frames, (double) results[k].bytes / frames, results[k].cpu_us / frames);
+        }
+    }
+    return RES_OK;
+}
@@ -0,0 +1,646 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// worm-solve: offline solver for the order of eating all food of a level
+//
+// The level is loaded by initializeLevelFromFile() into a headless board.
+// We search the order of food items that minimizes the number of ticks
+// until the last food item is eaten.
+//
+// Each leg from the head to the next food item is a shortest path that
+// respects the body of the worm: a body cell becomes free once the tail
+// has passed it, taking pending growth (BONUS_1/2/3) into account.
+// Other food items are not entered on the way, since that would change
+// the order. The search is a branch-and-bound over orders. Each leg takes
+// one of the shortest paths, and the body it leaves behind changes the
+// cost of later legs; other paths of the same length are not tried.
+// So the result is the best order found, not a proven optimum. As a lower
+// bound for the remaining food we use the minimal spanning tree over
+// BFS distances through the static barriers, taken from the distance
+// oracle of the level (see distance_oracle.c). The legs are searched
+// with A*, guided by the landmark lower bounds of the same oracle.
+// The first two levels of the search tree are distributed among threads.
+// Levels with hazards are rejected: the legs do not model moving barriers.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "worm.h"
+#include "board_model.h"
+#include "worm_model.h"
+#include "distance_oracle.h"
+#include "hazards.h"
+#include "sim.h"
+
+#define MAX_FOOD 64       // Maximal number of food items of a level
+#define MAX_THREADS 64    // Maximal number of search threads
+#define UNREACHABLE INT_MAX
+
+// A food item of the level
+struct food {
+    struct pos position;
+    enum Boni bonus;
+};
+
+// The problem to solve for a level
+struct level_problem {
+    struct board theboard;
+    int nrows;
+    int ncols;
+    int start;                 // Cell index of the start position of the worm
+    int nfood;
+    struct food foods[MAX_FOOD];
+    int* food_index;           // Per cell: index into foods or -1
+    int dist[MAX_FOOD + 1][MAX_FOOD + 1]; // Static distances; index nfood is the start
+    int max_len;               // Upper bound for the length of the worm
+    struct distance_oracle oracle; // Static distances of the level
+
+    // Shared state of the search
+    atomic_int best_ticks;
+    atomic_long nodes;
+    atomic_int next_task;
+    long node_limit;           // 0: no limit
+    pthread_mutex_t best_lock;
+    int best_order[MAX_FOOD];
+};
+
+// Scratch memory of one search thread
+struct search_thread {
+    struct level_problem* problem;
+    pthread_t thread;
+
+    int* visited;              // Stamp per cell: reached in search number stamp
+    int* closed;               // Stamp per cell: shortest path known in search number stamp
+    int* ticks;                // Ticks to reach a cell; valid if visited
+    int* body_stamp;           // Stamp per cell: cell is part of the body
+    int* body_free_at;         // Tick at which a body cell may be entered
+    int* parent;
+    int* queue;                // Open cells with the current bound of the A* search
+    int* queue_next;           // Open cells with the next bound
+    int stamp;
+
+    int* bodies[MAX_FOOD + 1]; // Body (tail first) on each level of the search
+    int order[MAX_FOOD];
+};
+
+// Load the level and get the static distances from the distance oracle
+static enum ResCodes initializeProblem(struct level_problem* problem, const char* filename,
+                                       int nrows, int ncols) {
+    int y, x, i, j;
+    int ncells;
+
+    // The oracle stays with the problem: the legs use its lower bounds
+    if (loadHeadlessLevelWithOracle(&problem -> theboard, &problem -> oracle,
+                                    filename, nrows, ncols) != RES_OK) {
+        return RES_FAILED;
+    }
+    if (problem -> theboard.hazards != NULL && problem -> theboard.hazards -> count > 0) {
+        fprintf(stderr, "%s: Level mit beweglichen Hindernissen wird nicht geloest\n", filename);
+        cleanupDistanceOracle(&problem -> oracle);
+        cleanupBoard(&problem -> theboard);
+        return RES_FAILED;
+    }
+    problem -> nrows = nrows;
+    problem -> ncols = ncols;
+    ncells = nrows * ncols;
+    problem -> start = (nrows - 1) * ncols;  // The worm starts at (last_row, 0)
+    problem -> nfood = 0;
+    problem -> food_index = malloc(ncells * sizeof(int));
+    if (problem -> food_index == NULL) {
+        fprintf(stderr, "Kein Speicher mehr\n");
+        return RES_FAILED;
+    }
+
+    // Collect food in reading order
+    for (y = 0; y < nrows; y++) {
+        for (x = 0; x < ncols; x++) {
+            enum BoardCodes code = getCellAt(&problem -> theboard, y, x);
+            problem -> food_index[y * ncols + x] = -1;
+            if (code != BC_FOOD_1 && code != BC_FOOD_2 && code != BC_FOOD_3) {
+                continue;
+            }
+            if (problem -> nfood == MAX_FOOD) {
+                fprintf(stderr, "%s: mehr als %d Futterbrocken\n", filename, MAX_FOOD);
+                return RES_FAILED;
+            }
+            problem -> foods[problem -> nfood].position.y = y;
+            problem -> foods[problem -> nfood].position.x = x;
+            problem -> foods[problem -> nfood].bonus =
+                code == BC_FOOD_1 ? BONUS_1 : (code == BC_FOOD_2 ? BONUS_2 : BONUS_3);
+            problem -> food_index[y * ncols + x] = problem -> nfood;
+            problem -> nfood++;
+        }
+    }
+
+    // Static distances between all food items and from the start.
+    // The points of the oracle are the food items in reading order and the start.
+    for (i = 0; i <= problem -> nfood; i++) {
+        for (j = 0; j <= problem -> nfood; j++) {
+            int d = getPointDistance(&problem -> oracle, i, j);
+            problem -> dist[i][j] = d < 0 ? UNREACHABLE : d;
+        }
+    }
+
+    problem -> max_len = WORM_INITIAL_LENGTH + problem -> nfood * BONUS_3 + 1;
+    return RES_OK;
+}
+
+static void cleanupProblem(struct level_problem* problem) {
+    free(problem -> food_index);
+    cleanupDistanceOracle(&problem -> oracle);
+    cleanupBoard(&problem -> theboard);
+}
+
+// Lower bound for eating all food not in eaten, starting at food item from
+// (or the start if from == nfood): weight of the minimal spanning tree
+static int getLowerBound(struct level_problem* problem, int from, unsigned long long eaten) {
+    int nodes[MAX_FOOD + 1];
+    int key[MAX_FOOD + 1];
+    int n = 0;
+    int i, j;
+    int total = 0;
+
+    nodes[n++] = from;
+    for (i = 0; i < problem -> nfood; i++) {
+        if (!(eaten >> i & 1) && i != from) {
+            nodes[n++] = i;
+        }
+    }
+    // Prim's algorithm on the complete graph
+    for (i = 1; i < n; i++) {
+        key[i] = problem -> dist[from][nodes[i]];
+    }
+    for (i = 1; i < n; i++) {
+        int best = -1;
+        for (j = 1; j < n; j++) {
+            if (key[j] >= 0 && (best < 0 || key[j] < key[best])) {
+                best = j;
+            }
+        }
+        if (key[best] == UNREACHABLE) {
+            return UNREACHABLE;
+        }
+        total += key[best];
+        key[best] = -1;
+        for (j = 1; j < n; j++) {
+            if (key[j] >= 0 && problem -> dist[nodes[best]][nodes[j]] < key[j]) {
+                key[j] = problem -> dist[nodes[best]][nodes[j]];
+            }
+        }
+    }
+    return total;
+}
+
+// Lower bound for the ticks from cell to food item target; -1 if unreachable
+static int getLegLowerBound(struct level_problem* problem, int cell, int target) {
+    struct pos from = { cell / problem -> ncols, cell % problem -> ncols };
+    return getDistanceLowerBound(&problem -> oracle, from, problem -> foods[target].position);
+}
+
+// Shortest path from the head of body to food item target.
+// body holds *blen cell indices (tail first); the worm wants to have length len.
+//
+// A* search with the landmark lower bounds of the oracle. Each step changes
+// the bound of a cell by exactly one (the grid is bipartite), so the sum of
+// ticks and bound grows in steps of 2: open cells are kept in two stacks,
+// one for the current sum and one for the next. Cells are entered at the
+// earliest tick, as body cells only become free over time.
+// On success the body after the leg is stored in new_body and the number of
+// ticks is returned. Returns -1 if the food item cannot be reached.
+static int computeLeg(struct search_thread* st, const int* body, int blen, int len,
+                      int target, unsigned long long eaten, int* new_body, int* new_blen) {
+    struct level_problem* problem = st -> problem;
+    int ncols = problem -> ncols;
+    int pending = len - blen;   // Ticks until the tail starts to move
+    int target_cell = problem -> foods[target].position.y * ncols + problem -> foods[target].position.x;
+    int* open = st -> queue;
+    int* open_next = st -> queue_next;
+    int nopen = 0;
+    int nnext = 0;
+    int bound;
+    int ticks = 0;
+    int found = 0;
+    int drop, skip, nb, i, c;
+
+    st -> stamp++;
+    for (i = 0; i < blen; i++) {
+        st -> body_stamp[body[i]] = st -> stamp;
+        st -> body_free_at[body[i]] = i + pending + 1;
+    }
+
+    bound = getLegLowerBound(problem, body[blen - 1], target);
+    if (bound < 0) {
+        return -1;
+    }
+    st -> visited[body[blen - 1]] = st -> stamp;
+    st -> ticks[body[blen - 1]] = 0;
+    open[nopen++] = body[blen - 1];
+    while (nopen > 0 || nnext > 0) {
+        int cur, y, x, k;
+        int* swap;
+
+        if (nopen == 0) {
+            swap = open;
+            open = open_next;
+            open_next = swap;
+            nopen = nnext;
+            nnext = 0;
+            bound += 2;
+            continue;
+        }
+        cur = open[--nopen];
+        if (st -> closed[cur] == st -> stamp) {
+            continue;  // Reached again on a shorter path before
+        }
+        st -> closed[cur] = st -> stamp;
+        if (cur == target_cell) {
+            found = 1;
+            break;
+        }
+        ticks = st -> ticks[cur] + 1;
+        y = cur / ncols;
+        x = cur % ncols;
+        int ny[4] = { y - 1, y + 1, y, y };
+        int nx[4] = { x, x, x - 1, x + 1 };
+
+        for (k = 0; k < 4; k++) {
+            int n, fi, h;
+            if (ny[k] < 0 || ny[k] >= problem -> nrows || nx[k] < 0 || nx[k] >= ncols) {
+                continue;
+            }
+            n = ny[k] * ncols + nx[k];
+            if (st -> closed[n] == st -> stamp
+                || (st -> visited[n] == st -> stamp && st -> ticks[n] <= ticks)
+                || getCellAt(&problem -> theboard, ny[k], nx[k]) == BC_BARRIER) {
+                continue;
+            }
+            // Cells of the body are blocked until the tail has passed
+            if (st -> body_stamp[n] == st -> stamp && st -> body_free_at[n] > ticks) {
+                continue;
+            }
+            // Do not eat other food on the way
+            fi = problem -> food_index[n];
+            if (fi >= 0 && fi != target && !(eaten >> fi & 1)) {
+                continue;
+            }
+            if ((h = getLegLowerBound(problem, n, target)) < 0) {
+                continue;
+            }
+            st -> visited[n] = st -> stamp;
+            st -> ticks[n] = ticks;
+            st -> parent[n] = cur;
+            if (ticks + h <= bound) {
+                open[nopen++] = n;
+            } else {
+                open_next[nnext++] = n;
+            }
+        }
+    }
+    if (!found) {
+        return -1;
+    }
+    ticks = st -> ticks[target_cell];
+
+    // New body: old body followed by the path, without the first drop cells
+    drop = ticks > pending ? ticks - pending : 0;
+    skip = drop > blen ? drop - blen : 0;   // Cells of the path already left again
+    nb = 0;
+    for (i = drop; i < blen; i++) {
+        new_body[nb++] = body[i];
+    }
+    // The path is reconstructed backwards from the target
+    c = target_cell;
+    for (i = ticks - 1; i >= skip; i--) {
+        new_body[nb + i - skip] = c;
+        c = st -> parent[c];
+    }
+    *new_blen = nb + ticks - skip;
+    return ticks;
+}
+
+// Try to improve the best solution found so far
+static void updateBest(struct search_thread* st, int ticks) {
+    struct level_problem* problem = st -> problem;
+    pthread_mutex_lock(&problem -> best_lock);
+    if (ticks < atomic_load(&problem -> best_ticks)) {
+        atomic_store(&problem -> best_ticks, ticks);
+        memcpy(problem -> best_order, st -> order, problem -> nfood * sizeof(int));
+    }
+    pthread_mutex_unlock(&problem -> best_lock);
+}
+
+// Depth first branch-and-bound
+static void search(struct search_thread* st, int depth, int from, int ticks,
+                   unsigned long long eaten, int blen, int len) {
+    struct level_problem* problem = st -> problem;
+    int cand[MAX_FOOD];
+    int ncand = 0;
+    int i, j;
+
+    if (depth == problem -> nfood) {
+        updateBest(st, ticks);
+        return;
+    }
+    if (problem -> node_limit > 0 && atomic_fetch_add(&problem -> nodes, 1) >= problem -> node_limit) {
+        return;
+    }
+    if (ticks + getLowerBound(problem, from, eaten) >= atomic_load(&problem -> best_ticks)) {
+        return;
+    }
+
+    // Visit the nearest food items first
+    for (i = 0; i < problem -> nfood; i++) {
+        if (eaten >> i & 1) {
+            continue;
+        }
+        for (j = ncand; j > 0 && problem -> dist[from][cand[j - 1]] > problem -> dist[from][i]; j--) {
+            cand[j] = cand[j - 1];
+        }
+        cand[j] = i;
+        ncand++;
+    }
+
+    for (i = 0; i < ncand; i++) {
+        int f = cand[i];
+        int new_blen;
+        int leg;
+        unsigned long long new_eaten = eaten | (1ULL << f);
+
+        if (ticks + problem -> dist[from][f] >= atomic_load(&problem -> best_ticks)) {
+            continue;
+        }
+        leg = computeLeg(st, st -> bodies[depth], blen, len, f, eaten,
+                         st -> bodies[depth + 1], &new_blen);
+        if (leg < 0 || ticks + leg + getLowerBound(problem, f, new_eaten) >= atomic_load(&problem -> best_ticks)) {
+            continue;
+        }
+        st -> order[depth] = f;
+        search(st, depth + 1, f, ticks + leg, new_eaten, new_blen, len + problem -> foods[f].bonus);
+    }
+}
+
+// Greedy dive: always eat the food item with the shortest leg.
+// Gives a first upper bound for the branch-and-bound.
+static void searchGreedy(struct search_thread* st) {
+    struct level_problem* problem = st -> problem;
+    unsigned long long eaten = 0;
+    int blen = 1;
+    int len = WORM_INITIAL_LENGTH;
+    int ticks = 0;
+    int depth;
+
+    for (depth = 0; depth < problem -> nfood; depth++) {
+        int best = -1;
+        int best_leg = UNREACHABLE;
+        int best_blen = 0;
+        int f;
+        for (f = 0; f < problem -> nfood; f++) {
+            int new_blen, leg;
+            if (eaten >> f & 1) {
+                continue;
+            }
+            leg = computeLeg(st, st -> bodies[depth], blen, len, f, eaten,
+                             st -> bodies[depth + 1], &new_blen);
+            if (leg >= 0 && leg < best_leg) {
+                best = f;
+                best_leg = leg;
+            }
+        }
+        if (best < 0) {
+            return; // Greedy got stuck
+        }
+        computeLeg(st, st -> bodies[depth], blen, len, best, eaten,
+                   st -> bodies[depth + 1], &best_blen);
+        st -> order[depth] = best;
+        eaten |= 1ULL << best;
+        blen = best_blen;
+        len += problem -> foods[best].bonus;
+        ticks += best_leg;
+    }
+    updateBest(st, ticks);
+}
+
+// Work on tasks (first food item, second food item) until none is left
+static void* runSearchThread(void* arg) {
+    struct search_thread* st = arg;
+    struct level_problem* problem = st -> problem;
+    int n = problem -> nfood;
+    int ntasks = n > 1 ? n * (n - 1) : n;
+    int task;
+
+    while ((task = atomic_fetch_add(&problem -> next_task, 1)) < ntasks) {
+        int first = n > 1 ? task / (n - 1) : 0;
+        int second = n > 1 ? task % (n - 1) : -1;
+        int blen1, blen2, leg1, leg2;
+        int len1;
+        unsigned long long eaten1 = 1ULL << first;
+
+        if (second >= first) {
+            second++;
+        }
+        leg1 = computeLeg(st, st -> bodies[0], 1, WORM_INITIAL_LENGTH, first, 0,
+                          st -> bodies[1], &blen1);
+        if (leg1 < 0) {
+            continue;
+        }
+        st -> order[0] = first;
+        len1 = WORM_INITIAL_LENGTH + problem -> foods[first].bonus;
+        if (n == 1) {
+            updateBest(st, leg1);
+            continue;
+        }
+        leg2 = computeLeg(st, st -> bodies[1], blen1, len1, second, eaten1,
+                          st -> bodies[2], &blen2);
+        if (leg2 < 0) {
+            continue;
+        }
+        st -> order[1] = second;
+        search(st, 2, second, leg1 + leg2, eaten1 | (1ULL << second), blen2,
+               len1 + problem -> foods[second].bonus);
+    }
+    return NULL;
+}
+
+static enum ResCodes initializeSearchThread(struct search_thread* st, struct level_problem* problem) {
+    int ncells = problem -> nrows * problem -> ncols;
+    int i;
+
+    st -> problem = problem;
+    st -> stamp = 0;
+    st -> visited = calloc(ncells, sizeof(int));
+    st -> closed = calloc(ncells, sizeof(int));
+    st -> ticks = malloc(ncells * sizeof(int));
+    st -> body_stamp = calloc(ncells, sizeof(int));
+    st -> body_free_at = malloc(ncells * sizeof(int));
+    st -> parent = malloc(ncells * sizeof(int));
+    st -> queue = malloc(ncells * sizeof(int));
+    st -> queue_next = malloc(ncells * sizeof(int));
+    if (st -> visited == NULL || st -> closed == NULL || st -> ticks == NULL
+        || st -> body_stamp == NULL || st -> body_free_at == NULL
+        || st -> parent == NULL || st -> queue == NULL || st -> queue_next == NULL) {
+        return RES_FAILED;
+    }
+    for (i = 0; i <= problem -> nfood; i++) {
+        // A body never gets longer than the worm plus one leg
+        st -> bodies[i] = malloc((problem -> max_len + ncells) * sizeof(int));
+        if (st -> bodies[i] == NULL) {
+            return RES_FAILED;
+        }
+    }
+    st -> bodies[0][0] = problem -> start;
+    return RES_OK;
+}
+
+static void cleanupSearchThread(struct search_thread* st) {
+    int i;
+    free(st -> visited);
+    free(st -> closed);
+    free(st -> ticks);
+    free(st -> body_stamp);
+    free(st -> body_free_at);
+    free(st -> parent);
+    free(st -> queue);
+    free(st -> queue_next);
+    for (i = 0; i <= st -> problem -> nfood; i++) {
+        free(st -> bodies[i]);
+    }
+}
+
+// Solve one level and print the result
+static enum ResCodes solveLevel(const char* filename, int nrows, int ncols,
+                                int nthreads, long node_limit) {
+    struct level_problem* problem;
+    struct search_thread threads[MAX_THREADS];
+    struct timespec t_start, t_end;
+    enum ResCodes res_code = RES_OK;
+    int i;
+    int best;
+
+    if (nrows <= 0) {
+        nrows = getLevelFileHeight(filename);
+    }
+    if (ncols <= 0) {
+        ncols = getLevelFileWidth(filename);
+    }
+
+    problem = calloc(1, sizeof(struct level_problem));
+    if (problem == NULL) {
+        fprintf(stderr, "Kein Speicher mehr\n");
+        return RES_FAILED;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    if (initializeProblem(problem, filename, nrows, ncols) != RES_OK) {
+        free(problem);
+        return RES_FAILED;
+    }
+    atomic_init(&problem -> best_ticks, UNREACHABLE);
+    atomic_init(&problem -> nodes, 0);
+    atomic_init(&problem -> next_task, 0);
+    problem -> node_limit = node_limit;
+    pthread_mutex_init(&problem -> best_lock, NULL);
+
+    for (i = 0; i < nthreads; i++) {
+        if (initializeSearchThread(&threads[i], problem) != RES_OK) {
+            fprintf(stderr, "Kein Speicher mehr\n");
+            exit(RES_FAILED);
+        }
+    }
+
+    if (problem -> nfood > 0 && getLowerBound(problem, problem -> nfood, 0) != UNREACHABLE) {
+        searchGreedy(&threads[0]);
+        for (i = 0; i < nthreads; i++) {
+            pthread_create(&threads[i].thread, NULL, runSearchThread, &threads[i]);
+        }
+        for (i = 0; i < nthreads; i++) {
+            pthread_join(threads[i].thread, NULL);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+    best = atomic_load(&problem -> best_ticks);
+    printf("%s: %dx%d, %d Futterbrocken, ", filename, nrows, ncols, problem -> nfood);
+    if (problem -> nfood == 0) {
+        printf("nichts zu tun");
+    } else if (best == UNREACHABLE) {
+        printf("keine Loesung gefunden");
+        res_code = RES_FAILED;
+    } else {
+        printf("%d Ticks (%s), Reihenfolge (y,x):", best,
+               node_limit > 0 && atomic_load(&problem -> nodes) >= node_limit
+               ? "beste gefundene Loesung, Knotenlimit erreicht" : "beste gefundene Loesung");
+        for (i = 0; i < problem -> nfood; i++) {
+            struct pos p = problem -> foods[problem -> best_order[i]].position;
+            printf(" (%d,%d)", p.y, p.x);
+        }
+    }
+    printf(", %.3f s\n", (t_end.tv_sec - t_start.tv_sec) + (t_end.tv_nsec - t_start.tv_nsec) / 1e9);
+
+    for (i = 0; i < nthreads; i++) {
+        cleanupSearchThread(&threads[i]);
+    }
+    pthread_mutex_destroy(&problem -> best_lock);
+    cleanupProblem(problem);
+    free(problem);
+    return res_code;
+}
+
+static void usageSolve() {
+    fprintf(stderr, "Aufruf: worm-solve [-h] [-t threads] [-r zeilen] [-c spalten] [-l knoten] Dateiname...\n");
+}
+
+int main(int argc, char* argv[]) {
+    enum ResCodes res_code = RES_OK;
+    int nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    int nrows = 0;      // 0: lines of the level file
+    int ncols = 0;      // 0: longest line of the level file
+    long node_limit = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "ht:r:c:l:")) != -1) {
+        switch (c) {
+            case 't':
+                nthreads = atoi(optarg);
+                break;
+            case 'r':
+                nrows = atoi(optarg);
+                break;
+            case 'c':
+                ncols = atoi(optarg);
+                break;
+            case 'l':
+                node_limit = atol(optarg);
+                break;
+            default:
+                usageSolve();
+                return RES_WRONG_OPTION;
+        }
+    }
+    if (optind >= argc || nrows < 0) {
+        usageSolve();
+        return RES_WRONG_OPTION;
+    }
+    if (nthreads < 1) {
+        nthreads = 1;
+    } else if (nthreads > MAX_THREADS) {
+        nthreads = MAX_THREADS;
+    }
+
+    for (; optind < argc; optind++) {
+        if (solveLevel(argv[optind], nrows, ncols, nthreads, node_limit) != RES_OK) {
+            res_code = RES_FAILED;
+        }
+    }
+    return res_code;
+}
@@ -0,0 +1,434 @@
+// A simple variant of the game Snake
+//
+// Used for teaching in classes
+//
+// Author:
+// Franz Regensburger
+// Ingolstadt University of Applied Sciences
+// (C) 2011
+//
+// worm-validate: check level files before they are played
+//
+// Arguments are level files or directories; directories are searched
+// recursively for files whose name ends in ".level.<number>", so the
+// distance caches of worm-solve (".level.<number>.oracle") are left out. All files are
+// checked in parallel threads. For each file the tool reports
+// - errors: unknown symbols, a barrier on the start cell (last_row, 0),
+//   food that cannot be reached from the start cell
+// - warnings: DOS line ends, levels without food
+// The board has the size of the level file, at least MIN_NUMBER_OF_ROWS x
+// MIN_NUMBER_OF_COLS, as in the game. Options -r and -c check the level on a
+// board of the given size instead, as the simulation tools use with -r;
+// lines and rows beyond that size are reported as warnings.
+// Messages have the form "file:line:column: Fehler|Warnung: text" and are
+// printed in the order of the arguments.
+//
+// Exit codes (worst over all files):
+//   0 all files are fine        1 warnings only
+//   2 errors                    3 a file could not be read
+//   4 wrong options
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "worm.h"
+#include "board_model.h"
+#include "bitboard.h"
+#include "sim.h"
+
+// Exit codes, ordered by severity
+enum ValidationCodes {
+    VAL_OK,
+    VAL_WARNINGS,
+    VAL_ERRORS,
+    VAL_UNREADABLE,
+    VAL_WRONG_OPTION,
+};
+
+// A level file and the result of its check
+struct level_check {
+    char* filename;
+    enum ValidationCodes code;
+    char* report;        // Messages for this file
+    size_t report_size;
+};
+
+// Shared state of the threads
+struct validator {
+    int nrows;           // Rows of the board; 0: size of the level file
+    int ncols;           // Guaranteed number of columns; 0: size of the level file
+    struct level_check* checks;
+    int nchecks;
+    int capacity;
+    atomic_int next_check;
+};
+
+// Collect files
+// ********************************************************************************************
+
+static enum ResCodes addFile(struct validator* val, const char* filename) {
+    if (val -> nchecks == val -> capacity) {
+        int capacity = val -> capacity > 0 ? 2 * val -> capacity : 256;
+        struct level_check* checks = realloc(val -> checks, capacity * sizeof(struct level_check));
+        if (checks == NULL) {
+            return RES_FAILED;
+        }
+        val -> checks = checks;
+        val -> capacity = capacity;
+    }
+    memset(&val -> checks[val -> nchecks], 0, sizeof(struct level_check));
+    if ((val -> checks[val -> nchecks].filename = strdup(filename)) == NULL) {
+        return RES_FAILED;
+    }
+    val -> nchecks++;
+    return RES_OK;
+}
+
+static int compareStrings(const void* a, const void* b) {
+    return strcmp(*(char* const*) a, *(char* const*) b);
+}
+
+// Level files are named <name>.level.<number>
+static bool isLevelFilename(const char* base) {
+    const char* suffix = strstr(base, ".level.");
+    const char* p;
+
+    while (suffix != NULL) {
+        p = suffix + strlen(".level.");
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        if (*p == '\0' && p > suffix + strlen(".level.")) {
+            return true;
+        }
+        suffix = strstr(suffix + 1, ".level.");
+    }
+    return false;
+}
+
+// Add all level files below a directory, sorted by name
+static enum ResCodes addDirectory(struct validator* val, const char* dirname) {
+    DIR* dir;
+    struct dirent* entry;
+    char** names = NULL;
+    int nnames = 0;
+    int capacity = 0;
+    enum ResCodes res = RES_OK;
+    int i;
+
+    if ((dir = opendir(dirname)) == NULL) {
+        return addFile(val, dirname);  // Reported as unreadable later
+    }
+    while ((entry = readdir(dir)) != NULL && res == RES_OK) {
+        size_t len = strlen(dirname) + strlen(entry -> d_name) + 2;
+        if (entry -> d_name[0] == '.') {
+            continue;
+        }
+        if (nnames == capacity) {
+            char** tmp;
+            capacity = capacity > 0 ? 2 * capacity : 64;
+            if ((tmp = realloc(names, capacity * sizeof(char*))) == NULL) {
+                res = RES_FAILED;
+                break;
+            }
+            names = tmp;
+        }
+        if ((names[nnames] = malloc(len)) == NULL) {
+            res = RES_FAILED;
+            break;
+        }
+        snprintf(names[nnames++], len, "%s/%s", dirname, entry -> d_name);
+    }
+    closedir(dir);
+
+    qsort(names, nnames, sizeof(char*), compareStrings);
+    for (i = 0; i < nnames; i++) {
+        struct stat st;
+        const char* base = strrchr(names[i], '/') + 1;
+        if (res == RES_OK && stat(names[i], &st) == 0) {
+            if (S_ISDIR(st.st_mode)) {
+                res = addDirectory(val, names[i]);
+            } else if (S_ISREG(st.st_mode) && isLevelFilename(base)) {
+                res = addFile(val, names[i]);
+            }
+        }
+        free(names[i]);
+    }
+    free(names);
+    return res;
+}
+
+// Check a level
+// ********************************************************************************************
+
+static void report(struct level_check* check, FILE* out, enum ValidationCodes code,
+                   int line, int col, const char* message) {
+    fprintf(out, "%s:%d:%d: %s: %s\n", check -> filename, line, col,
+            code == VAL_ERRORS ? "Fehler" : "Warnung", message);
+    if (code > check -> code) {
+        check -> code = code;
+    }
+}
+
+// Read a whole file into a '\0' terminated buffer
+static char* readFile(const char* filename, size_t* size) {
+    FILE* in;
+    char* data = NULL;
+    size_t capacity = 0;
+
+    if ((in = fopen(filename, "rb")) == NULL) {
+        return NULL;
+    }
+    *size = 0;
+    do {
+        char* tmp;
+        capacity = capacity > 0 ? 2 * capacity : 4096;
+        if ((tmp = realloc(data, capacity + 1)) == NULL) {
+            free(data);
+            fclose(in);
+            return NULL;
+        }
+        data = tmp;
+        *size += fread(data + *size, 1, capacity - *size, in);
+    } while (*size == capacity);
+    data[*size] = '\0';
+    if (ferror(in)) {
+        free(data);
+        data = NULL;
+    }
+    fclose(in);
+    return data;
+}
+
+static void checkLevel(struct validator* val, struct level_check* check) {
+    struct board level;
+    struct pos start;
+    char message[100];
+    size_t size;
+    char* data;
+    char* line;
+    FILE* out;
+    int nlines = 0;
+    int width = 0;
+    int long_lines = 0;
+    int first_long_line = 0;
+    int nrows, ncols;
+    uint64_t* passable;
+    uint64_t* region;
+    enum ResCodes res_code = RES_OK;
+    size_t i;
+    int y, x;
+
+    if ((out = open_memstream(&check -> report, &check -> report_size)) == NULL) {
+        check -> code = VAL_UNREADABLE;
+        return;
+    }
+    if ((data = readFile(check -> filename, &size)) == NULL) {
+        report(check, out, VAL_ERRORS, 0, 0, "Datei kann nicht gelesen werden");
+        check -> code = VAL_UNREADABLE;
+        fclose(out);
+        return;
+    }
+
+    // Symbols and dimensions, as read by initializeLevelFromFile()
+    for (line = data; *line != '\0'; nlines++) {
+        char* end = strchr(line, '\n');
+        int len = end != NULL ? end - line : strlen(line);
+
+        if (len > 0 && line[len - 1] == '\r') {
+            report(check, out, VAL_WARNINGS, nlines + 1, len, "DOS-Zeilenende");
+            len--;
+        }
+        for (x = 0; x < len; x++) {
+            char c = line[x];
+            if (c != SYMBOL_FREE_CELL && c != SYMBOL_BARRIER && c != SYMBOL_FOOD_1
+                && c != SYMBOL_FOOD_2 && c != SYMBOL_FOOD_3 && c != SYMBOL_PATROL_H
+                && c != SYMBOL_PATROL_V && c != SYMBOL_BOUNCER) {
+                snprintf(message, sizeof(message), "Unbekanntes Symbol '%c' (0x%02x)",
+                         c >= ' ' && c <= '~' ? c : '?', (unsigned char) c);
+                report(check, out, VAL_ERRORS, nlines + 1, x + 1, message);
+            }
+        }
+        if (val -> ncols > 0 && len > val -> ncols && long_lines++ == 0) {
+            first_long_line = nlines + 1;
+        }
+        if (len > width) {
+            width = len;
+        }
+        line = end != NULL ? end + 1 : line + len;
+    }
+    if (long_lines > 0) {
+        snprintf(message, sizeof(message),
+                 "%d Zeilen mit bis zu %d Zeichen werden bei %d Spalten abgeschnitten",
+                 long_lines, width, val -> ncols);
+        report(check, out, VAL_WARNINGS, first_long_line, val -> ncols + 1, message);
+    }
+    if (val -> nrows > 0 && nlines > val -> nrows) {
+        snprintf(message, sizeof(message),
+                 "%d Zeilen, nur die ersten %d werden gelesen", nlines, val -> nrows);
+        report(check, out, VAL_WARNINGS, val -> nrows + 1, 1, message);
+    }
+
+    // Reachability on a board of the size of the level, as getLevelFileHeight()
+    // and getLevelFileWidth() give it to the game, and wide enough for all lines
+    nrows = val -> nrows > 0 ? val -> nrows : (nlines > MIN_NUMBER_OF_ROWS ? nlines : MIN_NUMBER_OF_ROWS);
+    ncols = val -> ncols > 0 ? val -> ncols : MIN_NUMBER_OF_COLS;
+    if (initializeHeadlessBoard(&level, nrows, width > ncols ? width : ncols) != RES_OK) {
+        report(check, out, VAL_ERRORS, 0, 0, "Kein Speicher mehr");
+        free(data);
+        fclose(out);
+        return;
+    }
+    level.food_items = 0;
+    for (line = data, y = 0; *line != '\0' && y <= level.last_row && res_code == RES_OK; y++) {
+        for (x = 0; line[x] != '\0' && line[x] != '\n' && res_code == RES_OK; x++) {
+            switch (line[x]) {
+                case SYMBOL_BARRIER:
+                    res_code = placeItem(&level, y, x, BC_BARRIER, SYMBOL_BARRIER, COLP_BARRIER);
+                    break;
+                case SYMBOL_FOOD_1:
+                case SYMBOL_FOOD_2:
+                case SYMBOL_FOOD_3:
+                    res_code = placeItem(&level, y, x, BC_FOOD_1, line[x], COLP_FOOD_1);
+                    level.food_items++;
+                    break;
+                // Moving hazards do not block a cell for good: they count as free
+            }
+        }
+        line += x + (line[x] == '\n');
+    }
+    free(data);
+    if (res_code != RES_OK) {
+        report(check, out, VAL_ERRORS, 0, 0, "Kein Speicher mehr");
+        cleanupBoard(&level);
+        fclose(out);
+        return;
+    }
+
+    start.y = level.last_row;
+    start.x = 0;
+    if (level.food_items == 0) {
+        report(check, out, VAL_WARNINGS, 0, 0, "Level ohne Futter");
+    }
+    if (getContentAt(&level, start) == BC_BARRIER) {
+        report(check, out, VAL_ERRORS, start.y + 1, start.x + 1, "Startfeld ist blockiert");
+    } else if (hasBitboard(&level)) {
+        // Reachability needs the bitboard; huge levels are checked line by line only
+        size = (level.last_row + 1) * level.words_per_row;
+        passable = malloc(2 * size * sizeof(uint64_t));
+        if (passable == NULL) {
+            report(check, out, VAL_ERRORS, 0, 0, "Kein Speicher mehr");
+        } else {
+            region = passable + size;
+            getPassableCells(&level, passable);
+            floodFill(&level, passable, start, region);
+            // Food bits outside of the region, one word at a time
+            for (i = 0; i < size; i++) {
+                uint64_t unreachable = level.bits[BC_FOOD_1][i] & ~region[i];
+                while (unreachable != 0) {
+                    y = i / level.words_per_row;
+                    x = (i % level.words_per_row) * BITS_PER_WORD + __builtin_ctzll(unreachable);
+                    report(check, out, VAL_ERRORS, y + 1, x + 1,
+                           "Futter ist vom Startfeld aus nicht erreichbar");
+                    unreachable &= unreachable - 1;
+                }
+            }
+            free(passable);
+        }
+    }
+    cleanupBoard(&level);
+    fclose(out);
+}
+
+static void* runValidationThread(void* arg) {
+    struct validator* val = arg;
+    int i;
+
+    while ((i = atomic_fetch_add(&val -> next_check, 1)) < val -> nchecks) {
+        checkLevel(val, &val -> checks[i]);
+    }
+    return NULL;
+}
+
+// Main
+// ********************************************************************************************
+
+static void usageValidate() {
+    fprintf(stderr, "Aufruf: worm-validate [-h] [-q] [-r zeilen] [-c spalten] [-t threads]"
+            " Datei|Verzeichnis...\n");
+}
+
+int main(int argc, char* argv[]) {
+    struct validator val;
+    pthread_t threads[SIM_MAX_THREADS];
+    enum ValidationCodes res = VAL_OK;
+    int counts[VAL_WRONG_OPTION] = { 0 };
+    int nthreads = getDefaultThreadCount();
+    bool quiet = false;
+    int started = 0;
+    int i, c;
+
+    memset(&val, 0, sizeof(val));
+    while ((c = getopt(argc, argv, "hqr:c:t:")) != -1) {
+        switch (c) {
+            case 'q': quiet = true; break;
+            case 'r': val.nrows = atoi(optarg); break;
+            case 'c': val.ncols = atoi(optarg); break;
+            case 't': nthreads = atoi(optarg); break;
+            default:
+                usageValidate();
+                return VAL_WRONG_OPTION;
+        }
+    }
+    if (optind == argc || val.nrows < 0 || val.ncols < 0) {
+        usageValidate();
+        return VAL_WRONG_OPTION;
+    }
+
+    for (i = optind; i < argc; i++) {
+        struct stat st;
+        if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode) ? addDirectory(&val, argv[i]) != RES_OK
+                                                           : addFile(&val, argv[i]) != RES_OK) {
+            fprintf(stderr, "Kein Speicher mehr\n");
+            return VAL_UNREADABLE;
+        }
+    }
+
+    if (nthreads > SIM_MAX_THREADS) {
+        nthreads = SIM_MAX_THREADS;
+    }
+    atomic_init(&val.next_check, 0);
+    for (i = 1; i < nthreads && i < val.nchecks; i++) {
+        if (pthread_create(&threads[started], NULL, runValidationThread, &val) == 0) {
+            started++;
+        }
+    }
+    runValidationThread(&val);
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (i = 0; i < val.nchecks; i++) {
+        struct level_check* check = &val.checks[i];
+        if (!quiet && check -> report != NULL) {
+            fputs(check -> report, stdout);
+        }
+        counts[check -> code]++;
+        if (check -> code > res) {
+            res = check -> code;
+        }
+        free(check -> report);
+        free(check -> filename);
+    }
+    free(val.checks);
+    fflush(stdout);
+    fprintf(stderr, "%d Dateien: %d fehlerfrei, %d mit Warnungen, %d mit Fehlern, %d nicht lesbar\n",
+            val.nchecks, counts[VAL_OK], counts[VAL_WARNINGS], counts[VAL_ERRORS], counts[VAL_UNREADABLE]);
+    return res;
+}